@@ -59,7 +59,7 @@ namespace barrett
 			Input<cp_type> OrnKdGains;
 
 			Input<cp_type> XdInput; // Xd - center of spring [xd , yd , zd ] commanded cart pos. : fixed for static spring
-			// Input<cv_type> commandedCvInput;   // commanded cart vel. : set to zero for now
+			Input<cv_type> XdDotInput; // commanded cart vel. : optional, zero when unconnected or undefined
 			Input<Eigen::Quaterniond> OrnReferenceInput;
 
 			// IO  (outputs)
@@ -81,7 +81,7 @@ namespace barrett
 			ImpedanceController6DOF(
 				const std::string &sysName = "ImpedanceController6DOF") : System(sysName), KinematicsInput<DOF>(this), CpInput(this), CvInput(this),
 																		  OrnReferenceInput(this), OrnInput(this), OrnKpGains(this), OrnKdGains(this),
-																		  KxInput(this), DxInput(this), XdInput(this),
+																		  KxInput(this), DxInput(this), XdInput(this), XdDotInput(this),
 																		  CFOutput(this, &cfOutputValue), CTOutput(this, &ctOutputValue)
 			{
 			}
@@ -95,6 +95,7 @@ namespace barrett
 			ct_type ct;
 
 			cp_type Xd;
+			cv_type XdDot;
 			cp_type Kx;
 			cp_type Dx;
 
@@ -118,6 +119,11 @@ namespace barrett
 				OrnCurr = OrnInput.getValue();    // current tool Orientation (quaternion)
 
 				Xd = XdInput.getValue(); // Xd : cartesian positional input to the system
+				if (XdDotInput.valueDefined()) {
+					XdDot = XdDotInput.getValue(); // XdDot : velocity feedforward of a moving Xd
+				} else {
+					XdDot.setZero();
+				}
 				Kx = KxInput.getValue(); // Kx : cartesian stiffness input to the system
 				Dx = DxInput.getValue(); // Dx : cartesian damping input to the system
 
@@ -127,7 +133,7 @@ namespace barrett
 
 				for (int i = 0; i < 3; i++)
 				{
-					cf[i] = (Xd[i] - Xcurr[i]) * Kx[i] + (0.0 - Vcurr[i]) * Dx[i];
+					cf[i] = (Xd[i] - Xcurr[i]) * Kx[i] + (XdDot[i] - Vcurr[i]) * Dx[i];
 				}
 				computedF = cf;
 				computedT = ct;
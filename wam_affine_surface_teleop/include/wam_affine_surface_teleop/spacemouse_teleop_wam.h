@@ -39,6 +39,8 @@
 // ROS headers
 #include "ros/ros.h"
 #include "std_srvs/Empty.h"
+#include "std_srvs/Trigger.h"
+#include "std_msgs/String.h"
 #include "sensor_msgs/Joy.h"
 #include "sensor_msgs/JointState.h"
 #include "geometry_msgs/PoseStamped.h"
@@ -70,12 +72,21 @@
 
 // Custom utility headers
 #include "impedence_controller.h"
-#include "static_force_estimator_withg.h"
-#include "get_jacobian_system.h"
+#include <wam_control_common/static_force_estimator_withg.h>
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/trajectory_streamer.h>
+#include <wam_control_common/trajectory_file.h>
+#include <wam_control_common/columnar_log.h>
+#include <wam_control_common/rt_trace.h>
+#include <wam_control_common/state_snapshot.h>
+#include <wam_control_common/operate_timing.h>
+#include <wam_control_common/cubic_bezier.h>
 
 // Constants
 static const int PUBLISH_FREQ = 500;
 static const double SPEED = 0.03;
+static const double OPERATE_TIMING_PERIOD = 1.0; // [s] between operate_timing summaries
+static const char FORCE_TRACE_PATH[] = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/joyToWamCalib/force_trace.txt"; // estimated contact force, see rt_trace.h
 
 // Using declarations
 using namespace barrett;
@@ -148,6 +159,7 @@ public:
     wam_msgs::MatrixMN wam_jacobian_mn;
     wam_msgs::RTToolInfo wam_tool_info;
     wam_msgs::RTCartForce force_msg;
+    std_msgs::String operate_timing_msg;
 
     // ROS publishers
     ros::Publisher wam_joint_state_pub;
@@ -155,6 +167,8 @@ public:
     ros::Publisher wam_jacobian_mn_pub;
     ros::Publisher wam_tool_pub;
     ros::Publisher wam_estimated_contact_force_pub;
+    ros::Publisher operate_timing_pub;
+    ros::Timer operate_timing_timer;
 
     // ROS services
     ros::ServiceServer disconnect_systems_srv;
@@ -163,22 +177,26 @@ public:
     ros::ServiceServer calibration_srv;
     ros::ServiceServer cp_impedance_control_srv;
     ros::ServiceServer contact_control_teleop_srv;
+    ros::ServiceServer operate_timing_srv;
+    ros::ServiceServer reset_operate_timing_srv;
+
+    // operate() timing of the systems below, see operate_timing.h
+    GraphTimer graphTimer;
 
     // Systems for contact force estimation
-    StaticForceEstimatorwithG<DOF> staticForceEstimator;
-    getJacobian<DOF> getWAMJacobian;
+    Timed<StaticForceEstimatorwithG<DOF> > staticForceEstimator;
+    Timed<KinematicsBundle<DOF> > kinematics;
     systems::GravityCompensator<DOF> gravityTerm;
-    std::ofstream outputFile;
-    systems::PrintToStream<cf_type> print;
+    Timed<RTTraceSink<cf_type> > forceTrace;
+    Timed<StateSnapshot<DOF> > stateSnapshot; // RT -> publishWam
 
     // Systems for impedance control
-    systems::ImpedanceController6DOF<DOF> ImpControl;
+    Timed<systems::ImpedanceController6DOF<DOF> > ImpControl;
     systems::ExposedOutput<cp_type> KxSet;
     systems::ExposedOutput<cp_type> DxSet;
-    systems::ExposedOutput<cp_type> XdSet;
     systems::ExposedOutput<cp_type> OrnKxSet;
     systems::ExposedOutput<cp_type> OrnDxSet;
-    systems::ExposedOutput<Eigen::Quaterniond> OrnXdSet;
+    Timed<TrajectoryStreamer<DOF> > refStreamer; // streams Xd and the orientation reference
     systems::ExposedOutput<cp_type> KthSet;
     systems::ExposedOutput<cf_type> FeedFwdForce;
     systems::ToolForceToJointTorques<DOF> toolforce2jt;
@@ -198,7 +216,7 @@ public:
 		jtSat(boost::bind(saturateJt<DOF>, _1, jtLimits)),
 		setting(pm.getConfig().lookup(pm.getWamDefaultConfigPath())),
 		gravityTerm(setting["gravity_compensation"]),
-		print(pm.getExecutionManager(), "Data: ", outputFile) {}
+		forceTrace(pm.getExecutionManager(), FORCE_TRACE_PATH, "Data: ") {}
 
 	~JoytoWAM() {}
 
@@ -221,6 +239,10 @@ public:
     void publishWam(ProductManager& pm);
     void disconnectSystems();
     bool disconnectSystems(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res);
+    bool operateTimingCallback(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
+    bool resetOperateTimingCallback(std_srvs::Empty::Request& req, std_srvs::Empty::Response& res);
+    void publishOperateTiming(const ros::TimerEvent& event);
+    std::string operateTimingReport();
     void goHome();
     void CartImpController(std::vector<cp_type>& Trajectory, int step = 1,
                            const cp_type& KpApplied = Eigen::Vector3d::Zero(),
@@ -228,10 +250,9 @@ public:
                            const cp_type& OrnKpApplied = Eigen::Vector3d::Zero(),
                            const cp_type& OrnKdApplied = Eigen::Vector3d::Zero(), bool ext_force = false,
                            const cf_type& des_force = Eigen::Vector3d::Zero(), bool null_space = false);
+    void CartImpApproach(const cp_type& target, double offset, const cp_type& KpApplied, const cp_type& KdApplied);
     bool contactControlTeleop(wam_srvs::ContactControlTeleop::Request& req,
                               wam_srvs::ContactControlTeleop::Response& res);
-    std::vector<units::CartesianPosition::type> generateCubicSplineWaypoints(
-        const units::CartesianPosition::type& initialPos, const units::CartesianPosition::type& finalPos, double offset);
     void updateRT(ProductManager& pm);
 };
 
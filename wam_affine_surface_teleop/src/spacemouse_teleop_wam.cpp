@@ -79,6 +79,8 @@ void JoytoWAM<DOF>::init(ProductManager& pm)
     calibration_srv = n_.advertiseService("calibration", &JoytoWAM<DOF>::calibration, this);
     disconnect_systems_srv = n_.advertiseService("disconnect_systems", &JoytoWAM::disconnectSystems, this);
     contact_control_teleop_srv = n_.advertiseService("contact_control_teleop", &JoytoWAM::contactControlTeleop, this);
+    operate_timing_srv = n_.advertiseService("operate_timing", &JoytoWAM::operateTimingCallback, this);
+    reset_operate_timing_srv = n_.advertiseService("reset_operate_timing", &JoytoWAM::resetOperateTimingCallback, this);
 
     // ROS publishers
     initPublisher<sensor_msgs::JointState>(wam_joint_state_pub, "joint_states", 1);
@@ -86,6 +88,8 @@ void JoytoWAM<DOF>::init(ProductManager& pm)
     initPublisher<wam_msgs::MatrixMN>(wam_jacobian_mn_pub, "jacobian", 1);
     initPublisher<wam_msgs::RTToolInfo>(wam_tool_pub, "tool_info", 1);
     initPublisher<wam_msgs::RTCartForce>(wam_estimated_contact_force_pub, "static_estimated_force", 1);
+    initPublisher<std_msgs::String>(operate_timing_pub, "operate_timing", 1);
+    operate_timing_timer = n_.createTimer(ros::Duration(OPERATE_TIMING_PERIOD), &JoytoWAM::publishOperateTiming, this);
 
     // ROS subscribers
     joy_sub_ = n_.subscribe("/spacenav/joy", 1, &JoytoWAM::joyCallback, this);
@@ -111,11 +115,12 @@ void JoytoWAM<DOF>::connectSystems()
     // Add initial connections here
     systems::forceConnect(KxSet.output, ImpControl.KxInput);
     systems::forceConnect(DxSet.output, ImpControl.DxInput);
-    systems::forceConnect(XdSet.output, ImpControl.XdInput);
+    systems::forceConnect(refStreamer.positionOutput, ImpControl.XdInput);
+    systems::forceConnect(refStreamer.velocityOutput, ImpControl.XdDotInput);
 
     systems::forceConnect(OrnKxSet.output, ImpControl.OrnKpGains);
     systems::forceConnect(OrnDxSet.output, ImpControl.OrnKdGains);
-    systems::forceConnect(OrnXdSet.output, ImpControl.OrnReferenceInput);
+    systems::forceConnect(refStreamer.orientationOutput, ImpControl.OrnReferenceInput);
 
     systems::forceConnect(wam.toolPosition.output, ImpControl.CpInput);
     systems::forceConnect(wam.toolVelocity.output, ImpControl.CvInput);
@@ -128,33 +133,57 @@ void JoytoWAM<DOF>::connectSystems()
     systems::forceConnect(ImpControl.CFOutput, toolforce2jt.input);
     systems::forceConnect(ImpControl.CTOutput, tt2jt_ortn_split.input);
     systems::forceConnect(FeedFwdForce.output, toolforcefeedfwd2jt.input);
+
+    // Contact force estimation
+    systems::connect(wam.kinematicsBase.kinOutput, kinematics.kinInput);
+    systems::connect(kinematics.output, staticForceEstimator.kinematicsInput);
+    systems::connect(wam.kinematicsBase.kinOutput, gravityTerm.kinInput);
+    systems::connect(gravityTerm.output, staticForceEstimator.g);
+    systems::connect(wam.jtSum.output, staticForceEstimator.jtInput);
+    systems::connect(staticForceEstimator.cartesianForceOutput, forceTrace.input);
+
+    // One coherent state sample per tick for publishWam
+    systems::connect(wam.jpOutput, stateSnapshot.jpInput);
+    systems::connect(wam.jvOutput, stateSnapshot.jvInput);
+    systems::connect(wam.jtSum.output, stateSnapshot.jtInput);
+    systems::connect(wam.toolOrientation.output, stateSnapshot.ornInput);
+    systems::connect(kinematics.output, stateSnapshot.kinematicsInput);
+    systems::connect(staticForceEstimator.cartesianForceOutput, stateSnapshot.cfInput);
+    mypm->getExecutionManager()->startManaging(stateSnapshot);
+
+    // Per-tick operate() durations of our systems, see operate_timing.h
+    mypm->getExecutionManager()->startManaging(graphTimer);
+    graphTimer.track(kinematics);
+    graphTimer.track(staticForceEstimator);
+    graphTimer.track(ImpControl);
+    graphTimer.track(refStreamer);
+    graphTimer.track(stateSnapshot);
+    graphTimer.track(forceTrace);
 }
 
 // Templated Surface Calibration Function
 template<size_t DOF>
 bool JoytoWAM<DOF>::calibration(wam_srvs::Teach::Request &req, wam_srvs::Teach::Response &res) {
     // Define constants and systems
-    const double T_s = mypm->getExecutionManager()->getPeriod();
     const int loggingRateMultiplier = 10;
     systems::Ramp time(mypm->getExecutionManager());
     systems::TupleGrouper<double, cp_type, jp_type> configLogTg;
 
-    // Create a temporary file for logging
-    char tmpFile[] = "/tmp/btXXXXXX";
-    if (mkstemp(tmpFile) == -1) {
-        ROS_ERROR("Couldn't create temporary file!");
-        return false;
-    }
-
     // Define file paths
     std::string path_trj = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/joyToWamCalib/" + req.path + "Trj";
     std::string path_pnts = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path + "Pts";
 
-    // Record at 1/10th of the loop rate
-    systems::PeriodicDataLogger<config_sample_type> configLogger(
-        mypm->getExecutionManager(),
-        new barrett::log::RealTimeWriter<config_sample_type>(tmpFile, loggingRateMultiplier * T_s),
-        loggingRateMultiplier);
+    // Record at 1/10th of the loop rate (the replay steps through every
+    // record), straight into the binary file the replay maps
+    const char* config_columns[] = {"t", "cp", "jp"};
+    Timed<ColumnarLogger<config_sample_type> > configLogger(
+        mypm->getExecutionManager(), path_trj + ".trj",
+        std::vector<std::string>(config_columns, config_columns + 3), loggingRateMultiplier, "ConfigLogger");
+    if (!configLogger.isLogging()) {
+        ROS_ERROR_STREAM("Couldn't create " << path_trj << ".trj");
+        return false;
+    }
+    graphTimer.track(configLogger);
 
     // Record the first point
     std::cout << "Move the robot to the first contact point and press [Enter]." << std::endl;
@@ -192,20 +221,12 @@ bool JoytoWAM<DOF>::calibration(wam_srvs::Teach::Request &req, wam_srvs::Teach::
     pts.col(2) = p3;
 
     // Close the logger
-    configLogger.closeLog();
     disconnect(configLogger.input);
-
-    std::ofstream outputFile(path_trj);
-    if (!outputFile.is_open()) {
-        printf("ERROR: Couldn't create the file!\n");
-        return false;
+    configLogger.closeLog();
+    if (configLogger.droppedRecords() > 0) {
+        ROS_WARN_STREAM("Dropped " << configLogger.droppedRecords() << " calibration samples");
     }
 
-    // Export data to CSV file
-    log::Reader<config_sample_type> lr(tmpFile);
-	lr.exportCSV(outputFile);
-    std::remove(tmpFile);
-
     // Write the matrix to the CSV file
     std::ofstream outputFile2(path_pnts);
     if (!outputFile2.is_open()) {
@@ -452,25 +473,16 @@ bool JoytoWAM<DOF>::contactControlTeleop(wam_srvs::ContactControlTeleop::Request
         //Extracting cartesian points from collected trajectory in calibration.
         std::string path_trj = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/joyToWamCalib/" + req.path + "Trj";
         std::string path_pnts = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path + "Pts";
-        std::ifstream inputFile(path_trj);
-        if (!inputFile.is_open()) {
-            perror("ERROR: Couldn't open temporary file for reading!");
-        }
-
-        std::vector<cp_sample_type> vec;
-        std::string line;
-        while (std::getline(inputFile, line)) {
-        std::istringstream iss(line);
-        cp_sample_type sample;
-        char comma;
-        iss >> sample.get<0>() >> comma >> sample.get<1>().x() >> comma >> sample.get<1>().y() >> comma >> sample.get<1>().z();
-        vec.push_back(sample);
+        // Map the binary copy; recordings that only have the CSV are converted once.
+        TrajectoryFile trj(path_trj + ".trj");
+        if (!trj.isOpen() && !(convertCSVToTrajectoryFile(path_trj, path_trj + ".trj") && trj.open(path_trj + ".trj"))) {
+            ROS_ERROR_STREAM("Couldn't load trajectory " << path_trj);
+            return false;
         }
 
-        // Extract cp_type values from vec
-        std::vector<cp_type> cp_trj;
-        for (const auto& record : vec) {
-            cp_trj.push_back(boost::get<1>(record));
+        std::vector<cp_type> cp_trj(trj.rows());
+        for (size_t i = 0; i < trj.rows(); ++i) {
+            cp_trj[i] = trj.positions().col(i);
         }
 
         std::ifstream inputFile2(path_pnts);
@@ -501,13 +513,12 @@ bool JoytoWAM<DOF>::contactControlTeleop(wam_srvs::ContactControlTeleop::Request
 
         std::cout<< "Press [Enter] to move to the initial point on the table."<<std::endl;
         waitForEnter();
-        
-        std::vector<cp_type>  p1_trj = generateCubicSplineWaypoints(wam.getToolPosition(), p1, 0.0);
+
         //Impedance Control params
         cp_type KpApplied, KdApplied;
         KpApplied << 100, 100, 100;
         KdApplied << 20, 20, 20;
-        CartImpController(p1_trj, 1, KpApplied, KdApplied);
+        CartImpApproach(p1, 0.0, KpApplied, KdApplied);
 
         std::cout<< "Press [Enter] to move to replay the base vectors."<<std::endl;
         waitForEnter();
@@ -547,126 +558,95 @@ void JoytoWAM<DOF>::CartImpController(std::vector<cp_type> &Trajectory, int step
     /* tau_nullspace << (Eigen::MatrixXd::Identity(7, 7) - this->jacobian_.transpose() * jacobian_transpose_pinv) *
                          (this->nullspace_stiffness_ * (this->q_d_nullspace_ - this->q_) - this->nullspace_damping_ * this->dq_);*/
 
-    // SATURATE AND CONNECT TO WAM INPUT
-    systems::forceConnect(torqueSum.output, jtSat.input);        
-    systems::forceConnect(jtSat.output, wam.input); 
+    // Hold the current pose, queue the whole trajectory and let the streamer
+    // interpolate it every control tick.
+    refStreamer.hold(wam.getToolPosition(), wam.getToolOrientation());
 
-    cp_type waypoint;
+    std::vector<cp_type> waypoints;
+    typename TrajectoryStreamer<DOF>::quaternion_vector rotation_waypoints;
+    Eigen::Matrix3d Rotation_des;
+    for (int i = 0; i<Trajectory.size(); i+=step) {
+        waypoints.push_back(Trajectory[i]);
+    }
     if(orientation_control){
-        Eigen::Matrix3d Rotation;
-        for (int i = 0; i<Trajectory.size(); i+=step) {
-            // Find the desired rotation
-            Rotation = wam.getToolOrientation().toRotationMatrix();
-            Rotation.col(2) << surface_normal;
-            
-            // Ensure the resulting matrix is still a valid rotation matrix
-            Eigen::JacobiSVD<Eigen::MatrixXd> svd(Rotation, Eigen::ComputeFullU | Eigen::ComputeFullV);
-            Eigen::Matrix3d Rotation_des = svd.matrixU() * svd.matrixV().transpose();
-
-            // Check if the determinant is 1 to ensure it's a rotation matrix
-            if (Rotation_des.determinant() < 0) {
-                // If the determinant is -1, flip the sign of one of the singular vectors
-                Eigen::Matrix3d flipMatrix = Eigen::Matrix3d::Identity();
-                flipMatrix(2, 2) = -1;
-                Rotation_des = svd.matrixU() * flipMatrix * svd.matrixV().transpose();
-            }
+        // Find the desired rotation
+        Eigen::Matrix3d Rotation = wam.getToolOrientation().toRotationMatrix();
+        Rotation.col(2) << surface_normal;
+
+        // Ensure the resulting matrix is still a valid rotation matrix
+        Eigen::JacobiSVD<Eigen::MatrixXd> svd(Rotation, Eigen::ComputeFullU | Eigen::ComputeFullV);
+        Rotation_des = svd.matrixU() * svd.matrixV().transpose();
+
+        // Check if the determinant is 1 to ensure it's a rotation matrix
+        if (Rotation_des.determinant() < 0) {
+            // If the determinant is -1, flip the sign of one of the singular vectors
+            Eigen::Matrix3d flipMatrix = Eigen::Matrix3d::Identity();
+            flipMatrix(2, 2) = -1;
+            Rotation_des = svd.matrixU() * flipMatrix * svd.matrixV().transpose();
+        }
+        std::cout << "Rotation_des:" << Rotation_des << std::endl;
 
-            // Convert Quaternion to Rotation Matrix
-            std::cout << "Rotation_des:" << Rotation_des << std::endl;
-            Eigen::Quaterniond quaternion_des(Rotation_des);
-            OrnXdSet.setValue(quaternion_des);
-            
-            // Move to the waypoint
-            waypoint = Trajectory[i];
-            std::cout<<i<<std::endl;
-            XdSet.setValue(waypoint);
-            btsleep(0.5);
-
-            cp_type e = (waypoint - wam.getToolPosition())/(waypoint.norm());
-            
-            cp_type euler_angles = wam.getToolOrientation().toRotationMatrix().eulerAngles(2, 1, 0);
-            cp_type euler_angles_d = Rotation_des.eulerAngles(2, 1, 0);
-            cp_type Orne = (euler_angles_d - euler_angles)/(euler_angles_d.norm());
-            
-            if(e.norm() > 0.03) {std::cout<<"position error: %"<<e*100<<std::endl;}   
-            if(Orne.norm() > 0.03) {std::cout << "orientation error(zyx):"<<Orne* 180.0 / M_PI<< std::endl;}
+        // Rotate towards it along the trajectory instead of stepping at the first waypoint
+        Eigen::Quaterniond quaternion_des(Rotation_des);
+        Eigen::Quaterniond quaternion_cur = wam.getToolOrientation();
+        for (size_t i = 0; i < waypoints.size(); ++i) {
+            rotation_waypoints.push_back(quaternion_cur.slerp(double(i + 1) / waypoints.size(), quaternion_des));
         }
     }
-    else{
-        OrnXdSet.setValue(wam.getToolOrientation());
-        for (int i = 0; i<Trajectory.size(); i+=step) {
-            // Move to the waypoint
-            waypoint = Trajectory[i];
-            XdSet.setValue(waypoint);
-            btsleep(0.3);
-            cp_type e = (waypoint - wam.getToolPosition())/(waypoint.norm());
-            if(e.norm() > 0.03) {std::cout<<e<<std::endl;}   
-        }
+    if (waypoints.empty() || !refStreamer.enqueue(waypoints, rotation_waypoints, SPEED)) {
+        ROS_WARN("CartImpController: could not queue %zu waypoints.", waypoints.size());
+        return;
     }
-    systems::disconnect(torqueSum.output);    
-}
 
-// Function to generate waypoints along a Cubic Bezier curve and move to them
-template <size_t DOF>
-std::vector<units::CartesianPosition::type> JoytoWAM<DOF>::generateCubicSplineWaypoints(
-    const units::CartesianPosition::type& initialPos,
-    const units::CartesianPosition::type& finalPos,
-    double offset
-) {
-    BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
-    std::vector<units::CartesianPosition::type> waypoints;
-
-    Eigen::Vector3d deltaPos = finalPos - initialPos;
-    double totalDistance = deltaPos.norm();
+    // SATURATE AND CONNECT TO WAM INPUT
+    systems::forceConnect(torqueSum.output, jtSat.input);        
+    systems::forceConnect(jtSat.output, wam.input); 
 
-    // Calculate intermediate positions by offsetting x, y, and z
-    Eigen::Vector3d yeeb = initialPos + deltaPos * offset;
-    Eigen::Vector3d goalb = finalPos - deltaPos * offset;
+    refStreamer.waitForCompletion();
 
-    // Bezier interpolation
-    int numPop = 100;
-    std::vector<Eigen::Vector3d> plPop;
-    for (int i = 0; i < numPop; ++i) {
-        double t = static_cast<double>(i) / (numPop - 1);
-        Eigen::Vector3d pl = (1 - t) * (1 - t) * (1 - t) * initialPos +
-                             3 * (1 - t) * (1 - t) * t * yeeb +
-                             3 * (1 - t) * t * t * goalb +
-                             t * t * t * finalPos;
-        plPop.push_back(pl);
+    cp_type e = (waypoints.back() - wam.getToolPosition())/(waypoints.back().norm());
+    if(e.norm() > 0.03) {std::cout<<"position error: %"<<e*100<<std::endl;}
+    if(orientation_control){
+        cp_type euler_angles = wam.getToolOrientation().toRotationMatrix().eulerAngles(2, 1, 0);
+        cp_type euler_angles_d = Rotation_des.eulerAngles(2, 1, 0);
+        cp_type Orne = (euler_angles_d - euler_angles)/(euler_angles_d.norm());
+        if(Orne.norm() > 0.03) {std::cout << "orientation error(zyx):"<<Orne* 180.0 / M_PI<< std::endl;}
     }
+    systems::disconnect(torqueSum.output);    
+}
 
-    // Calculate the subset of points to sample
-    int steps = 20;
-    double squish = 2.0;
-    std::vector<double> midArr;
-    for (double t = -squish; t <= squish; t += squish / (steps - 1)) {
-        midArr.push_back(static_cast<double>(numPop) / (1 + std::exp(-t)));
-    }
+// Impedance-controlled move along CubicBezier::between(tool, target, offset),
+// sampled by refStreamer every tick. The orientation reference stays at the
+// current tool orientation.
+template<size_t DOF>
+void JoytoWAM<DOF>::CartImpApproach(const cp_type &target, double offset, const cp_type &KpApplied, const cp_type &KdApplied){
+    //Impedance Control params
+    KxSet.setValue(KpApplied);
+    DxSet.setValue(KdApplied);
+    OrnKxSet.setValue(cp_type(0.0));
+    OrnDxSet.setValue(cp_type(0.0));
 
-    double minMidArr = *std::min_element(midArr.begin(), midArr.end());
-    double maxMidArr = *std::max_element(midArr.begin(), midArr.end());
-    double m = (numPop - 1) / (maxMidArr - minMidArr);
+    // CONNECT TO SUMMER
+    systems::forceConnect(toolforce2jt.output, torqueSum.getInput(0));
+    systems::forceConnect(tt2jt_ortn_split.output, torqueSum.getInput(1));
 
-    std::vector<int> iArr;
-    for (double t : midArr) {
-        int index = static_cast<int>(m * (t - minMidArr));
-        iArr.push_back(index);
+    const cp_type start = wam.getToolPosition();
+    const Eigen::Quaterniond orn = wam.getToolOrientation();
+    refStreamer.hold(start, orn);
+    if (!refStreamer.enqueue(CubicBezier::between(start, target, offset), orn, SPEED)) {
+        ROS_WARN("CartImpApproach: could not start the approach.");
+        return;
     }
 
-    iArr[0] = 0;
-    iArr.back() = numPop - 1;
-
-    // List of points as a sample of bezier
-    std::vector<units::CartesianPosition::type> pl;
-    for (int index : iArr) {
-        pl.push_back(cp_type(plPop[index]));
-    }
+    // SATURATE AND CONNECT TO WAM INPUT
+    systems::forceConnect(torqueSum.output, jtSat.input);
+    systems::forceConnect(jtSat.output, wam.input);
 
-    for (const auto& waypoint : pl) {
-        waypoints.push_back(waypoint);
-    }
+    refStreamer.waitForCompletion();
 
-    return waypoints;
+    cp_type e = (target - wam.getToolPosition())/(target.norm());
+    if(e.norm() > 0.03) {std::cout<<"position error: %"<<e*100<<std::endl;}
+    systems::disconnect(torqueSum.output);
 }
 
 template<size_t DOF>
@@ -738,38 +718,67 @@ bool JoytoWAM<DOF>::jointMoveBlockCallback(wam_srvs::JointMoveBlock::Request &re
     return true;
 }
 
+//operate() timing summary, see operate_timing.h
+template<size_t DOF>
+bool JoytoWAM<DOF>::operateTimingCallback(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
+{
+    res.message = operateTimingReport();
+    res.success = true;
+    return true;
+}
+
+template<size_t DOF>
+bool JoytoWAM<DOF>::resetOperateTimingCallback(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res)
+{
+    graphTimer.reset();
+    return true;
+}
+
+template<size_t DOF>
+void JoytoWAM<DOF>::publishOperateTiming(const ros::TimerEvent& event)
+{
+    operate_timing_msg.data = operateTimingReport();
+    operate_timing_pub.publish(operate_timing_msg);
+}
+
+//graphTimer's table and the force trace's record counts
+template<size_t DOF>
+std::string JoytoWAM<DOF>::operateTimingReport()
+{
+    char line[128];
+    snprintf(line, sizeof(line), "force trace: %llu written, %llu dropped\n",
+             static_cast<unsigned long long>(forceTrace.writtenRecords()), static_cast<unsigned long long>(forceTrace.droppedRecords()));
+    return graphTimer.report() + line;
+}
+
 //Function to update the WAM publisher
 template<size_t DOF>
 void JoytoWAM<DOF>::publishWam(ProductManager& pm)
-{   //Current values to be published
-    jp_type jp = wam.getJointPositions();
-    jt_type jt = wam.getJointTorques();
-    jv_type jv = wam.getJointVelocities();
-    cp_type cp_pub = wam.getToolPosition();
-    Eigen::Quaterniond to_pub = wam.getToolOrientation();
-    math::Matrix<6,DOF> robot_tool_jacobian=wam.getToolJacobian();
-
-    cv_type cv_pub = wam.getToolVelocity();
-    cv_type cv_ang = wam.getToolAngularVelocity();
+{   //Current values to be published, all from the same control tick
+    const typename StateSnapshot<DOF>::state_type& state = stateSnapshot.latest();
+    if (state.tick == 0) {
+        return; // nothing sampled yet
+    }
+    const ros::Time stamp = ros::Time::now();
 
     //publishing sensor_msgs/JointState to wam/joint_states
     for (size_t i = 0; i < DOF; i++) {
-        wam_joint_state.position[i] = jp[i];
-        wam_joint_state.velocity[i] = jv[i];
-        wam_joint_state.effort[i] = jt[i];
+        wam_joint_state.position[i] = state.jp[i];
+        wam_joint_state.velocity[i] = state.jv[i];
+        wam_joint_state.effort[i] = state.jt[i];
     }
-    wam_joint_state.header.stamp = ros::Time::now();
+    wam_joint_state.header.stamp = stamp;
     wam_joint_state_pub.publish(wam_joint_state);
 
     //publishing geometry_msgs/PoseStamed to wam/pose
-    wam_pose.header.stamp = ros::Time::now();
-    wam_pose.pose.position.x = cp_pub[0];
-    wam_pose.pose.position.y = cp_pub[1];
-    wam_pose.pose.position.z = cp_pub[2];
-    wam_pose.pose.orientation.w = to_pub.w();
-    wam_pose.pose.orientation.x = to_pub.x();
-    wam_pose.pose.orientation.y = to_pub.y();
-    wam_pose.pose.orientation.z = to_pub.z();
+    wam_pose.header.stamp = stamp;
+    wam_pose.pose.position.x = state.cp[0];
+    wam_pose.pose.position.y = state.cp[1];
+    wam_pose.pose.position.z = state.cp[2];
+    wam_pose.pose.orientation.w = state.orn.w();
+    wam_pose.pose.orientation.x = state.orn.x();
+    wam_pose.pose.orientation.y = state.orn.y();
+    wam_pose.pose.orientation.z = state.orn.z();
     wam_pose_pub.publish(wam_pose);
 
     //publishing wam_msgs/MatrixMN to wam/jacobian
@@ -777,26 +786,26 @@ void JoytoWAM<DOF>::publishWam(ProductManager& pm)
     wam_jacobian_mn.n = DOF;
     for (size_t h = 0; h < wam_jacobian_mn.n; ++h) {
         for (size_t k = 0; k < wam_jacobian_mn.m; ++k) {
-            wam_jacobian_mn.data[h*6+k]=robot_tool_jacobian(k,h);
+            wam_jacobian_mn.data[h*6+k]=state.J(k,h);
         }
     }
     wam_jacobian_mn_pub.publish(wam_jacobian_mn);
 
     //publish tool info to /wam/tool_info
     for (size_t j = 0; j < 3; j++) {
-        wam_tool_info.position[j] = cp_pub[j];
-        wam_tool_info.velocity[j] = cv_pub[j];
+        wam_tool_info.position[j] = state.cp[j];
+        wam_tool_info.velocity[j] = state.cv[j];
     }
     wam_tool_pub.publish(wam_tool_info);
 
     //publish static force estimation to /wam/static_estimated_force
-    force_msg.force[0] = staticForceEstimator.computedF[0];
-    force_msg.force[1] = staticForceEstimator.computedF[1];
-    force_msg.force[2] = staticForceEstimator.computedF[2];
-    force_msg.force_norm = staticForceEstimator.computedF.norm(); //N in base frame
-    if(staticForceEstimator.computedF.norm() > 14.0){ROS_INFO("Contact detected.");} 
-    if(staticForceEstimator.computedF.norm() > 0.0){
-        force_norm = staticForceEstimator.computedF;
+    force_msg.force[0] = state.cf[0];
+    force_msg.force[1] = state.cf[1];
+    force_msg.force[2] = state.cf[2];
+    force_msg.force_norm = state.cf.norm(); //N in base frame
+    if(state.cf.norm() > 14.0){ROS_INFO("Contact detected.");} 
+    if(state.cf.norm() > 0.0){
+        force_norm = state.cf;
         force_norm.normalize();
         force_msg.force_dir[0] = force_norm[0];
         force_msg.force_dir[1] = force_norm[1];
@@ -1,339 +0,0 @@
-/*
-* C_4D.hpp
-*
-*  Created on: 31-Jan-2015
-*      Author: nilxwam
-*/
-
-#ifndef C_4D_HPP_
-#define C_4D_HPP_
-
-//#include <eigen2/Eigen/Core>
-#include <eigen3/Eigen/Core>
-#include <math.h>
-
-Eigen::Vector4d C_4D(const Eigen::Vector4d x, const Eigen::Vector4d y) /* x denoted the four joint positions ,  y denoted the four joint velocities */
-{
-
-Eigen::Vector4d C;
-
-C[0] = (y[0]*y[1]*sin(2*x[1]))/2;
-C[1] = - (y[0]*y[0]*sin(2*x[1]))/5 - (y[1]*y[3]*sin(x[3]))/10;
-C[2] = 0;
-C[3] = 0;
-//C[0] = ((((y[1] * (y[2] * ((((((((((((((((((0.01 * sin(x[1] + 2.0 * x[2]) -
-//0.001 * cos(x[1] + 2.0 * x[3])) - 0.003 * cos((x[1] - 2.0 * x[2]) + x[3])) +
-//0.008 * sin(x[1] + 2.0 * x[3])) + 0.003 * cos((x[1] - 2.0 * x[2]) - x[3])) -
-//0.004 * sin((x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 *
-//x[2]) - 2.0 * x[3])) + 0.006 * cos(x[1] + x[3])) + 0.001 * sin(x[1] + x[3]))
-//- 0.003 * cos((x[1] + 2.0 * x[2]) + x[3])) - 0.006 * cos(x[1] - x[3])) +
-//0.001 * cos(x[1] - 2.0 * x[3])) + 0.01 * sin(x[1] - 2.0 * x[2])) + 0.001 *
-//sin(x[1] - x[3])) + 0.008 * sin(x[1] - 2.0 * x[3])) + 0.003 * cos((x[1] +
-//2.0 * x[2]) - x[3])) - 0.026 * sin(x[1])) - 0.004 * sin((x[1] + 2.0 * x[2])
-//- 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 * x[2]) + 2.0 * x[3])) - y[3] *
-//(((((((((((((((((((((0.003 * cos((x[1] + x[2]) + x[3]) -
-//0.003 * cos((x[1] + x[2]) - x[3])) - 0.003 * cos((x[1] - x[2]) + x[3])) +
-//0.001 * cos((x[1] + x[2]) - 2.0 * x[3])) - 0.001 * cos((x[1] - 2.0 * x[2]) +
-//x[3])) + 0.008 * sin((x[1] + x[2]) - 2.0 * x[3])) + 0.003 * cos((x[1] - x[2])
-//- x[3])) - 0.001 * cos((x[1] - x[2]) - 2.0 * x[3])) - 0.001 * cos((x[1] -
-//2.0 * x[2]) - x[3])) - 0.008 * sin((x[1] - x[2]) - 2.0 * x[3])) + 0.004 *
-//sin((x[1] + 2.0 * x[2]) + 2.0 * x[3])) + 0.004 * sin((x[1] - 2.0 * x[2]) -
-//2.0 * x[3])) - 0.02 * sin(x[1] + x[2])) - 0.001 * cos((x[1] + x[2]) + 2.0 *
-//x[3])) + 0.001 * cos((x[1] + 2.0 * x[2]) + x[3])) + 0.008 * sin((x[1] + x[2])
-//+ 2.0 * x[3])) + 0.02 * sin(x[1] - x[2])) + 0.001 * cos((x[1] + 2.0 * x[2])
-//- x[3])) + 0.001 * cos((x[1] - x[2]) + 2.0 * x[3])) - 0.008 * sin((x[1] - x
-//[2]) + 2.0 * x[3])) - 0.004 * sin((x[1] + 2.0 * x[2]) - 2.0 * x[3])) - 0.004
-//* sin((x[1] - 2.0 * x[2]) + 2.0 * x[3]))) - y[2] * y[2] *
-//(((((((((((((0.003 * cos((x[1] + x[2]) + x[3]) - 0.02 * sin((x[1] +
-//x[2]) + x[3])) + 0.003 * cos((x[1] + x[2]) - x[3])) - 0.003 * cos((x[1] - x
-//[2]) + x[3])) + 0.02 * sin((x[1] + x[2]) - x[3])) + 0.02 * sin((x[1] - x[2])
-//+ x[3])) + 0.004 * sin((x[1] + x[2]) - 2.0 * x[3])) - 0.003 * cos((x[1] - x
-//[2]) - x[3])) - 0.02 * sin((x[1] - x[2]) - x[3])) - 0.004 * sin((x[1] - x[2])
-//- 2.0 * x[3])) - 0.014 * cos(x[1] + x[2])) + 0.014 * cos(x[1] - x[2])) -
-//0.004 * sin((x[1] + x[2]) + 2.0 * x[3])) + 0.004 * sin((x[1] - x
-//[2]) + 2.0 * x[3]))) - y[3] * y[3] * (((((((0.006 * cos((x[1] + x[2]) + x[3])
-//- 0.019 * sin((x[1] + x[2]) + x[3])) + 0.006 * cos((x[1] + x[2]) - x[3])) -
-//0.006 * cos((x[1] - x[2]) + x[3])) + 0.019 * sin((x[1] + x[2]) - x[3])) +
-//0.019 * sin((x[1] - x[2]) + x[3])) - 0.006 * cos((x[1] - x[2]) - x[3])) -
-//0.019 * sin((x[1] - x[2]) - x[3]))) - y[1] * y[1] *
-//((((((((((((((((((((((((0.02 * sin((x[1] + x[2]) + x[3]) - 0.003 *
-//cos((x[1] + x[2]) + x[3])) - 0.003 * cos((x[1] + x[2]) - x[3])) + 0.003 *
-//cos((x[1] - x[2]) + x[3])) - 0.001 * cos((x[1] - 2.0 * x[2]) + x[3])) - 0.02
-//* sin((x[1] + x[2]) - x[3])) - 0.02 * sin((x[1] - x[2]) + x[3])) - 0.004 *
-//sin((x[1] + x[2]) - 2.0 * x[3])) - 0.005 * sin(x[1] + 2.0 * x[2])) + 0.003 *
-//cos((x[1] - x[2]) - x[3])) + 0.001 * cos((x[1] - 2.0 * x[2]) - x[3])) + 0.02
-//* sin((x[1] - x[2]) - x[3])) + 0.004 * sin((x[1] - x[2]) - 2.0 * x[3])) +
-//0.002 * sin((x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.002 *
-//sin((x[1] - 2.0 * x[2]) - 2.0 * x[3])) + 0.014 * cos(x[1]
-//+ x[2])) + 0.001 * cos((x[1] + 2.0 * x[2]) + x[3])) - 0.014 * cos(x[1] - x[2]))
-//+ 0.004 * sin((x[1] + x[2]) + 2.0 * x[3])) + 0.005 * sin(x[1]
-//- 2.0 * x[2])) - 0.001 * cos((x[1] + 2.0 * x[2]) - x[3])) + 0.002 * sin(x[1]))
-//- 0.004 * sin((x[1] - x[2]) + 2.0 * x[3])) + 0.002 * sin((x[1] +
-//2.0 * x[2]) - 2.0 * x[3])) - 0.002 * sin((x[1] - 2.0 * x[2]) + 2.0 * x[3])))
-//+ y[0] * ((y[3] * (((((((((((((((((((((((((((((((((((0.02 * sin((2.0 *
-//x[1] - x[2]) - x[3]) + 0.008 * sin((2.0 * x[1] - x[2]) - 2.0 * x[3])) +
-//0.002 * sin((2.0 * x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.002 * sin((2.0 * x
-//[1] - 2.0 * x[2]) - 2.0 * x[3])) - 0.008 * cos(2.0 * x[1] + x[3])) - 0.001 *
-//cos(2.0 * x[2] + x[3])) + 0.041 * sin(2.0 * x[1] + x[3])) - 0.001 * cos((2.0
-//* x[1] + x[2]) + 2.0 * x[3])) - 0.008 * cos(2.0 * x[1] - x[3])) - 0.002 *
-//cos(2.0 * x[1] - 2.0 * x[3])) - 0.001 * cos(2.0 * x[2] - x[3])) + 0.008 *
-//sin((2.0 * x[1] + x[2]) + 2.0 * x[3])) - 0.041 * sin(2.0 * x[1] - x[3])) -
-//0.013 * sin(2.0 * x[1] - 2.0 * x[3])) + 0.004 * sin(2.0 * x[2] - 2.0 * x[3]))
-//- 0.001 * cos(2.0 * x[3])) - 0.001 * cos((2.0 * x[1] - x[2]) + 2.0 * x[3]))
-//+ 0.008 * sin(2.0 * x[3])) + 0.008 * sin((2.0 * x[1] - x[2]) + 2.0 * x[3]))
-//- 0.002 * sin((2.0 * x[1] + 2.0 * x[2]) - 2.0 * x[3])) + 0.002 * sin((2.0 *
-//x[1] - 2.0 * x[2]) + 2.0 * x[3])) - 0.003 * cos((2.0 * x[1] + x[2]) + x[3]))
-//+ 0.02 * sin((2.0 * x[1] + x[2]) + x[3])) + 0.029 * cos(x[3])) + 0.003 * cos
-//((2.0 * x[1] + x[2]) - x[3])) - 0.003 * cos((2.0 * x[1]
-//- x[2]) + x[3])) + 0.001 * cos((2.0 * x[1] + x[2]) - 2.0 * x[3])) - 0.002 *
-//cos(2.0 * x[1] + 2.0 * x[3])) - 0.079 * sin(x[3])) + 0.02 * sin((2.0 * x[1]
-//+ x[2]) - x[3])) + 0.02 * sin((2.0 * x[1] - x[2]) + x[3])) + 0.008 * sin
-//((2.0 * x[1] + x[2]) - 2.0 * x[3])) + 0.013 * sin(2.0 * x[1] + 2.0 * x[3]))
-//- 0.004 * sin(2.0 * x[2] + 2.0 * x[3])) + 0.003 * cos((2.0 * x[1] - x[2]) -
-//x[3])) + 0.001 * cos((2.0 * x[1] - x[2]) - 2.0 * x[3])) - y[2] *
-//((((((((((((((((((((((((((((0.002 * sin((2.0 * x[1] - 2.0 *
-//x[2]) - 2.0 * x[3]) - 0.004 * sin((2.0 * x[1] - x[2]) - 2.0 * x[3])) - 0.002
-//* sin((2.0 * x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.02 * sin((2.0 * x[1] - x
-//[2]) - x[3])) - 0.014 * cos(2.0 * x[1] + x[2])) + 0.003 * cos(2.0 * x[2] +
-//x[3])) - 0.001 * cos((2.0 * x[1] + 2.0 * x[2]) + x[3])) + 0.014 * cos(2.0 *
-//x[1] - x[2])) - 0.003 * cos(2.0 * x[2] - x[3])) - 0.004 * sin((2.0 * x[1] +
-//x[2]) + 2.0 * x[3])) - 0.005 * sin(2.0 * x[1] - 2.0 * x[2])) + 0.004 * sin
-//(2.0 * x[2] - 2.0 * x[3])) + 0.001 * cos((2.0 * x[1] + 2.0 * x[2]) - x[3]))
-//- 0.01 * sin(2.0 * x[2])) + 0.004 * sin((2.0 * x[1] - x[2]) + 2.0 * x[3])) -
-//0.002 * sin((2.0 * x[1] + 2.0 * x[2]) - 2.0 * x[3])) + 0.002 * sin((2.0 * x
-//[1] - 2.0 * x[2]) + 2.0 * x[3])) + 0.003 * cos((2.0 * x[1] + x[2]) + x[3]))
-//- 0.02 * sin((2.0 * x[1] + x[2]) + x[3])) + 0.003 * cos((2.0 * x[1] + x[2])
-//- x[3])) - 0.003 * cos((2.0 * x[1] - x[2]) + x[3])) + 0.001 * cos((2.0 * x[1]
-//- 2.0 * x[2]) + x[3])) + 0.02 * sin((2.0 * x[1] + x[2]) - x[3])) + 0.02 *
-//sin((2.0 * x[1] - x[2]) + x[3])) + 0.004 * sin((2.0 * x[1] + x[2]) - 2.0 *
-//x[3])) + 0.005 * sin(2.0 * x[1] + 2.0 * x[2])) + 0.004 * sin(2.0 * x[2] +
-//2.0 * x[3])) - 0.003 * cos((2.0 * x[1] - x[2]) - x[3])) - 0.001 * cos((2.0 *
-//x[1] - 2.0 * x[2]) - x[3]))) + y[1] *
-//((((((((((((((((((((((((((((((((((((0.002 * sin((2.0 * x[1]
-//+ 2.0 * x[2]) + 2.0 * x[3]) - 0.008 * sin((2.0 * x[1] - x[2]) - 2.0 * x[3]))
-//- 0.041 * sin((2.0 * x[1] - x[2]) - x[3])) + 0.002 * sin((2.0 * x[1] - 2.0 *
-//x[2]) - 2.0 * x[3])) + 0.028 * cos(2.0 * x[1] + x[2])) - 0.016 * cos(2.0 *
-//x[1] + x[3])) + 0.082 * sin(2.0 * x[1] + x[3])) - 0.001 * cos((2.0 * x[1] +
-//x[2]) + 2.0 * x[3])) + 0.001 * cos((2.0 * x[1] + 2.0 * x[2]) + x[3])) +
-//0.028 * cos(2.0 * x[1] - x[2])) + 0.016 * cos(2.0 * x[1] - x[3])) + 0.002 *
-//cos(2.0 * x[1] - 2.0 * x[3])) + 0.008 * sin((2.0 * x[1] + x[2]) + 2.0 * x[3]))
-//- 0.005 * sin(2.0 * x[1] - 2.0 * x[2])) + 0.082 * sin(2.0 * x[1] - x[3])) +
-//0.013 * sin(2.0 * x[1] - 2.0 * x[3])) - 0.001 * cos((2.0 * x[1] + 2.0 * x[2])
-//- x[3])) - 0.001 * cos((2.0 * x[1] - x[2]) + 2.0 * x[3])) + 0.589 * sin(2.0 *
-//x[1])) + 0.008 * sin((2.0 * x[1] - x[2]) + 2.0 * x[3])) + 0.002 * sin((2.0 *
-//x[1] + 2.0 * x[2]) - 2.0 * x[3])) + 0.002 * sin((2.0 * x[1] - 2.0 * x[2]) +
-//2.0 * x[3])) - 0.006 * cos((2.0 * x[1] + x[2]) + x[3])) + 0.041 * sin((2.0 *
-//x[1] + x[2]) + x[3])) - 0.006 * cos((2.0 * x[1] + x[2]) - x[3])) - 0.006 *
-//cos((2.0 * x[1] - x[2]) + x[3])) - 0.001 * cos((2.0 * x[1] + x[2]) - 2.0 *
-//x[3])) + 0.001 * cos((2.0 * x[1] - 2.0 * x[2]) + x[3])) - 0.002 * cos(2.0 *
-//x[1] + 2.0 * x[3])) - 0.041 * sin((2.0 * x[1] + x[2]) - x[3])) + 0.041 * sin
-//((2.0 * x[1] - x[2]) + x[3])) - 0.008 * sin((2.0 * x[1] + x[2])
-//- 2.0 * x[3])) - 0.005 * sin(2.0 * x[1] + 2.0 * x[2])) + 0.013 * sin(2.0 *
-//x[1] + 2.0 * x[3])) - 0.006 * cos((2.0 * x[1] - x[2]) - x[3])) - 0.001 * cos
-//((2.0 * x[1] - x[2]) - 2.0 * x[3])) - 0.001 * cos((2.0 *
-//x[1] - 2.0 * x[2]) - x[3])))) + y[2] * y[3] *
-//(((((((((((((((((((((((((0.04 * sin((x[1] + x[2]) + x[3]) - 0.009 * cos((x[1]
-//+ x[2]) + x[3])) + 0.009 * cos((x[1] + x[2]) - x[3])) - 0.009 * cos((x[1] -
-//x[2]) + x[3])) + 0.001 * cos((x[1] + x[2]) - 2.0 * x[3])) - 0.003 * cos(x[1]
-//+ 2.0 * x[3])) + 0.04 * sin((x[1] + x[2]) - x[3])) + 0.04 * sin((x[1] - x[2])
-//+ x[3])) + 0.008 * sin((x[1] + x[2]) - 2.0 * x[3])) + 0.017 * sin(x[1] + 2.0
-//* x[3])) + 0.009 * cos((x[1] - x[2]) - x[3])) + 0.001 * cos((x[1] - x[2]) -
-//2.0 * x[3])) + 0.04 * sin((x[1] - x[2]) - x[3])) + 0.008 * sin((x[1] - x[2])
-//- 2.0 * x[3])) + 0.006 * cos(x[1] + x[3])) + 0.02 * sin(x[1] + x[2])) +
-//0.001 * sin(x[1] + x[3])) - 0.001 * cos((x[1] + x[2]) + 2.0 * x[3]))
-//+ 0.006 * cos(x[1] - x[3])) - 0.003 * cos(x[1] - 2.0 * x[3])) +
-//0.008 * sin((x[1] + x[2]) + 2.0 * x[3])) + 0.02 * sin(x[1] - x[2])) -
-//0.001 * sin(x[1] - x[3])) - 0.017 * sin(x[1] - 2.0 * x[3])) - 0.001 *
-//cos((x[1] - x[2]) + 2.0 * x[3])) + 0.008 * sin((x[1] - x[2]) + 2.0 * x[3]));
-//
-//
-//C[1] = ((((y[2] * y[2] * ((((((((0.001 * cos(x[2] + 2.0 * x[3]) - 0.008 * sin
-//(x[2] + 2.0 * x[3])) + 0.006 * cos(x[2] + x[3])) - 0.041 * sin(x[2] + x[3]))
-//+ 0.006 * cos(x[2] - x[3])) + 0.001 * cos(x[2] - 2.0 * x[3])) + 0.041 * sin
-//(x[2] - x[3])) + 0.008 * sin(x[2] - 2.0 * x[3])) - 0.028 * cos(x[2])) + y[0]
-//* (y[3] * (((((((((((((((((((((((((0.009 * cos((x[1] + x[2]) + x[3])
-//- 0.04 * sin((x[1] + x[2]) + x[3])) - 0.009 * cos((x[1] + x[2]) - x[3])) -
-//0.009 * cos((x[1] - x[2]) + x[3])) - 0.001 * cos((x[1] + x[2]) - 2.0 * x[3]))
-//+ 0.001 * cos((x[1] - 2.0 * x[2]) + x[3])) - 0.04 * sin((x[1] + x[2]) - x[3]))
-//+ 0.04 * sin((x[1] - x[2]) + x[3])) - 0.008 * sin((x[1] + x[2]) - 2.0 * x[3]))
-//+ 0.009 * cos((x[1] - x[2]) - x[3])) + 0.001 * cos((x[1] - x[2]) - 2.0 * x[3]))
-//+ 0.001 * cos((x[1] - 2.0 * x[2]) - x[3])) + 0.04 * sin((x[1] - x[2]) - x[3]))
-//+ 0.008 * sin((x[1] - x[2]) - 2.0 * x[3])) - 0.004 * sin((x[1] + 2.0 * x[2])
-//+ 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 * x[2]) - 2.0 * x[3])) - 0.02 * sin
-//(x[1] + x[2])) + 0.001 * cos((x[1] + x[2]) + 2.0 * x[3]))
-//- 0.001 * cos((x[1] + 2.0 * x[2]) + x[3])) - 0.008 * sin((x[1] + x[2]) + 2.0
-//* x[3])) + 0.02 * sin(x[1] - x[2])) - 0.001 * cos((x[1] + 2.0 * x[2]) - x[3]))
-//- 0.001 * cos((x[1] - x[2]) + 2.0 * x[3])) + 0.008 * sin((x[1] - x[2]) + 2.0
-//* x[3])) + 0.004 * sin((x[1] + 2.0 * x[2]) - 2.0 * x[3])) + 0.004 * sin((x[1]
-//- 2.0 * x[2]) + 2.0 * x[3])) + y[2] *
-//((((((((((((((((((((((((((((((((((((0.006 * cos((x[1] + x[2]) +
-//x[3]) - 0.041 * sin((x[1] + x[2]) + x[3])) + 0.006 * cos((x[1] + x[2]) - x[3]))
-//+ 0.006 * cos((x[1] - x[2]) + x[3])) + 0.001 * cos((x[1] + x[2]) - 2.0 * x[3]))
-//- 0.003 * cos((x[1] - 2.0 * x[2]) + x[3])) + 0.001 * cos(x[1] + 2.0 * x[3]))
-//+ 0.041 * sin((x[1] + x[2]) - x[3])) - 0.041 * sin((x[1] - x[2]) + x[3])) +
-//0.008 * sin((x[1] + x[2]) - 2.0 * x[3])) + 0.01 * sin(x[1] + 2.0 * x[2])) -
-//0.008 * sin(x[1] + 2.0 * x[3])) + 0.006 * cos((x[1] - x[2]) - x[3])) + 0.001
-//* cos((x[1] - x[2]) - 2.0 * x[3])) + 0.003 * cos((x[1] - 2.0 * x[2]) - x[3]))
-//+ 0.041 * sin((x[1] - x[2]) - x[3])) + 0.008 * sin((x[1] - x[2]) - 2.0 * x[3]))
-//- 0.004 * sin((x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 *
-//x[2]) - 2.0 * x[3])) - 0.028 * cos(x[1] + x[2])) - 0.006 * cos(x[1] + x[3]))
-//- 0.001 * sin(x[1] + x[3])) + 0.001 * cos((x[1] + x[2]) + 2.0 * x[3])) -
-//0.003 * cos((x[1] + 2.0 * x[2]) + x[3])) - 0.028 * cos(x[1] - x[2])) + 0.006
-//* cos(x[1] - x[3])) - 0.001 * cos(x[1] - 2.0 * x[3])) - 0.008 * sin((x[1] +
-//x[2]) + 2.0 * x[3])) + 0.01 * sin(x[1] - 2.0 * x[2])) - 0.001 * sin(x[1] -
-//x[3])) - 0.008 * sin(x[1] - 2.0 * x[3])) + 0.003 * cos((x[1] + 2.0 * x[2]) -
-//x[3])) + 0.001 * cos((x[1] - x[2]) + 2.0 * x[3])) + 0.026 * sin(x[1])) -
-//0.008 * sin((x[1] - x[2]) + 2.0 * x[3])) - 0.004 * sin((x[1]
-//+ 2.0 * x[2]) - 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 * x[2]) + 2.0 * x[3]))))
-//- y[0] * y[0] * ((((((((((((((((((((((((((((0.001 * sin((2.0 * x[1]
-//+ 2.0 * x[2]) + 2.0 * x[3]) - 0.004 * sin((2.0 * x[1] - x[2]) - 2.0 * x[3]))
-//- 0.02 * sin((2.0 * x[1] - x[2]) - x[3])) + 0.001 * sin((2.0 * x[1] - 2.0 *
-//x[2]) - 2.0 * x[3])) + 0.014 * cos(2.0 * x[1] + x[2])) - 0.008 * cos(2.0 *
-//x[1] + x[3])) + 0.041 * sin(2.0 * x[1] + x[3])) + 0.014 * cos(2.0 * x[1] -
-//x[2])) + 0.008 * cos(2.0 * x[1] - x[3])) + 0.001 * cos(2.0 * x[1] - 2.0 * x
-//[3])) + 0.004 * sin((2.0 * x[1] + x[2]) + 2.0 * x[3])) - 0.002 * sin(2.0 *
-//x[1] - 2.0 * x[2])) + 0.041 * sin(2.0 * x[1] - x[3])) + 0.006 * sin(2.0 * x
-//[1] - 2.0 * x[3])) + 0.294 * sin(2.0 * x[1])) + 0.004 * sin((2.0 * x[1] - x
-//[2]) + 2.0 * x[3])) + 0.001 * sin((2.0 * x[1] + 2.0 * x[2]) - 2.0 * x[3])) +
-//0.001 * sin((2.0 * x[1] - 2.0 * x[2]) + 2.0 * x[3])) - 0.003 * cos((2.0 * x
-//[1] + x[2]) + x[3])) + 0.02 * sin((2.0 * x[1] + x[2]) + x[3])) - 0.003 * cos
-//((2.0 * x[1] + x[2]) - x[3])) - 0.003 * cos((2.0 * x[1] -
-//x[2]) + x[3])) - 0.001 * cos(2.0 * x[1] + 2.0 * x[3])) - 0.02 * sin((2.0 *
-//x[1] + x[2]) - x[3])) + 0.02 * sin((2.0 * x[1] - x[2]) + x[3])) - 0.004 *
-//sin((2.0 * x[1] + x[2]) - 2.0 * x[3])) - 0.002 * sin(2.0 * x[1] + 2.0 * x[2]))
-//+ 0.006 * sin(2.0 * x[1] + 2.0 * x[3])) - 0.003 * cos((2.0 * x[1]
-//- x[2]) - x[3]))) + y[1] * (y[3] * (((((((((0.003 * cos(2.0 * x[2] + x[3]) +
-//0.003 * cos(2.0 * x[2] - x[3])) - 0.001 * cos(2.0 * x[2] - 2.0 * x[3])) -
-//0.008 * sin(2.0 * x[2] - 2.0 * x[3])) + 0.003 * cos(2.0 * x[3])) - 0.017 *
-//sin(2.0 * x[3])) + 0.046 * cos(x[3])) - 0.001 * cos(2.0 * x[2] + 2.0 * x[3]))
-//- 0.161 * sin(x[3])) + 0.008 * sin(2.0 * x[2] + 2.0 * x[3])) + y[2]
-//* ((((((((0.006 * cos(2.0 * x[2] + x[3]) + 0.001 * sin(2.0 * x[2] +
-//x[3])) - 0.006 * cos(2.0 * x[2] - x[3])) + 0.001 * cos(2.0 * x[2] - 2.0 * x
-//[3])) + 0.001 * sin(2.0 * x[2] - x[3])) + 0.008 * sin(2.0 * x[2] - 2.0 * x[3]))
-//- 0.021 * sin(2.0 * x[2])) - 0.001 * cos(2.0 * x[2] + 2.0 * x[3]))
-//+ 0.008 * sin(2.0 * x[2] + 2.0 * x[3])))) + y[3] * y[3] *
-//(((0.013 * cos(x[2] + x[3]) - 0.039 * sin(x[2] + x[3])) + 0.013 * cos
-//(x[2] - x[3])) + 0.039 * sin(x[2] - x[3]))) - y[2] * y[3] *
-//((((((((0.017 * sin(x[2] + 2.0 * x[3]) - 0.003 * cos(x[2] + 2.0 * x[3])) -
-//0.019 * cos(x[2] + x[3])) + 0.081 * sin(x[2] + x[3])) + 0.019 * cos
-//(x[2] - x[3])) + 0.003 * cos(x[2] - 2.0 * x[3])) + 0.081 * sin(x[2] -
-//x[3])) + 0.017 * sin(x[2] - 2.0 * x[3])) + 0.04 * sin(x[2]));
-//
-//
-//C[2] = (((y[0] * y[0] * ((((((((((((((((((((((((0.001 * sin((2.0 * x[1] - 2.0 *
-//x[2]) - 2.0 * x[3]) - 0.002 * sin((2.0 * x[1] - x[2]) - 2.0 * x[3])) - 0.001
-//* sin((2.0 * x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.01 * sin((2.0 * x[1] - x
-//[2]) - x[3])) - 0.007 * cos(2.0 * x[1] + x[2])) + 0.001 * cos(2.0 * x[2] +
-//x[3])) + 0.007 * cos(2.0 * x[1] - x[2])) - 0.001 * cos(2.0 * x[2] - x[3])) -
-//0.002 * sin((2.0 * x[1] + x[2]) + 2.0 * x[3])) - 0.002 * sin(2.0 * x[1] -
-//2.0 * x[2])) + 0.002 * sin(2.0 * x[2] - 2.0 * x[3])) - 0.005 * sin(2.0 * x[2]))
-//+ 0.002 * sin((2.0 * x[1] - x[2]) + 2.0 * x[3])) - 0.001 * sin((2.0 * x[1] +
-//2.0 * x[2]) - 2.0 * x[3])) + 0.001 * sin((2.0 * x[1] - 2.0 * x[2]) + 2.0 *
-//x[3])) + 0.001 * cos((2.0 * x[1] + x[2]) + x[3])) - 0.01 * sin((2.0 * x[1] +
-//x[2]) + x[3])) + 0.001 * cos((2.0 * x[1] + x[2]) - x[3])) - 0.001 * cos((2.0
-//* x[1] - x[2]) + x[3])) + 0.01 * sin((2.0 * x[1] + x[2]) - x[3])) + 0.01 *
-//sin((2.0 * x[1] - x[2]) + x[3])) + 0.002 * sin((2.0 * x[1] + x[2]) - 2.0 *
-//x[3])) + 0.002 * sin(2.0 * x[1] + 2.0 * x[2])) + 0.002 * sin(2.0 * x[2] +
-//2.0 * x[3])) - 0.001 * cos((2.0 * x[1] - x[2]) - x[3])) - y[1] * y[1] *
-//((((0.003 * cos(2.0 * x[2] + x[3]) - 0.003 * cos(2.0 * x[2] - x[3]))
-//+ 0.004 * sin(2.0 * x[2] - 2.0 * x[3])) - 0.01 * sin(2.0 * x[2]))
-//+ 0.004 * sin(2.0 * x[2] + 2.0 * x[3]))) - y[0] * (y[1] *
-//((((((((((((((((((((((((((((((((((((0.006 * cos((x[1] + x[2]) + x[3])
-//- 0.041 * sin((x[1] + x[2]) + x[3])) + 0.006 * cos((x[1] + x[2]) - x[3])) +
-//0.006 * cos((x[1] - x[2]) + x[3])) + 0.001 * cos((x[1] + x[2]) - 2.0 * x[3]))
-//- 0.003 * cos((x[1] - 2.0 * x[2]) + x[3])) + 0.001 * cos(x[1] + 2.0 * x[3]))
-//+ 0.041 * sin((x[1] + x[2]) - x[3])) - 0.041 * sin((x[1] - x[2]) + x[3])) +
-//0.008 * sin((x[1] + x[2]) - 2.0 * x[3])) + 0.01 * sin(x[1] + 2.0 * x[2])) -
-//0.008 * sin(x[1] + 2.0 * x[3])) + 0.006 * cos((x[1] - x[2]) - x[3])) + 0.001
-//* cos((x[1] - x[2]) - 2.0 * x[3])) + 0.003 * cos((x[1] - 2.0 * x[2]) - x[3]))
-//+ 0.041 * sin((x[1] - x[2]) - x[3])) + 0.008 * sin((x[1] - x[2]) - 2.0 * x[3]))
-//- 0.004 * sin((x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 *
-//x[2]) - 2.0 * x[3])) - 0.028 * cos(x[1] + x[2])) - 0.006 * cos(x[1] + x[3]))
-//- 0.001 * sin(x[1] + x[3])) + 0.001 * cos((x[1] + x[2]) + 2.0 * x[3])) -
-//0.003 * cos((x[1] + 2.0 * x[2]) + x[3])) - 0.028 * cos(x[1] - x[2])) + 0.006
-//* cos(x[1] - x[3])) - 0.001 * cos(x[1] - 2.0 * x[3])) -
-//0.008 * sin((x[1] + x[2]) + 2.0 * x[3])) + 0.01 * sin(x[1]
-//- 2.0 * x[2])) - 0.001 * sin(x[1] - x[3])) - 0.008 * sin(x[1] - 2.0 * x[3]))
-//+ 0.003 * cos((x[1] + 2.0 * x[2]) - x[3])) + 0.001 * cos((x[1]
-//- x[2]) + 2.0 * x[3])) + 0.026 * sin(x[1])) - 0.008 * sin((x[1] - x[2]) +
-//2.0 * x[3])) - 0.004 * sin((x[1] + 2.0 * x[2]) - 2.0 * x[3])) - 0.004 * sin
-//((x[1] - 2.0 * x[2]) + 2.0 * x[3])) - y[3] *
-//(((((((((((((((((((((0.003 * cos((x[1] + x[2]) + x[3]) - 0.003 * cos
-//((x[1] + x[2]) - x[3])) + 0.003 * cos((x[1] - x[2]) + x[3])) + 0.001 * cos
-//((x[1] + x[2]) - 2.0 * x[3])) - 0.003 * cos(x[1] + 2.0 * x[3])) + 0.008 *
-//sin((x[1] + x[2]) - 2.0 * x[3])) + 0.017 * sin(x[1] + 2.0 * x[3])) - 0.003 *
-//cos((x[1] - x[2]) - x[3])) + 0.001 * cos((x[1] - x[2]) - 2.0 * x[3])) +
-//0.008 * sin((x[1] - x[2]) - 2.0 * x[3])) + 0.006 * cos(x[1] + x[3])) - 0.02 *
-//sin(x[1] + x[2])) + 0.001 * sin(x[1] + x[3])) - 0.001 *
-//cos((x[1] + x[2]) + 2.0 * x[3])) + 0.006 * cos(x[1] - x[3]))
-//- 0.003 * cos(x[1] - 2.0 * x[3])) + 0.008 * sin((x[1] + x[2])
-//+ 2.0 * x[3])) - 0.02 * sin(x[1] - x[2])) - 0.001 * sin(x[1] - x[3])) -
-//0.017 * sin(x[1] - 2.0 * x[3])) - 0.001 * cos((x[1] - x[2]) + 2.0
-//* x[3])) + 0.008 * sin((x[1] - x[2]) + 2.0 * x[3])))) - y[1] * y[3] *
-//((((((((0.017 * sin(x[2] + 2.0 * x[3]) - 0.003 * cos(x[2] + 2.0 * x[3]))
-//+ 0.006 * cos(x[2] + x[3])) + 0.001 * sin(x[2] + x[3])) - 0.006
-//* cos(x[2] - x[3])) + 0.003 * cos(x[2] - 2.0 * x[3])) + 0.001 *
-//sin(x[2] - x[3])) + 0.017 * sin(x[2] - 2.0 * x[3])) - 0.04 * sin(x
-//[2]))) + y[2] * y[3] * (((0.035 * sin(2.0 * x[3]) - 0.006 * cos(2.0 *
-//x[3])) + 0.013 * cos(x[3])) + 0.003 * sin(x[3]));
-//
-//
-//C[3] = (((y[1] * y[2] * ((((((((0.017 * sin(x[2] + 2.0 * x[3]) - 0.003 * cos
-//(x[2] + 2.0 * x[3])) + 0.006 * cos(x[2] + x[3])) + 0.001 * sin(x[2] + x[3]))
-//- 0.006 * cos(x[2] - x[3])) + 0.003 * cos(x[2] - 2.0 * x[3])) + 0.001 * sin
-//(x[2] - x[3])) + 0.017 * sin(x[2] - 2.0 * x[3])) - 0.04 * sin(x[2])) - y[0] *
-//(y[1] * (((((((((((((((((((((((((0.009 * cos((x[1] + x[2]) + x[3]) -
-//0.04 * sin((x[1] + x[2]) + x[3])) - 0.009 * cos((x[1] + x[2]) - x[3])) -
-//0.009 * cos((x[1] - x[2]) + x[3])) - 0.001 * cos((x[1] + x[2]) - 2.0 * x[3]))
-//+ 0.001 * cos((x[1] - 2.0 * x[2]) + x[3])) - 0.04 * sin((x[1] + x[2]) - x[3]))
-//+ 0.04 * sin((x[1] - x[2]) + x[3])) - 0.008 * sin((x[1] + x[2]) - 2.0 * x[3]))
-//+ 0.009 * cos((x[1] - x[2]) - x[3])) + 0.001 * cos((x[1] - x[2]) - 2.0 * x[3]))
-//+ 0.001 * cos((x[1] - 2.0 * x[2]) - x[3])) + 0.04 * sin((x[1] - x[2]) - x[3]))
-//+ 0.008 * sin((x[1] - x[2]) - 2.0 * x[3])) - 0.004 * sin((x[1] + 2.0 * x[2])
-//+ 2.0 * x[3])) - 0.004 * sin((x[1] - 2.0 * x[2]) - 2.0 * x[3])) - 0.02 * sin
-//(x[1] + x[2])) + 0.001 * cos((x[1] + x[2]) + 2.0 * x[3]))
-//- 0.001 * cos((x[1] + 2.0 * x[2]) + x[3])) - 0.008 * sin((x[1] + x[2]) + 2.0
-//* x[3])) + 0.02 * sin(x[1] - x[2])) - 0.001 * cos((x[1] + 2.0 * x[2]) - x[3]))
-//- 0.001 * cos((x[1] - x[2]) + 2.0 * x[3])) + 0.008 * sin
-//((x[1] - x[2]) + 2.0 * x[3])) + 0.004 * sin((x[1] + 2.0 *
-//x[2]) - 2.0 * x[3])) + 0.004 * sin((x[1] - 2.0 * x[2]) + 2.0 * x[3])) + y[2]
-//* (((((((((((((((((((((0.003 * cos((x[1] + x[2]) + x[3]) - 0.003 *
-//cos((x[1] + x[2]) - x[3])) + 0.003 * cos((x[1] - x[2]) + x[3])) + 0.001 *
-//cos((x[1] + x[2]) - 2.0 * x[3])) - 0.003 * cos(x[1] + 2.0 * x[3])) + 0.008 *
-//sin((x[1] + x[2]) - 2.0 * x[3])) + 0.017 * sin(x[1] + 2.0 * x[3])) - 0.003 *
-//cos((x[1] - x[2]) - x[3])) + 0.001 * cos((x[1] - x[2]) - 2.0 * x[3])) +
-//0.008 * sin((x[1] - x[2]) - 2.0 * x[3])) + 0.006 * cos(x[1] + x[3])) - 0.02 *
-//sin(x[1] + x[2])) + 0.001 * sin(x[1] + x[3])) - 0.001 * cos((x[1] + x[2]) +
-//2.0 * x[3])) + 0.006 * cos(x[1] - x[3])) - 0.003 * cos(x[1] - 2.0 * x[3])) +
-//0.008 * sin((x[1] + x[2]) + 2.0 * x[3])) - 0.02 * sin(x[1]
-//- x[2])) - 0.001 * sin(x[1] - x[3])) - 0.017 * sin(x[1] - 2.0 * x[3])) -
-//0.001 * cos((x[1] - x[2]) + 2.0 * x[3])) + 0.008 * sin((x[1] -
-//x[2]) + 2.0 * x[3])))) - y[2] * y[2] * (((0.017 * sin(2.0 * x[3]) - 0.003 *
-//cos(2.0 * x[3])) + 0.006 * cos(x[3])) + 0.001 * sin(x[3]))) - y[0]
-//* y[0] * ((((((((((((((((((((((((((((0.01 * sin((2.0 * x[1] - x[2]) -
-//x[3]) + 0.004 * sin((2.0 * x[1] - x[2]) - 2.0 * x[3])) + 0.001 * sin((2.0 *
-//x[1] + 2.0 * x[2]) + 2.0 * x[3])) - 0.001 * sin((2.0 * x[1] - 2.0 * x[2]) -
-//2.0 * x[3])) - 0.004 * cos(2.0 * x[1] + x[3])) + 0.02 * sin(2.0 * x[1] + x[3]))
-//- 0.004 * cos(2.0 * x[1] - x[3])) - 0.001 * cos(2.0 * x[1] - 2.0 * x[3])) +
-//0.004 * sin((2.0 * x[1] + x[2]) + 2.0 * x[3])) - 0.02 * sin(2.0 * x[1] - x[3]))
-//- 0.006 * sin(2.0 * x[1] - 2.0 * x[3])) + 0.002 * sin(2.0 * x[2] - 2.0 * x[3]))
-//+ 0.004 * sin(2.0 * x[3])) + 0.004 * sin((2.0 * x[1] - x[2]) + 2.0 * x[3]))
-//- 0.001 * sin((2.0 * x[1] + 2.0 * x[2]) - 2.0 * x[3])) + 0.001 * sin((2.0 *
-//x[1] - 2.0 * x[2]) + 2.0 * x[3])) - 0.001 * cos((2.0 * x[1] + x[2]) + x[3]))
-//+ 0.01 * sin((2.0 * x[1] + x[2]) + x[3])) + 0.014 * cos(x[3])) + 0.001 * cos
-//((2.0 * x[1] + x[2]) - x[3])) - 0.001 * cos((2.0 * x[1] - x
-//[2]) + x[3])) - 0.001 * cos(2.0 * x[1] + 2.0 * x[3])) - 0.039 * sin(x[3])) +
-//0.01 * sin((2.0 * x[1] + x[2]) - x[3])) + 0.01 * sin((2.0 * x[1] - x[2]) +
-//x[3])) + 0.004 * sin((2.0 * x[1] + x[2]) - 2.0 * x[3])) + 0.006 * sin(2.0 *
-//x[1] + 2.0 * x[3])) - 0.002 * sin(2.0 * x[2] + 2.0 * x[3])) +
-//0.001 * cos((2.0 * x[1] - x[2]) - x[3]))) - y[1] * y[1] *
-//(((((((0.001 * cos(2.0 * x[2] + x[3]) + 0.001 * cos(2.0 * x[2] - x[3])) -
-//0.004 * sin(2.0 * x[2] - 2.0 * x[3])) + 0.001 * cos(2.0 * x[3])) -
-//0.008 * sin(2.0 * x[3])) + 0.023 * cos(x[3])) - 0.08 * sin(x[3])) +
-//0.004 * sin(2.0 * x[2] + 2.0 * x[3]));
-
-
-return C;
-}
-
-#endif /* C_4D_HPP_ */
@@ -3,45 +3,29 @@
 #include <barrett/units.h>
 #include <barrett/systems.h>
 
+#include <reference_trajectory.hpp>
+
 template<size_t DOF, typename Tp, typename Tv, typename Ta>
-class constVelRefTrajectory:  public systems::System
+class constVelRefTrajectory:  public refTrajectory<DOF, Tp, Tv, Ta>
  {
 	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
 
-public:
-	// IO
-	Input<double> timef;
-	Output<Tp> referencePTrack;
-	Output<Tv> referenceVTrack;
-	Output<Ta> referenceATrack;
-
-protected:
-	typename System::Output<Tp>::Value* referencePOpValue;
-	typename System::Output<Tv>::Value* referenceVOpValue;
-	typename System::Output<Ta>::Value* referenceAOpValue;
-
 public:
 	explicit constVelRefTrajectory(Tp start_pose, Tv v_desired, const std::string& sysName = "constVelRefTrajectory"):
-		System(sysName), timef(this), referencePTrack(this, &referencePOpValue), referenceVTrack(this, &referenceVOpValue),
-		referenceATrack(this, &referenceAOpValue), start_pose(start_pose), v_des(v_desired){}
+		refTrajectory<DOF, Tp, Tv, Ta>(sysName), start_pose(start_pose), v_des(v_desired){}
 
 	virtual ~constVelRefTrajectory() {this->mandatoryCleanUp();}
 
 	Tp referenceP;
 protected:
-	Tp start_pose, refPTrack;
-	Tv v_des, refVTrack;
-	Ta refATrack;
-
-	virtual void operate() {
-		refPTrack = v_des * this->timef.getValue() + start_pose;
-		refVTrack = v_des;
+	Tp start_pose;
+	Tv v_des;
 
-		referenceP = refPTrack;
+	virtual void evaluate(double t) {
+		this->refPTrack = v_des * t + start_pose;
+		this->refVTrack = v_des;
 
-		this->referencePOpValue->setData(&refPTrack);
-		this->referenceVOpValue->setData(&refVTrack);
-		this->referenceAOpValue->setData(&refATrack);
+		referenceP = this->refPTrack;
 	}
 
 private:
@@ -0,0 +1,138 @@
+/*
+ * cs_id_controller.hpp
+ *
+ * Cartesian-space inverse dynamics (computed torque) controller for the tool
+ * position:
+ *
+ *     jt = C + M J# (a_ref + kp (p_ref - p) + kd (v_ref - v))
+ *
+ * J# is the damped pseudo-inverse of the linear tool Jacobian (3 x DOF), see
+ * damped_pseudo_inverse.hpp. The Jacobian is read in place from the WAM's
+ * kinematics and never modified; all storage is fixed-size.
+ *
+ *  Created on: June, 2023
+ *      Author: Faezeh
+ */
+
+#pragma once
+
+#include <string>
+#include <eigen3/Eigen/Core>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <damped_pseudo_inverse.hpp>
+#include <wam_control_common/kinematics_bundle.h>
+
+using namespace barrett;
+
+
+template<size_t DOF>
+class csIDController :  public systems::System,
+						public systems::KinematicsInput<DOF>
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+// IO  (inputs)
+public:
+	Input<cp_type> refCPInput;	// reference cart pos. input
+	Input<cv_type> refCVInput;	// reference cart vel. input
+	Input<ca_type> refCAInput;	// reference cart acc. input
+
+public:
+	Input<cp_type> feedbackcpInput;     // cart pos. input
+	Input<cv_type> feedbackcvInput;  	// cart vel. input
+
+public:
+	Input<Eigen::Matrix<double, DOF, DOF> > M; // mass matrix input
+	Input<Eigen::Matrix<double, DOF, 1> > C; // coriolis vector input
+
+// IO  (outputs)
+public:
+	Output<jt_type> controlJtOutput;    // output joint torque
+
+protected:
+	typename Output<jt_type>::Value* controljtOutputValue;
+
+public:
+	explicit csIDController(Eigen::Matrix3d proportionalGains, Eigen::Matrix3d dampingGains, const std::string& sysName = "csIDController"):
+		systems::System(sysName), systems::KinematicsInput<DOF>(this), refCPInput(this), refCVInput(this),  refCAInput(this), feedbackcpInput(this), feedbackcvInput(this),
+		controlJtOutput(this, &controljtOutputValue),M(this), C(this), kp(proportionalGains), kd(dampingGains), kin(NULL){}
+
+	virtual ~csIDController() { this->mandatoryCleanUp(); }
+
+	// Damping of the Jacobian pseudo-inverse: none while the smallest
+	// singular value is above threshold [m/rad], rising to lambdaMax at a
+	// singularity.
+	void setDamping(double threshold, double lambdaMax) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		linearJacobianInverse.setDamping(threshold, lambdaMax);
+	}
+
+	// Damping applied on the last tick (0 away from singularities).
+	double getDamping() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return linearJacobianInverse.damping();
+	}
+
+protected:
+	Eigen::Matrix<double, DOF, DOF> M_inside;
+	Eigen::Matrix<double, DOF, 1> C_inside;
+	Eigen::Matrix3d kp, kd;
+
+	jt_type jt_out;
+	cp_type cp_sys, cp_ref;
+	cv_type cv_sys, cv_ref;
+	ca_type ca_ref;
+
+	KinematicsView<DOF> view;
+	const bt_kinematics* kin;
+	DampedPseudoInverse<3, DOF> linearJacobianInverse;
+
+	Eigen::Vector3d tmp_p, tmp_v, tmp_pref, tmp_vref, tmp_aref, xdd_cmd;
+	Eigen::Matrix<double, DOF, 1> qdd_cmd, jt_out_tmp;
+
+	virtual void operate() {
+		/*Taking reference values from the input terminal of this system*/
+		cp_ref = this->refCPInput.getValue();
+		cv_ref = this->refCVInput.getValue();
+		ca_ref = this->refCAInput.getValue();
+
+		/*Taking feedback values from the input terminal of this system*/
+		cp_sys = this->feedbackcpInput.getValue();
+		cv_sys = this->feedbackcvInput.getValue();
+
+		/*Taking M, C and J values from the input terminal of this system*/
+		M_inside = this->M.getValue();
+		C_inside = this->C.getValue();
+
+		tmp_p << cp_sys[0], cp_sys[1], cp_sys[2];
+		tmp_v << cv_sys[0], cv_sys[1], cv_sys[2];
+		tmp_aref << ca_ref[0], ca_ref[1], ca_ref[2];
+		tmp_vref << cv_ref[0], cv_ref[1], cv_ref[2];
+		tmp_pref << cp_ref[0], cp_ref[1], cp_ref[2];
+
+		// The kinematics storage doesn't move while connected; bind once.
+		if (this->kinInput.getValue().impl != kin) {
+			kin = this->kinInput.getValue().impl;
+			view.bind(kin);
+		}
+		linearJacobianInverse.compute(view.Jv);
+
+		xdd_cmd = tmp_aref + kp * (tmp_pref - tmp_p) + kd * (tmp_vref - tmp_v);
+		qdd_cmd.noalias() = linearJacobianInverse.inverse() * xdd_cmd;
+		jt_out_tmp.noalias() = M_inside * qdd_cmd;
+		jt_out_tmp += C_inside;
+
+		jt_out = jt_out_tmp;
+
+		controljtOutputValue->setData(&jt_out);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(csIDController);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
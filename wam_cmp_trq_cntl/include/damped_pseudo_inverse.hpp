@@ -0,0 +1,86 @@
+/*
+ * damped_pseudo_inverse.hpp
+ *
+ * Singularity-robust right pseudo-inverse of a fixed-size ROWS x COLS
+ * Jacobian (ROWS <= COLS):
+ *
+ *     J# = J^T (J J^T + lambda^2 I)^-1
+ *
+ * lambda is zero while the smallest singular value sigma_min of J is above
+ * threshold, and grows smoothly to lambdaMax as sigma_min goes to zero
+ * (lambda^2 = (1 - (sigma_min / threshold)^2) lambdaMax^2). Away from
+ * singularities this is the exact minimum-norm inverse; near them the
+ * joint-space response stays bounded by 1 / (2 lambdaMax) instead of
+ * blowing up.
+ *
+ * J J^T is ROWS x ROWS and symmetric, so one fixed-size eigendecomposition
+ * gives both sigma_min and the inverse. Nothing is allocated and J is only
+ * read, so compute() can run in operate().
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Eigenvalues>
+
+template<int ROWS, int COLS>
+class DampedPseudoInverse
+{
+public:
+	typedef Eigen::Matrix<double, ROWS, COLS> matrix_type;
+	typedef Eigen::Matrix<double, COLS, ROWS> inverse_type;
+
+	explicit DampedPseudoInverse(double threshold = 0.05, double lambdaMax = 0.05) :
+		threshold(threshold), lambdaMax(lambdaMax), lambda(0.0), sigmaMin(0.0) {
+		pinv.setZero();
+	}
+
+	void setDamping(double threshold_, double lambdaMax_) {
+		threshold = threshold_;
+		lambdaMax = lambdaMax_;
+	}
+
+	template<typename Derived>
+	const inverse_type& compute(const Eigen::MatrixBase<Derived>& J) {
+		JJt.noalias() = J * J.transpose();
+		eig.compute(JJt);
+		const typename solver_type::RealVectorType& s2 = eig.eigenvalues();	// sigma^2, ascending
+		sigmaMin = std::sqrt(std::max(s2[0], 0.0));
+
+		double lambda2 = 0.0;
+		if (sigmaMin < threshold) {
+			const double r = sigmaMin / threshold;
+			lambda2 = (1.0 - r * r) * lambdaMax * lambdaMax;
+		}
+		lambda = std::sqrt(lambda2);
+
+		for (int i = 0; i < ROWS; ++i) {
+			const double d = std::max(s2[i], 0.0) + lambda2;
+			inverseDiagonal[i] = d > 0.0 ? 1.0 / d : 0.0;
+		}
+		JJtInverse.noalias() = eig.eigenvectors() * inverseDiagonal.asDiagonal() * eig.eigenvectors().transpose();
+		pinv.noalias() = J.transpose() * JJtInverse;
+		return pinv;
+	}
+
+	const inverse_type& inverse() const { return pinv; }
+	double damping() const { return lambda; }				// lambda of the last compute()
+	double smallestSingularValue() const { return sigmaMin; }	// of the last J
+
+protected:
+	typedef Eigen::Matrix<double, ROWS, ROWS> square_type;
+	typedef Eigen::SelfAdjointEigenSolver<square_type> solver_type;
+
+	double threshold, lambdaMax;
+	double lambda, sigmaMin;
+
+	square_type JJt, JJtInverse;
+	Eigen::Matrix<double, ROWS, 1> inverseDiagonal;
+	solver_type eig;
+	inverse_type pinv;
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,134 @@
+/*
+ * js_id_controller.hpp
+ *
+ * Joint-space inverse dynamics (computed torque) controller and the joint
+ * torque saturation used with it.
+ *
+ *  Created on: June, 2023
+ *      Author: Faezeh
+ */
+
+#pragma once
+
+#include <string>
+#include <eigen3/Eigen/Core>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+using namespace barrett;
+
+//The WAM arm has a torque saturation limit.
+
+template <size_t DOF>
+typename units::JointTorques<DOF>::type SaturateJointTorque
+	(const typename units::JointTorques<DOF>::type& x,
+	const typename units::JointTorques<DOF>::type& limit)
+{
+	int index;
+	double minRatio;
+
+	/*We don't want to use the motors at the maximum torque levels. Instead we set a basic torque level of our choice
+	(shown later), and make sure that the torque provided satisfies the following ratio.
+
+	x = Torque provided to motors (remember this is a 7x1 matrix, given the 7 DOF for our WAM arm)
+	limit = Torque limit (user defined)*/
+	
+	minRatio = limit.cwiseQuotient(x.cwiseAbs()).minCoeff(&index);
+	//Functions from Eigen Core library - https://eigen.tuxfamily.org/dox/group__TutorialReductionsVisitorsBroadcasting.html
+	if(minRatio < 1.0)
+	{
+		return minRatio*x;
+	}
+	else
+	{
+		return x;
+	}
+};
+
+
+template<size_t DOF>
+class jsIDController :  public systems::System{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+// IO  (inputs)
+public:
+	Input<jp_type> refJPInput;	// reference joint pos. input   
+	Input<jv_type> refJVInput;	// reference joint vel. input
+	Input<ja_type> refJAInput;	// reference joint acc. input
+
+public:
+	Input<jp_type> feedbackjpInput;     // joint pos. input       
+	Input<jv_type> feedbackjvInput;  	// joint vel. input
+
+public:
+	Input<Eigen::Matrix<double, DOF, DOF> > M; // mass matrix input
+	Input<Eigen::Matrix<double, DOF, 1> > C; // coriolis vector input
+
+// IO  (outputs)
+public:
+	Output<jt_type> controlJtOutput;    // output joint torque
+
+protected:
+	typename Output<jt_type>::Value* controljtOutputValue;
+
+public:
+jt_type computedT;
+
+public:
+	explicit jsIDController(const Eigen::Matrix<double, DOF, DOF>& proportionalGains, const Eigen::Matrix<double, DOF, DOF>& dampingGains, const std::string& sysName = "jsIDController"):
+		System(sysName), refJPInput(this), refJVInput(this), refJAInput(this), feedbackjpInput(this), feedbackjvInput(this), controlJtOutput(this, &controljtOutputValue),M(this), C(this), kp(proportionalGains), kd(dampingGains){}
+
+	virtual ~jsIDController() { this->mandatoryCleanUp(); }
+
+protected:
+	Eigen::Matrix<double, DOF, DOF> M_inside;
+	Eigen::Matrix<double, DOF, 1> C_inside;
+	Eigen::Matrix<double, DOF, DOF> kp, kd;
+
+	jt_type jt_out;
+	jp_type jp_sys, jp_ref;
+	jv_type jv_sys, jv_ref;
+	ja_type ja_ref;
+
+	Eigen::Matrix<double, DOF, 1> tmp_p, tmp_v, tmp_control, tmp_aref, tmp_pref, tmp_vref, jt_out_tmp;	
+
+	virtual void operate() {
+		/*Taking reference values from the input terminal of this system*/
+		jp_ref = this->refJPInput.getValue();
+		jv_ref = this->refJVInput.getValue();
+		ja_ref = this->refJAInput.getValue();
+
+		/*Taking feedback values from the input terminal of this system*/
+		jp_sys = this->feedbackjpInput.getValue();
+		jv_sys = this->feedbackjvInput.getValue();
+
+		/*Taking M, C and J values from the input terminal of this system*/
+		M_inside = this->M.getValue();
+		C_inside = this->C.getValue();
+
+		//std::cout << M_inside << std::endl;
+
+		tmp_p = jp_sys;
+		tmp_v = jv_sys;
+		tmp_aref = ja_ref;
+		tmp_vref = jv_ref;
+		tmp_pref = jp_ref;
+
+		//jt_out_tmp = C_inside + M_inside * (tmp_aref + kp * (tmp_pref) + kd * (tmp_vref));
+		jt_out_tmp = C_inside + M_inside * (tmp_aref + kp * (tmp_pref - tmp_p) + kd * (tmp_vref - tmp_v));
+		
+
+		jt_out = jt_out_tmp;
+
+		computedT = jt_out;
+		
+		controljtOutputValue->setData(&jt_out);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(jsIDController);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,281 @@
+/*
+ * profiled_reference_trajectory.hpp
+ *
+ * Rest-to-rest and via-point reference generators with consistent position,
+ * velocity and acceleration, for the acceleration feedforward of the
+ * computed-torque controllers. All are closed-form in the trajectory time t
+ * (timef); before t = 0 they hold the start and after the end the goal.
+ *
+ *  - trapezoidalRefTrajectory: straight line, trapezoidal speed under
+ *    per-axis velocity and acceleration limits. The axes are synchronized,
+ *    so the slowest one sets the timing. Acceleration steps at the corners.
+ *  - quinticRefTrajectory: quintic per axis between given boundary
+ *    positions, velocities and accelerations.
+ *  - minJerkRefTrajectory: the quintic with zero boundary velocity and
+ *    acceleration, s = 10 tau^3 - 15 tau^4 + 6 tau^5.
+ *  - viaPointRefTrajectory: quintic segments through via points with given
+ *    segment durations, at rest at both ends. The velocity at a via point is
+ *    the mean of the adjacent segment slopes (zero on an axis that turns
+ *    back) and the acceleration there is zero, so p, v and a are continuous.
+ *
+ * The generators only allocate in their constructors.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/StdVector>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+
+#include <reference_trajectory.hpp>
+
+using namespace barrett;
+
+// p(t) = c0 + c1 t + ... + c5 t^5 on [0, T] for each axis.
+template<typename Tp, typename Tv, typename Ta>
+struct quinticSegment
+{
+	Tp c0, c1, c2, c3, c4, c5;
+	double T;
+
+	quinticSegment() : T(0.0) {}
+
+	quinticSegment(const Tp& p0, const Tv& v0, const Ta& a0, const Tp& p1, const Tv& v1, const Ta& a1, double duration) :
+		T(duration)
+	{
+		c0 = p0;
+		c1 = v0;
+		c2 = 0.5 * a0;
+		if (T <= 0.0) {
+			// jumps straight to p1
+			c0 = p1;
+			c1.setZero();
+			c2.setZero();
+			c3.setZero();
+			c4.setZero();
+			c5.setZero();
+			return;
+		}
+		const Tp h = p1 - p0;
+		const double T2 = T * T, T3 = T2 * T;
+		c3 = (20.0 * h - (8.0 * v1 + 12.0 * v0) * T - (3.0 * a0 - a1) * T2) / (2.0 * T3);
+		c4 = (-30.0 * h + (14.0 * v1 + 16.0 * v0) * T + (3.0 * a0 - 2.0 * a1) * T2) / (2.0 * T3 * T);
+		c5 = (12.0 * h - 6.0 * (v1 + v0) * T + (a1 - a0) * T2) / (2.0 * T3 * T2);
+	}
+
+	// t is clamped to [0, T]; outside it the segment holds its end points
+	// with zero velocity and acceleration.
+	void evaluate(double t, Tp& p, Tv& v, Ta& a) const {
+		if (t <= 0.0 || t >= T) {
+			const double tc = t <= 0.0 ? 0.0 : T;
+			p = c0 + tc * (c1 + tc * (c2 + tc * (c3 + tc * (c4 + tc * c5))));
+			v.setZero();
+			a.setZero();
+			return;
+		}
+		p = c0 + t * (c1 + t * (c2 + t * (c3 + t * (c4 + t * c5))));
+		v = c1 + t * (2.0 * c2 + t * (3.0 * c3 + t * (4.0 * c4 + t * 5.0 * c5)));
+		a = 2.0 * c2 + t * (6.0 * c3 + t * (12.0 * c4 + t * 20.0 * c5));
+	}
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
+template<size_t DOF, typename Tp, typename Tv, typename Ta>
+class trapezoidalRefTrajectory:  public refTrajectory<DOF, Tp, Tv, Ta>
+ {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	// v_max and a_max are per-axis limits (> 0).
+	trapezoidalRefTrajectory(const Tp& start, const Tp& goal, const Tv& v_max, const Ta& a_max,
+			const std::string& sysName = "trapezoidalRefTrajectory"):
+		refTrajectory<DOF, Tp, Tv, Ta>(sysName), start(start), delta(goal - start), sdMax(INFINITY), sddMax(INFINITY)
+	{
+		// limits on the path parameter s in [0, 1]
+		for (int i = 0; i < delta.size(); ++i) {
+			const double d = std::fabs(delta[i]);
+			if (d > 0.0) {
+				sdMax = std::min(sdMax, v_max[i] / d);
+				sddMax = std::min(sddMax, a_max[i] / d);
+			}
+		}
+
+		if ( !std::isfinite(sdMax)) {
+			// start == goal
+			tAcc = T = 0.0;
+		} else if (sdMax * sdMax >= sddMax) {
+			// never reaches sdMax: triangular profile
+			sdMax = std::sqrt(sddMax);
+			tAcc = sdMax / sddMax;
+			T = 2.0 * tAcc;
+		} else {
+			tAcc = sdMax / sddMax;
+			T = tAcc + 1.0 / sdMax;
+		}
+		this->refPTrack = start;
+	}
+
+	virtual ~trapezoidalRefTrajectory() {this->mandatoryCleanUp();}
+
+	double getDuration() const { return T; }
+
+protected:
+	Tp start, delta;
+	double sdMax, sddMax;
+	double tAcc, T;
+
+	virtual void evaluate(double t) {
+		double s, sd = 0.0, sdd = 0.0;
+		if (t <= 0.0 || T <= 0.0) {
+			s = t <= 0.0 ? 0.0 : 1.0;
+		} else if (t >= T) {
+			s = 1.0;
+		} else if (t < tAcc) {
+			s = 0.5 * sddMax * t * t;
+			sd = sddMax * t;
+			sdd = sddMax;
+		} else if (t <= T - tAcc) {
+			s = 0.5 * sddMax * tAcc * tAcc + sdMax * (t - tAcc);
+			sd = sdMax;
+		} else {
+			const double r = T - t;
+			s = 1.0 - 0.5 * sddMax * r * r;
+			sd = sddMax * r;
+			sdd = -sddMax;
+		}
+
+		this->refPTrack = start + s * delta;
+		this->refVTrack = sd * delta;
+		this->refATrack = sdd * delta;
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(trapezoidalRefTrajectory);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
+template<size_t DOF, typename Tp, typename Tv, typename Ta>
+class quinticRefTrajectory:  public refTrajectory<DOF, Tp, Tv, Ta>
+ {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	quinticRefTrajectory(const Tp& p0, const Tv& v0, const Ta& a0, const Tp& p1, const Tv& v1, const Ta& a1, double duration,
+			const std::string& sysName = "quinticRefTrajectory"):
+		refTrajectory<DOF, Tp, Tv, Ta>(sysName), segment(p0, v0, a0, p1, v1, a1, duration)
+	{
+		this->refPTrack = p0;
+	}
+
+	virtual ~quinticRefTrajectory() {this->mandatoryCleanUp();}
+
+	double getDuration() const { return segment.T; }
+
+protected:
+	quinticSegment<Tp, Tv, Ta> segment;
+
+	virtual void evaluate(double t) {
+		segment.evaluate(t, this->refPTrack, this->refVTrack, this->refATrack);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(quinticRefTrajectory);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
+template<size_t DOF, typename Tp, typename Tv, typename Ta>
+class minJerkRefTrajectory:  public quinticRefTrajectory<DOF, Tp, Tv, Ta>
+ {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	minJerkRefTrajectory(const Tp& start, const Tp& goal, double duration, const std::string& sysName = "minJerkRefTrajectory"):
+		quinticRefTrajectory<DOF, Tp, Tv, Ta>(start, Tv(0.0), Ta(0.0), goal, Tv(0.0), Ta(0.0), duration, sysName) {}
+
+	virtual ~minJerkRefTrajectory() {this->mandatoryCleanUp();}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(minJerkRefTrajectory);
+};
+
+
+template<size_t DOF, typename Tp, typename Tv, typename Ta>
+class viaPointRefTrajectory:  public refTrajectory<DOF, Tp, Tv, Ta>
+ {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	// durations[i] is the time from points[i] to points[i + 1].
+	viaPointRefTrajectory(const std::vector<Tp>& points, const std::vector<double>& durations,
+			const std::string& sysName = "viaPointRefTrajectory"):
+		refTrajectory<DOF, Tp, Tv, Ta>(sysName), current(0), T(0.0)
+	{
+		const size_t n = std::min(points.size() - (points.empty() ? 0 : 1), durations.size());
+		if ( !points.empty()) {
+			this->refPTrack = points[0];
+		}
+
+		// via point velocities
+		std::vector<Tv, Eigen::aligned_allocator<Tv> > v(n + 1, Tv(0.0));
+		for (size_t k = 1; k < n; ++k) {
+			for (int i = 0; i < v[k].size(); ++i) {
+				const double before = durations[k - 1] > 0.0 ? (points[k][i] - points[k - 1][i]) / durations[k - 1] : 0.0;
+				const double after = durations[k] > 0.0 ? (points[k + 1][i] - points[k][i]) / durations[k] : 0.0;
+				v[k][i] = before * after > 0.0 ? 0.5 * (before + after) : 0.0;
+			}
+		}
+
+		segments.reserve(n);
+		startTimes.reserve(n);
+		for (size_t k = 0; k < n; ++k) {
+			segments.push_back(segment_type(points[k], v[k], Ta(0.0), points[k + 1], v[k + 1], Ta(0.0), durations[k]));
+			startTimes.push_back(T);
+			T += std::max(durations[k], 0.0);
+		}
+	}
+
+	virtual ~viaPointRefTrajectory() {this->mandatoryCleanUp();}
+
+	double getDuration() const { return T; }
+
+protected:
+	typedef quinticSegment<Tp, Tv, Ta> segment_type;
+
+	std::vector<segment_type, Eigen::aligned_allocator<segment_type> > segments;
+	std::vector<double> startTimes;
+	size_t current;	// segment of the last tick; t normally only grows
+	double T;
+
+	virtual void evaluate(double t) {
+		if (segments.empty()) {
+			return;
+		}
+		if (t < startTimes[current]) {
+			current = 0;
+		}
+		while (current + 1 < segments.size() && t >= startTimes[current + 1]) {
+			++current;
+		}
+		segments[current].evaluate(t - startTimes[current], this->refPTrack, this->refVTrack, this->refATrack);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(viaPointRefTrajectory);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,69 @@
+/*
+ * reference_trajectory.hpp
+ *
+ * Common base of the reference generators fed to the ID controllers. Every
+ * generator has the same ports: the trajectory time on timef, and the
+ * reference position, velocity and acceleration on referencePTrack,
+ * referenceVTrack and referenceATrack. Tp/Tv/Ta are either jp/jv/ja or
+ * cp/cv/ca, so one generator serves the joint- and Cartesian-space mains.
+ *
+ * Subclasses implement evaluate(t), which writes refPTrack, refVTrack and
+ * refATrack from closed-form expressions; it runs in the real-time thread
+ * and must not allocate.
+ */
+
+#pragma once
+
+#include <string>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+using namespace barrett;
+
+template<size_t DOF, typename Tp, typename Tv, typename Ta>
+class refTrajectory:  public systems::System
+ {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	// IO
+	Input<double> timef;
+	Output<Tp> referencePTrack;
+	Output<Tv> referenceVTrack;
+	Output<Ta> referenceATrack;
+
+protected:
+	typename System::Output<Tp>::Value* referencePOpValue;
+	typename System::Output<Tv>::Value* referenceVOpValue;
+	typename System::Output<Ta>::Value* referenceAOpValue;
+
+public:
+	explicit refTrajectory(const std::string& sysName = "refTrajectory"):
+		System(sysName), timef(this), referencePTrack(this, &referencePOpValue), referenceVTrack(this, &referenceVOpValue),
+		referenceATrack(this, &referenceAOpValue), refPTrack(0.0), refVTrack(0.0), refATrack(0.0) {}
+
+	// Concrete generators call mandatoryCleanUp() in their own destructors.
+	virtual ~refTrajectory() {}
+
+protected:
+	Tp refPTrack;
+	Tv refVTrack;
+	Ta refATrack;
+
+	virtual void evaluate(double t) = 0;
+
+	virtual void operate() {
+		evaluate(this->timef.getValue());
+
+		this->referencePOpValue->setData(&refPTrack);
+		this->referenceVOpValue->setData(&refVTrack);
+		this->referenceAOpValue->setData(&refATrack);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(refTrajectory);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -3,43 +3,27 @@
 #include <barrett/units.h>
 #include <barrett/systems.h>
 
+#include <reference_trajectory.hpp>
+
 template<size_t DOF, typename Tp, typename Tv, typename Ta>
-class regulationRefTrajectory:  public systems::System
+class regulationRefTrajectory:  public refTrajectory<DOF, Tp, Tv, Ta>
  {
 	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
 
-public:
-	// IO
-	Input<double> timef;
-	Output<Tp> referencePTrack;
-	Output<Tv> referenceVTrack;
-	Output<Ta> referenceATrack;
-
-protected:
-	typename System::Output<Tp>::Value* referencePOpValue;
-	typename System::Output<Tv>::Value* referenceVOpValue;
-	typename System::Output<Ta>::Value* referenceAOpValue;
-
 public:
 	explicit regulationRefTrajectory(Tp p_desired, const std::string& sysName = "regulationRefTrajectory"):
-		System(sysName), timef(this), referencePTrack(this, &referencePOpValue), referenceVTrack(this, &referenceVOpValue),
-		referenceATrack(this, &referenceAOpValue), refPTrack(p_desired){}
+		refTrajectory<DOF, Tp, Tv, Ta>(sysName)
+	{
+		this->refPTrack = p_desired;
+	}
 
 	virtual ~regulationRefTrajectory() {this->mandatoryCleanUp();}
 
 protected:
-	Tp refPTrack;
-	Tv refVTrack;
-	Ta refATrack;
+	// The set point doesn't depend on time; timef may be left unconnected.
+	virtual bool inputsValid() { return true; }
 
-	virtual void operate() {
-		refVTrack.Zero();
-		refATrack.Zero();
-
-		this->referencePOpValue->setData(&refPTrack);
-		this->referenceVOpValue->setData(&refVTrack);
-		this->referenceAOpValue->setData(&refATrack);
-	}
+	virtual void evaluate(double t) {}
 
 private:
 	DISALLOW_COPY_AND_ASSIGN(regulationRefTrajectory);
@@ -0,0 +1,202 @@
+/*
+ * wam_cs_sim_benchmark.cpp
+ *
+ * Closed-loop benchmark of the Cartesian-space ID controller against
+ * SimulatedWam, without hardware or ROS:
+ *
+ *   wam_cs_sim_benchmark [config=/etc/barrett/default.conf] [group=wam4] [seconds=6]
+ *
+ * The tool follows a minimum-jerk line out of the start pose and then a
+ * second one to a point beyond the arm's reach, so the last part runs at
+ * the stretched-out singularity where the Jacobian pseudo-inverse is damped.
+ * The execution graph is stepped by a ManualExecutionManager as fast as it
+ * evaluates.
+ *
+ * Prints the tracking error of the reachable part, the largest damping,
+ * the cost of one pseudo-inverse, and the operate() timing of the
+ * controller's systems; exits non-zero if the tracking error is too large
+ * or a tick of the controller graph doesn't fit in the 500 Hz period.
+ */
+
+
+#include <wam_control_common/rnea_dynamics.h>
+#include <js_id_controller.hpp>
+#include <cs_id_controller.hpp>
+#include <damped_pseudo_inverse.hpp>
+#include <profiled_reference_trajectory.hpp>
+#include <wam_control_common/simulated_wam.h>
+#include <wam_control_common/operate_timing.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <libconfig.h++>
+#include <boost/bind.hpp>
+#include <barrett/os.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/math/kinematics.h>
+
+using namespace barrett;
+
+static const double T_S = 0.002;				// [s] control period, as on the WAM
+static const double TRACKING_ERROR = 0.005;		// [m] largest tool error on the reachable part that passes
+static const int PINV_REPETITIONS = 100000;
+
+template<size_t DOF>
+int run(const libconfig::Setting& wamSetting, double duration) {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+	systems::ManualExecutionManager mem(T_S);
+
+	//Start pose of wam_cartesian_space_ID_controller_4dof, wrist (if any) straight
+	jp_type startPose(0.0);
+	startPose.template head<4>() << 0.0, 0.558759518104764, 0.0, 2.32406132303686;
+	SimulatedWam<DOF> wam(wamSetting, startPose, &mem);
+	wam.gravityCompensate();
+
+	math::Kinematics<DOF> kin(wamSetting["kinematics"]);
+	KinematicsView<DOF> view;
+	view.bind(kin.impl);
+	kin.eval(startPose, jv_type(0.0));
+	const cp_type startCp(view.position);
+
+	//Out 10 cm and down 10 cm, then out of reach along the same direction
+	cp_type goalCp(startCp), farCp;
+	goalCp[0] += 0.1;
+	goalCp[2] -= 0.1;
+	farCp = goalCp + 5.0 * (goalCp - startCp);
+	const double segment = 0.5 * duration;
+
+	std::vector<cp_type> points;
+	points.push_back(startCp);
+	points.push_back(goalCp);
+	points.push_back(goalCp);	// rest at goalCp before moving on
+	points.push_back(farCp);
+	std::vector<double> durations;
+	durations.push_back(0.5 * segment);
+	durations.push_back(0.5 * segment);
+	durations.push_back(segment);
+
+	//Controller gains
+	Eigen::Matrix3d kp, kd;
+	kp = 400.0 * Eigen::Matrix3d::Identity();
+	kd = 40.0 * Eigen::Matrix3d::Identity();
+
+	GraphTimer graphTimer;
+	Timed<csIDController<DOF> > compTorqueController(kp, kd);
+	Timed<RNEADynamics<DOF> > wamDynamics(wamSetting);
+	graphTimer.track(compTorqueController);
+	graphTimer.track(wamDynamics);
+
+	systems::Ramp time(&mem, 1.0);
+	viaPointRefTrajectory<DOF, cp_type, cv_type, ca_type> refTraj(points, durations);
+
+	jt_type jtLimits(30.0);
+	systems::Callback<jt_type> jtSat(boost::bind(SaturateJointTorque<DOF>, _1, jtLimits));
+
+	systems::connect(time.output, refTraj.timef);
+	systems::connect(refTraj.referencePTrack, compTorqueController.refCPInput);
+	systems::connect(refTraj.referenceVTrack, compTorqueController.refCVInput);
+	systems::connect(refTraj.referenceATrack, compTorqueController.refCAInput);
+	systems::connect(wam.toolPosition.output, compTorqueController.feedbackcpInput);
+	systems::connect(wam.toolVelocity.output, compTorqueController.feedbackcvInput);
+	systems::connect(wam.kinematicsBase.kinOutput, compTorqueController.kinInput);
+	systems::connect(wam.jpOutput, wamDynamics.jpInputDynamics);
+	systems::connect(wam.jvOutput, wamDynamics.jvInputDynamics);
+	systems::connect(wamDynamics.MassMAtrixOutput, compTorqueController.M);
+	systems::connect(wamDynamics.CVectorOutput, compTorqueController.C);
+	systems::connect(compTorqueController.controlJtOutput, jtSat.input);
+	wam.trackReferenceSignal(jtSat.output);
+	mem.startManaging(graphTimer);
+	time.start();
+
+	const size_t ticks = static_cast<size_t>(duration / T_S);
+	const size_t reachableTicks = static_cast<size_t>(segment / T_S);
+	double sumSquaredError = 0.0, worstError = 0.0, peakDamping = 0.0;
+	const double start = highResolutionSystemTime();
+	for (size_t i = 0; i < ticks; ++i) {
+		mem.runExecutionCycle();
+		peakDamping = std::max(peakDamping, compTorqueController.getDamping());
+		if (i < reachableTicks) {
+			kin.eval(jp_type(wam.plant.jointPositions()), jv_type(0.0));
+			const double e = (compTorqueController.refCPInput.getValue() - cp_type(view.position)).norm();
+			sumSquaredError += e * e;
+			worstError = std::max(worstError, e);
+		}
+	}
+	const double wall = highResolutionSystemTime() - start;
+	kin.eval(jp_type(wam.plant.jointPositions()), jv_type(0.0));
+	const double reach = (cp_type(view.position) - startCp).norm();
+
+	//The pseudo-inverse on its own, on the final (stretched-out) Jacobian
+	const Eigen::Matrix<double, 3, DOF> Jv = view.Jv;
+	DampedPseudoInverse<3, DOF> pinv;
+	double checksum = 0.0;
+	const double pinvStart = highResolutionSystemTime();
+	for (int k = 0; k < PINV_REPETITIONS; ++k) {
+		checksum += pinv.compute(Jv)(0, 0);
+	}
+	const double pinvTime = (highResolutionSystemTime() - pinvStart) / PINV_REPETITIONS;
+
+	printf("%zu-DOF, %zu ticks of %.0f us\n", DOF, ticks, T_S * 1e6);
+	printf("simulated %.2f s in %.3f s wall (%.1fx real time)\n", ticks * T_S, wall, ticks * T_S / wall);
+	printf("tool error while reachable: worst %.5f m, RMS %.5f m\n", worstError,
+			std::sqrt(sumSquaredError / std::max<size_t>(reachableTicks, 1)));
+	printf("final distance from start %.3f m, peak damping %.4f, sigma_min %.4f\n", reach, peakDamping,
+			pinv.smallestSingularValue());
+	printf("damped pseudo-inverse %.3f us (checksum %g)\n", pinvTime * 1e6, checksum);
+	printf("\n%s", graphTimer.report().c_str());
+
+	wam.idle();
+	time.stop();
+	//Worst case of the controller's systems, as if they fell on the same tick [us]
+	const double worstTick = compTorqueController.operateTime.summary().max + wamDynamics.operateTime.summary().max;
+	return (worstError <= TRACKING_ERROR && worstTick * 1e-6 < T_S) ? 0 : 1;
+}
+
+static bool readConfig(libconfig::Config& config, const char* path) {
+	try {
+		const std::string p(path);
+		const size_t slash = p.find_last_of('/');
+		if (slash != std::string::npos) {
+			config.setIncludeDir(p.substr(0, slash).c_str());	// default.conf @includes the per-arm files
+		}
+		config.readFile(path);
+	} catch (const libconfig::FileIOException&) {
+		printf("Couldn't read %s\n", path);
+		return false;
+	} catch (const libconfig::ParseException& e) {
+		printf("%s:%d: %s\n", e.getFile(), e.getLine(), e.getError());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	const char* configPath = argc > 1 ? argv[1] : "/etc/barrett/default.conf";
+	const char* group = argc > 2 ? argv[2] : "wam4";
+	const double duration = argc > 3 ? atof(argv[3]) : 6.0;
+
+	libconfig::Config config;
+	if ( !readConfig(config, configPath)) {
+		return 2;
+	}
+	if ( !config.exists(group)) {
+		printf("%s has no group \"%s\"\n", configPath, group);
+		return 2;
+	}
+
+	const libconfig::Setting& wamSetting = config.lookup(group);
+	switch (wamSetting["kinematics"]["moving"].getLength()) {
+	case 4:
+		return run<4>(wamSetting, duration);
+	case 7:
+		return run<7>(wamSetting, duration);
+	default:
+		printf("Group \"%s\" is neither a 4-DOF nor a 7-DOF WAM\n", group);
+		return 2;
+	}
+}
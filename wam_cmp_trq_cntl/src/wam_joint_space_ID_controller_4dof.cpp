@@ -6,12 +6,16 @@
  */
 
 
-#include <Dynamics.hpp>
+#include <wam_control_common/rnea_dynamics.h>
+#include <js_id_controller.hpp>
 #include <regulation_refference_trajectory.hpp>
 #include <constant_vel_refference_traj.hpp>
+#include <profiled_reference_trajectory.hpp>
+#include <wam_control_common/columnar_log.h>
 #include <unistd.h>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <barrett/units.h>
 #include <barrett/systems.h>
 #include <barrett/products/product_manager.h>
@@ -39,123 +43,6 @@ using detail::waitForEnter;
 //	connect(pid.controlOutput, id.input);
 //	wam.supervisoryController.registerConversion(systems::makeIOConversion(pid.referenceInput, id.output));
 
-//The WAM arm has a torque saturation limit.
-
-template <size_t DOF>
-typename units::JointTorques<DOF>::type SaturateJointTorque
-	(const typename units::JointTorques<DOF>::type& x,
-	const typename units::JointTorques<DOF>::type& limit)
-{
-	int index;
-	double minRatio;
-
-	/*We don't want to use the motors at the maximum torque levels. Instead we set a basic torque level of our choice
-	(shown later), and make sure that the torque provided satisfies the following ratio.
-
-	x = Torque provided to motors (remember this is a 7x1 matrix, given the 7 DOF for our WAM arm)
-	limit = Torque limit (user defined)*/
-	
-	minRatio = limit.cwiseQuotient(x.cwiseAbs()).minCoeff(&index);
-	//Functions from Eigen Core library - https://eigen.tuxfamily.org/dox/group__TutorialReductionsVisitorsBroadcasting.html
-	if(minRatio < 1.0)
-	{
-		return minRatio*x;
-	}
-	else
-	{
-		return x;
-	}
-};
-
-
-template<size_t DOF>
-class jsIDController :  public systems::System{
-	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
-
-// IO  (inputs)
-public:
-	Input<jp_type> refJPInput;	// reference joint pos. input   
-	Input<jv_type> refJVInput;	// reference joint vel. input
-	Input<ja_type> refJAInput;	// reference joint acc. input
-
-public:
-	Input<jp_type> feedbackjpInput;     // joint pos. input       
-	Input<jv_type> feedbackjvInput;  	// joint vel. input
-
-public:
-	Input<Eigen::Matrix4d> M; // mass matrix input
-	Input<Eigen::Vector4d> C; // coriolis vector input
-
-// IO  (outputs)
-public:
-	Output<jt_type> controlJtOutput;    // output joint torque
-
-protected:
-	typename Output<jt_type>::Value* controljtOutputValue;
-
-public:
-jt_type computedT;
-
-public:
-	explicit jsIDController(Eigen::Matrix4d proportionalGains, Eigen::Matrix4d dampingGains, const std::string& sysName = "jsIDController"):
-		System(sysName), refJPInput(this), refJVInput(this), refJAInput(this), feedbackjpInput(this), feedbackjvInput(this), controlJtOutput(this, &controljtOutputValue),M(this), C(this), kp(proportionalGains), kd(dampingGains){}
-
-	virtual ~jsIDController() { this->mandatoryCleanUp(); }
-
-protected:
-	Eigen::Matrix4d M_inside;
-	Eigen::Vector4d C_inside;
-	Eigen::Matrix4d kp, kd;
-
-	jt_type jt_out;
-	jp_type jp_sys, jp_ref;
-	jv_type jv_sys, jv_ref;
-	ja_type ja_ref;
-
-	Eigen::Vector4d tmp_p, tmp_v, tmp_control, tmp_aref, tmp_pref, tmp_vref, jt_out_tmp;	
-
-	virtual void operate() {
-		/*Taking reference values from the input terminal of this system*/
-		jp_ref = this->refJPInput.getValue();
-		jv_ref = this->refJVInput.getValue();
-		ja_ref = this->refJAInput.getValue();
-
-		/*Taking feedback values from the input terminal of this system*/
-		jp_sys = this->feedbackjpInput.getValue();
-		jv_sys = this->feedbackjvInput.getValue();
-
-		/*Taking M, C and J values from the input terminal of this system*/
-		M_inside = this->M.getValue();
-		C_inside = this->C.getValue();
-
-		//std::cout << M_inside << std::endl;
-
-		tmp_p << jp_sys[0], jp_sys[1], jp_sys[2], jp_sys[3];
-		tmp_v << jv_sys[0], jv_sys[1], jv_sys[2], jv_sys[3];
-		tmp_aref << ja_ref[0], ja_ref[1], ja_ref[2], ja_ref[3];
-		tmp_vref << jv_ref[0], jv_ref[1], jv_ref[2], jv_ref[3];
-		tmp_pref << jp_ref[0], jp_ref[1], jp_ref[2], jp_ref[3];
-
-		jt_out_tmp = Eigen::Vector4d::Zero();
-
-		//jt_out_tmp = C_inside + M_inside * (tmp_aref + kp * (tmp_pref) + kd * (tmp_vref));
-		jt_out_tmp = C_inside + M_inside * (tmp_aref + kp * (tmp_pref - tmp_p) + kd * (tmp_vref - tmp_v));
-		
-
-		jt_out[0] = jt_out_tmp[0];
-		jt_out[1] = jt_out_tmp[1];
-		jt_out[2] = jt_out_tmp[2];
-		jt_out[3] = jt_out_tmp[3];
-
-		computedT = jt_out;
-		
-		controljtOutputValue->setData(&jt_out);
-	}
-
-private:
-	DISALLOW_COPY_AND_ASSIGN(jsIDController);
-};
-
 
 class ExtendedRamp : public systems::Ramp {
 public:
@@ -169,12 +56,7 @@ public:
 template<size_t DOF>
 int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam) {
     BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
-	
-	char tmpFile[] = "/tmp/btXXXXXX";
-	if (mkstemp(tmpFile) == -1) {
-		printf("ERROR: Couldn't create temporary file!\n");
-		return 1;
-	}
+
 
 
 	//Moving to start pose
@@ -186,8 +68,8 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	wam.gravityCompensate();
 
 	//Controller gains
-	Eigen::Vector4d kp,kd;
-	//Reg
+	Eigen::Matrix<double, DOF, 1> kp,kd;
+	//Reg (four entries, like every pose below: this program is for the 4-DOF WAM)
 	kp<< 90, 120,  330,  45;
 	kd<< 15,   15,   20,  6;
 
@@ -198,7 +80,7 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 
 	//Instantiating controller and dynamics
 	jsIDController<DOF> compTorqueController(kp.asDiagonal(),kd.asDiagonal());
-	Dynamics<DOF> wam4dofDynamics;
+	RNEADynamics<DOF> wamDynamics(pm.getConfig().lookup(pm.getWamDefaultConfigPath()));
 
 	//Changing velocity limits
 	pm.getSafetyModule()->setVelocityLimit(1.2);
@@ -217,7 +99,14 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	jp_type theta_des; //desired position for regulation
 	jv_type thetad_des; //desired vel for const. vel. trj.
 
-	systems::System* refTraj = nullptr; // Declare raw ptr
+	//goal pose and limits for the point-to-point profiles
+	jp_type goal_pose;
+	goal_pose << 0.0, 0.8, 1.0, 1.6;
+	jv_type thetad_max(0.5);
+	ja_type thetadd_max(1.0);
+	const double MIN_JERK_DURATION = 3.0;
+
+	refTrajectory<DOF, jp_type, jv_type, ja_type>* refTraj = nullptr; // Declare raw ptr
 	bool trjSet = false;
 	char trj;
 	std::string lineInput;
@@ -227,6 +116,8 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 		printf("  1  Regulation \n");
 		printf("  2  Constant velocity profile\n");
 		printf("  3  Trapezoidal velocity profile\n");
+		printf("  4  Minimum-jerk profile\n");
+		printf("  5  Via points (quintic segments)\n");
 
 		std::getline(std::cin, lineInput);
 
@@ -244,12 +135,44 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 
 			case('2'):{
 				thetad_des << 0.0, 0.0, 0, 0.1;
-				refTraj = new constVelRefTrajectory<DOF, jp_type, jv_type, ja_type>(thetad_des, start_pose);
+				refTraj = new constVelRefTrajectory<DOF, jp_type, jv_type, ja_type>(start_pose, thetad_des);
 
 				trjSet = true;
 				trj = 'c'; //constant vel.
 			}
 			break;
+
+			case('3'):{
+				refTraj = new trapezoidalRefTrajectory<DOF, jp_type, jv_type, ja_type>(start_pose, goal_pose, thetad_max, thetadd_max);
+
+				trjSet = true;
+				trj = 'p'; //point to point
+			}
+			break;
+
+			case('4'):{
+				refTraj = new minJerkRefTrajectory<DOF, jp_type, jv_type, ja_type>(start_pose, goal_pose, MIN_JERK_DURATION);
+
+				trjSet = true;
+				trj = 'p';
+			}
+			break;
+
+			case('5'):{
+				jp_type via_pose;
+				via_pose << 0.5, 0.8, 0.5, 1.6;
+				std::vector<jp_type> via_points;
+				via_points.push_back(start_pose);
+				via_points.push_back(via_pose);
+				via_points.push_back(goal_pose);
+				via_points.push_back(start_pose);
+				std::vector<double> durations(3, MIN_JERK_DURATION);
+				refTraj = new viaPointRefTrajectory<DOF, jp_type, jv_type, ja_type>(via_points, durations);
+
+				trjSet = true;
+				trj = 'p';
+			}
+			break;
 		}
 
 		if (trjSet) {
@@ -260,27 +183,14 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	systems::TupleGrouper<double, jp_type, jv_type, ja_type, jp_type, jv_type, jt_type, jt_type> tg;
 	systems::connect(time.output, tg.template getInput<0>());
 	
-	if (auto regRefTraj = dynamic_cast<regulationRefTrajectory<DOF, jp_type, jv_type, ja_type>*>(refTraj)) {
-		systems::connect(time.output, regRefTraj->timef);
-		systems::connect(regRefTraj->referencePTrack, compTorqueController.refJPInput);
-		systems::connect(regRefTraj->referenceVTrack, compTorqueController.refJVInput);
-		systems::connect(regRefTraj->referenceATrack, compTorqueController.refJAInput);
-
-		systems::connect(regRefTraj->referencePTrack, tg.template getInput<1>());
-		systems::connect(regRefTraj->referenceVTrack, tg.template getInput<2>());
-		systems::connect(regRefTraj->referenceATrack, tg.template getInput<3>());
-
-	} else if (auto constRefTraj = dynamic_cast<constVelRefTrajectory<DOF, jp_type, jv_type, ja_type>*>(refTraj)) {
-		systems::connect(time.output, constRefTraj->timef);
-		systems::connect(constRefTraj->referencePTrack, compTorqueController.refJPInput);
-		systems::connect(constRefTraj->referenceVTrack, compTorqueController.refJVInput);
-		systems::connect(constRefTraj->referenceATrack, compTorqueController.refJAInput);
-
-		systems::connect(constRefTraj->referencePTrack, tg.template getInput<1>());
-		systems::connect(constRefTraj->referenceVTrack, tg.template getInput<2>());
-		systems::connect(constRefTraj->referenceATrack, tg.template getInput<3>());
-		
-	} 
+	systems::connect(time.output, refTraj->timef);
+	systems::connect(refTraj->referencePTrack, compTorqueController.refJPInput);
+	systems::connect(refTraj->referenceVTrack, compTorqueController.refJVInput);
+	systems::connect(refTraj->referenceATrack, compTorqueController.refJAInput);
+
+	systems::connect(refTraj->referencePTrack, tg.template getInput<1>());
+	systems::connect(refTraj->referenceVTrack, tg.template getInput<2>());
+	systems::connect(refTraj->referenceATrack, tg.template getInput<3>());
 
 	systems::connect(wam.jpOutput, compTorqueController.feedbackjpInput);
 	systems::connect(wam.jvOutput, compTorqueController.feedbackjvInput);
@@ -288,14 +198,14 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	systems::connect(wam.jpOutput, tg.template getInput<4>());
 	systems::connect(wam.jvOutput, tg.template getInput<5>());
 
-	systems::connect(wam.jpOutput, wam4dofDynamics.jpInputDynamics);
-	systems::connect(wam.jvOutput, wam4dofDynamics.jvInputDynamics);
+	systems::connect(wam.jpOutput, wamDynamics.jpInputDynamics);
+	systems::connect(wam.jvOutput, wamDynamics.jvInputDynamics);
 
-	systems::connect(wam4dofDynamics.MassMAtrixOutput, compTorqueController.M);
-	systems::connect(wam4dofDynamics.CVectorOutput, compTorqueController.C);
+	systems::connect(wamDynamics.MassMAtrixOutput, compTorqueController.M);
+	systems::connect(wamDynamics.CVectorOutput, compTorqueController.C);
 
-	//systems::connect(wam4dofDynamics.MassMAtrixOutput, tg.template getInput<6>());
-	//systems::connect(wam4dofDynamics.CVectorOutput, tg.template getInput<7>());
+	//systems::connect(wamDynamics.MassMAtrixOutput, tg.template getInput<6>());
+	//systems::connect(wamDynamics.CVectorOutput, tg.template getInput<7>());
 
 	systems::connect(compTorqueController.controlJtOutput, jtSat.input);
 	
@@ -306,10 +216,14 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 
 	typedef boost::tuple<double, jp_type, jv_type, ja_type, jp_type, jv_type, jt_type, jt_type> tuple_type;
 	const size_t PERIOD_MULTIPLIER = 1;
-	systems::PeriodicDataLogger<tuple_type> logger(
-			pm.getExecutionManager(),
-			new log::RealTimeWriter<tuple_type>(tmpFile, PERIOD_MULTIPLIER * pm.getExecutionManager()->getPeriod()),
-			PERIOD_MULTIPLIER);
+	const char* columns[] = {"Time", "RefJointPosition", "RefJointVelocity", "RefJointAcceleration",
+			"RealJointPosition", "RealJointVelocity", "JointTorqueCommand", "JointTorqueWithGravity"};
+	ColumnarLogger<tuple_type> logger(pm.getExecutionManager(), argv[1],
+			std::vector<std::string>(columns, columns + 8), PERIOD_MULTIPLIER);
+	if ( !logger.isLogging()) {
+		printf("Error opening the output file: %s\n", argv[1]);
+		return 1;
+	}
 
 
 	time.reset();
@@ -350,6 +264,10 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 			std::cout << "position error:" <<  theta_des << std::endl;
 			std::cout << "time:" << t << std::endl;}
 
+		else if(trj == 'p')
+			{theta_des = compTorqueController.refJPInput.getValue();
+			std::cout << "tracking error:" << theta_des - wam.getJointPositions() << std::endl;}
+
 
 		btsleep(0.2);
 
@@ -364,24 +282,12 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 
 	logger.closeLog();
 	printf("Logging stopped.\n");
-
-	// Open the output file in append mode to add header line and write data
-	std::ofstream outputFile(argv[1], std::ios_base::app);
-
-	// Check if the file is successfully opened
-	if (!outputFile.is_open()) {
-		printf("Error opening the output file: %s\n", argv[1]);
-		return 1;
+	if (logger.droppedRecords() > 0) {
+		printf("WARNING: %llu records were dropped.\n", static_cast<unsigned long long>(logger.droppedRecords()));
 	}
 
-	// Write the header line to the file
-	outputFile << "Time, RefJointPosition, RefJointsVelocity, RefJointsAcceleration, RealJointPosition, RealJointsVelocity, RealJointVelocities3, JointTorquesControllerCommand, JointTorquesCommandswithGravity" << std::endl;
-
-	log::Reader<tuple_type> lr(tmpFile);
-	lr.exportCSV(outputFile);
+	// Binary (trajectory_file.h); trajectory_converter exports it as CSV
 	printf("Output written to %s.\n", argv[1]);
-	std::remove(tmpFile);
-	outputFile.close();
 
 	
 	waitForEnter();
@@ -0,0 +1,243 @@
+/*
+ * wam_sim_benchmark.cpp
+ *
+ * Closed-loop benchmark of the joint-space ID controller against
+ * SimulatedWam, without hardware or ROS:
+ *
+ *   wam_sim_benchmark [config=/etc/barrett/default.conf] [group=wam4] [seconds=10]
+ *                     [trials=1] [surface.conf]
+ *
+ * The execution graph is stepped by a ManualExecutionManager as fast as it
+ * evaluates. Trials after the first start from randomly perturbed (but
+ * reproducible) poses. With a surface config (e.g.
+ * wam_control_common/config/contact_surfaces.conf) the tool collides with
+ * those surfaces, see contact_surface.h, and the contact force is also
+ * estimated the way the real programs do it: StaticForceEstimatorwithG on
+ * jtSum and the MomentumObserver residual.
+ *
+ * Prints simulated vs. wall time, the regulation error, contact statistics,
+ * the error of both force estimates against ContactSurface::forceOutput
+ * while in contact, and the operate() timing of the controller's systems;
+ * exits non-zero if the arm did not settle (without surfaces).
+ */
+
+
+#include <wam_control_common/rnea_dynamics.h>
+#include <js_id_controller.hpp>
+#include <wam_control_common/simulated_wam.h>
+#include <wam_control_common/operate_timing.h>
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/contact_surface.h>
+#include <wam_control_common/static_force_estimator_withg.h>
+#include <wam_control_common/momentum_observer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <libconfig.h++>
+#include <boost/bind.hpp>
+#include <barrett/os.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+
+using namespace barrett;
+
+static const double T_S = 0.002;			// [s] control period, as on the WAM
+static const double SETTLED_ERROR = 0.01;	// [rad] largest final joint error that passes
+static const double MOMENTUM_OBSERVER_GAIN = 150.0;	// [1/s] as in planar_surface_hybrid_control
+
+template<size_t DOF>
+int run(const libconfig::Setting& wamSetting, double duration, int trials, const libconfig::Setting* surfaceSetting) {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+	systems::ManualExecutionManager mem(T_S);
+
+	jp_type homePose(0.0), targetPose(0.0);
+	homePose.template head<4>() << 0.5, 0.5, 1.0, 1.0;
+	SimulatedWam<DOF> wam(wamSetting, homePose, &mem);
+	wam.gravityCompensate();
+
+	//Controller gains, as in wam_joint_space_ID_controller_4dof
+	Eigen::Matrix<double, DOF, 1> kp, kd;
+	kp.setConstant(25.0);
+	kd.setConstant(3.0);
+	kp.template head<4>() << 90, 120, 330, 45;
+	kd.template head<4>() << 15, 15, 20, 6;
+
+	GraphTimer graphTimer;
+	Timed<jsIDController<DOF> > compTorqueController(kp.asDiagonal(), kd.asDiagonal());
+	Timed<RNEADynamics<DOF> > wamDynamics(wamSetting);
+	graphTimer.track(compTorqueController);
+	graphTimer.track(wamDynamics);
+
+	systems::Constant<jp_type> refJP(targetPose);
+	systems::Constant<jv_type> refJV(jv_type(0.0));
+	systems::Constant<ja_type> refJA(ja_type(0.0));
+
+	jt_type jtLimits(30.0);
+	systems::Callback<jt_type> jtSat(boost::bind(SaturateJointTorque<DOF>, _1, jtLimits));
+
+	systems::connect(refJP.output, compTorqueController.refJPInput);
+	systems::connect(refJV.output, compTorqueController.refJVInput);
+	systems::connect(refJA.output, compTorqueController.refJAInput);
+	systems::connect(wam.jpOutput, compTorqueController.feedbackjpInput);
+	systems::connect(wam.jvOutput, compTorqueController.feedbackjvInput);
+	systems::connect(wam.jpOutput, wamDynamics.jpInputDynamics);
+	systems::connect(wam.jvOutput, wamDynamics.jvInputDynamics);
+	systems::connect(wamDynamics.MassMAtrixOutput, compTorqueController.M);
+	systems::connect(wamDynamics.CVectorOutput, compTorqueController.C);
+	systems::connect(compTorqueController.controlJtOutput, jtSat.input);
+	wam.trackReferenceSignal(jtSat.output);
+	mem.startManaging(graphTimer);
+
+	//Contact with the simulated surfaces, fed back as an external joint torque
+	KinematicsBundle<DOF> kinematics;
+	Timed<ContactSurface<DOF> > surface;
+	//Both estimate the force the tool applies, i.e. minus surface.forceOutput
+	Timed<StaticForceEstimatorwithG<DOF> > staticEstimator;
+	Timed<MomentumObserver<DOF> > momentumObserver((v_type(MOMENTUM_OBSERVER_GAIN)));
+	if (surfaceSetting != NULL) {
+		if ( !surface.configure(*surfaceSetting)) {
+			printf("Unknown contact patch type in the surface config\n");
+			return 2;
+		}
+		graphTimer.track(surface);
+		systems::connect(wam.kinematicsBase.kinOutput, kinematics.kinInput);
+		systems::connect(kinematics.output, surface.kinematicsInput);
+		systems::connect(surface.jtOutput, wam.sink.externalTorqueInput);
+
+		systems::connect(wam.jtSum.output, staticEstimator.jtInput);
+		systems::connect(kinematics.output, staticEstimator.kinematicsInput);
+		systems::connect(wam.gravity.output, staticEstimator.g);
+
+		systems::connect(wam.jvOutput, momentumObserver.jvInput);
+		systems::connect(wam.jtSum.output, momentumObserver.jtInput);
+		systems::connect(wamDynamics.MassMAtrixOutput, momentumObserver.M);
+		systems::connect(wamDynamics.CVectorOutput, momentumObserver.C);
+		systems::connect(kinematics.output, momentumObserver.kinematicsInput);
+		systems::connect(wam.gravity.output, momentumObserver.g);
+
+		mem.startManaging(staticEstimator);
+		mem.startManaging(momentumObserver);	// integrates, has to run every tick
+		graphTimer.track(staticEstimator);
+		graphTimer.track(momentumObserver);
+	}
+
+	//Each trial starts at rest from homePose perturbed by up to START_SPREAD
+	const double START_SPREAD = 0.3;
+	srand(1);
+
+	const size_t ticks = static_cast<size_t>(duration / T_S);
+	double sumSquaredError = 0.0, worstFinalError = 0.0;
+	size_t contactTicks = 0;
+	double peakForce = 0.0;
+	double sumSquaredForce = 0.0;
+	double sumSquaredStaticError = 0.0, peakStaticError = 0.0;
+	double sumSquaredObserverError = 0.0, peakObserverError = 0.0;
+	double wall = 0.0;
+	for (int trial = 0; trial < trials; ++trial) {
+		jp_type startPose = homePose;
+		if (trial > 0) {
+			for (size_t j = 0; j < DOF; ++j) {
+				startPose[j] += START_SPREAD * (2.0 * rand() / RAND_MAX - 1.0);
+			}
+		}
+		wam.setJointState(startPose);
+		momentumObserver.reset();	// the teleport isn't a momentum change
+
+		const double start = highResolutionSystemTime();
+		for (size_t i = 0; i < ticks; ++i) {
+			mem.runExecutionCycle();
+			sumSquaredError += (targetPose - wam.plant.jointPositions()).squaredNorm();
+			if (surfaceSetting != NULL && surface.inContact()) {
+				++contactTicks;
+				const cf_type force = surface.getForce();
+				peakForce = std::max(peakForce, force.norm());
+				sumSquaredForce += force.squaredNorm();
+
+				const double staticError = (staticEstimator.computedF + force).norm();
+				const double observerError = (momentumObserver.computedF + force).norm();
+				sumSquaredStaticError += staticError * staticError;
+				peakStaticError = std::max(peakStaticError, staticError);
+				sumSquaredObserverError += observerError * observerError;
+				peakObserverError = std::max(peakObserverError, observerError);
+			}
+		}
+		wall += highResolutionSystemTime() - start;
+		worstFinalError = std::max(worstFinalError, (targetPose - wam.plant.jointPositions()).cwiseAbs().maxCoeff());
+	}
+
+	const double simulated = trials * ticks * T_S;
+	printf("%zu-DOF, %d trial(s) of %zu ticks of %.0f us\n", DOF, trials, ticks, T_S * 1e6);
+	printf("simulated %.2f s in %.3f s wall (%.1fx real time)\n", simulated, wall, simulated / wall);
+	printf("worst final joint error %.5f rad, RMS %.5f rad\n", worstFinalError,
+			std::sqrt(sumSquaredError / (trials * ticks * DOF)));
+	if (surfaceSetting != NULL) {
+		printf("%zu contact patch(es): in contact %.1f%% of the time, peak force %.2f N\n", surface.size(),
+				100.0 * contactTicks / (trials * ticks), peakForce);
+		if (contactTicks > 0) {
+			printf("contact force RMS %.2f N; estimate error RMS / peak: static %.2f / %.2f N, momentum observer %.2f / %.2f N\n",
+					std::sqrt(sumSquaredForce / contactTicks),
+					std::sqrt(sumSquaredStaticError / contactTicks), peakStaticError,
+					std::sqrt(sumSquaredObserverError / contactTicks), peakObserverError);
+		}
+	}
+	printf("\n%s", graphTimer.report().c_str());
+
+	wam.idle();
+	//With surfaces in the way the target may be unreachable; only report then
+	return (surfaceSetting != NULL || worstFinalError <= SETTLED_ERROR) ? 0 : 1;
+}
+
+static bool readConfig(libconfig::Config& config, const char* path) {
+	try {
+		const std::string p(path);
+		const size_t slash = p.find_last_of('/');
+		if (slash != std::string::npos) {
+			config.setIncludeDir(p.substr(0, slash).c_str());	// default.conf @includes the per-arm files
+		}
+		config.readFile(path);
+	} catch (const libconfig::FileIOException&) {
+		printf("Couldn't read %s\n", path);
+		return false;
+	} catch (const libconfig::ParseException& e) {
+		printf("%s:%d: %s\n", e.getFile(), e.getLine(), e.getError());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	const char* configPath = argc > 1 ? argv[1] : "/etc/barrett/default.conf";
+	const char* group = argc > 2 ? argv[2] : "wam4";
+	const double duration = argc > 3 ? atof(argv[3]) : 10.0;
+	const int trials = argc > 4 ? std::max(1, atoi(argv[4])) : 1;
+	const char* surfacePath = argc > 5 ? argv[5] : NULL;
+
+	libconfig::Config config, surfaceConfig;
+	if ( !readConfig(config, configPath) || (surfacePath != NULL && !readConfig(surfaceConfig, surfacePath))) {
+		return 2;
+	}
+	if ( !config.exists(group)) {
+		printf("%s has no group \"%s\"\n", configPath, group);
+		return 2;
+	}
+
+	if (surfacePath != NULL && !surfaceConfig.exists("surface")) {
+		printf("%s has no \"surface\" list\n", surfacePath);
+		return 2;
+	}
+	const libconfig::Setting* surfaceSetting = surfacePath != NULL ? &surfaceConfig.lookup("surface") : NULL;
+
+	const libconfig::Setting& wamSetting = config.lookup(group);
+	switch (wamSetting["kinematics"]["moving"].getLength()) {
+	case 4:
+		return run<4>(wamSetting, duration, trials, surfaceSetting);
+	case 7:
+		return run<7>(wamSetting, duration, trials, surfaceSetting);
+	default:
+		printf("Group \"%s\" is neither a 4-DOF nor a 7-DOF WAM\n", group);
+		return 2;
+	}
+}
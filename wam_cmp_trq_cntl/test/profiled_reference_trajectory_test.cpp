@@ -0,0 +1,236 @@
+/*
+ * profiled_reference_trajectory_test.cpp
+ *
+ * Boundary conditions, limits and p/v/a consistency of the generators in
+ * profiled_reference_trajectory.hpp, sampled through their ports under a
+ * ManualExecutionManager.
+ */
+
+#include <profiled_reference_trajectory.hpp>
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+
+using namespace barrett;
+
+namespace {
+
+typedef units::JointPositions<4>::type jp_type;
+typedef units::JointVelocities<4>::type jv_type;
+typedef units::JointAccelerations<4>::type ja_type;
+typedef refTrajectory<4, jp_type, jv_type, ja_type> generator_type;
+
+const double T_S = 0.002;	// [s] as on the WAM
+const double TOLERANCE = 1e-9;
+
+// Latches its input every tick so the outputs can be read back
+template<typename T>
+class Sink : public systems::System {
+public:
+	Input<T> input;
+	T value;
+
+	Sink() : System("Sink"), input(this) {}
+	virtual ~Sink() { this->mandatoryCleanUp(); }
+
+protected:
+	virtual void operate() { value = input.getValue(); }
+};
+
+// Evaluates a generator at arbitrary times through its ports
+class Sampler {
+public:
+	explicit Sampler(generator_type& generator) : mem(T_S) {
+		systems::connect(time.output, generator.timef);
+		systems::connect(generator.referencePTrack, p.input);
+		systems::connect(generator.referenceVTrack, v.input);
+		systems::connect(generator.referenceATrack, a.input);
+		mem.startManaging(p);
+		mem.startManaging(v);
+		mem.startManaging(a);
+	}
+
+	void at(double t) {
+		time.setValue(t);
+		mem.runExecutionCycle();
+	}
+
+	systems::ManualExecutionManager mem;
+	systems::ExposedOutput<double> time;
+	Sink<jp_type> p;
+	Sink<jv_type> v;
+	Sink<ja_type> a;
+};
+
+// Central differences of p and v over the whole trajectory must match v and a
+// except within one step of the instants listed in `corners`, where the
+// acceleration is allowed to step.
+void checkConsistent(generator_type& generator, double T, const std::vector<double>& corners = std::vector<double>()) {
+	Sampler s(generator);
+	const double h = 1e-5;
+	for (double t = h; t < T - h; t += T / 97.0) {
+		bool nearCorner = false;
+		for (size_t k = 0; k < corners.size(); ++k) {
+			nearCorner = nearCorner || std::fabs(t - corners[k]) <= h;
+		}
+		if (nearCorner) {
+			continue;
+		}
+		s.at(t - h);
+		const jp_type p0 = s.p.value;
+		const jv_type v0 = s.v.value;
+		s.at(t + h);
+		const jp_type p1 = s.p.value;
+		const jv_type v1 = s.v.value;
+		s.at(t);
+		for (size_t j = 0; j < 4; ++j) {
+			EXPECT_NEAR((p1[j] - p0[j]) / (2.0 * h), s.v.value[j], 1e-6) << "t = " << t;
+			EXPECT_NEAR((v1[j] - v0[j]) / (2.0 * h), s.a.value[j], 1e-5) << "t = " << t;
+		}
+	}
+}
+
+TEST(QuinticSegment, MeetsBoundaryConditions) {
+	const jp_type p0(0.1), p1(-0.4);
+	const jv_type v0(0.5), v1(-1.0);
+	const ja_type a0(2.0), a1(0.0);
+	const quinticSegment<jp_type, jv_type, ja_type> segment(p0, v0, a0, p1, v1, a1, 0.8);
+
+	// evaluate() holds the end points outside (0, T), so probe just inside
+	jp_type p;
+	jv_type v;
+	ja_type a;
+	const double e = 1e-9;
+	segment.evaluate(e, p, v, a);
+	for (size_t j = 0; j < 4; ++j) {
+		EXPECT_NEAR(p0[j], p[j], 1e-8);
+		EXPECT_NEAR(v0[j], v[j], 1e-7);
+		EXPECT_NEAR(a0[j], a[j], 1e-6);
+	}
+	segment.evaluate(0.8 - e, p, v, a);
+	for (size_t j = 0; j < 4; ++j) {
+		EXPECT_NEAR(p1[j], p[j], 1e-8);
+		EXPECT_NEAR(v1[j], v[j], 1e-7);
+		EXPECT_NEAR(a1[j], a[j], 1e-6);
+	}
+}
+
+TEST(TrapezoidalRefTrajectory, RespectsLimitsAndReachesGoal) {
+	jp_type start, goal;
+	start << 0.0, 0.5, -1.0, 1.0;
+	goal << 1.0, 0.5, 0.0, -1.0;
+	const jv_type vMax(0.8);
+	const ja_type aMax(2.0);
+	trapezoidalRefTrajectory<4, jp_type, jv_type, ja_type> trajectory(start, goal, vMax, aMax);
+
+	// axis 3 moves furthest (2 rad) and sets the timing: 0.4 s ramps, 2.9 s in all
+	const double T = trajectory.getDuration();
+	EXPECT_NEAR(0.8 / 2.0 + 2.0 / 0.8, T, TOLERANCE);
+
+	Sampler s(trajectory);
+	for (double t = -0.1; t <= T + 0.1; t += T_S) {
+		s.at(t);
+		for (size_t j = 0; j < 4; ++j) {
+			EXPECT_LE(std::fabs(s.v.value[j]), vMax[j] + TOLERANCE) << "t = " << t;
+			EXPECT_LE(std::fabs(s.a.value[j]), aMax[j] + TOLERANCE) << "t = " << t;
+		}
+	}
+	s.at(T + 0.1);
+	for (size_t j = 0; j < 4; ++j) {
+		EXPECT_NEAR(goal[j], s.p.value[j], TOLERANCE);
+		EXPECT_EQ(0.0, s.v.value[j]);
+	}
+
+	std::vector<double> corners;
+	corners.push_back(0.4);
+	corners.push_back(T - 0.4);
+	checkConsistent(trajectory, T, corners);
+}
+
+TEST(TrapezoidalRefTrajectory, ShortMoveIsTriangular) {
+	const jp_type start(0.0), goal(0.02);
+	trapezoidalRefTrajectory<4, jp_type, jv_type, ja_type> trajectory(start, goal, jv_type(1.0), ja_type(2.0));
+
+	// 0.02 rad at 2 rad/s^2 peaks at 0.2 rad/s, far below the limit
+	const double T = trajectory.getDuration();
+	EXPECT_NEAR(2.0 * std::sqrt(0.02 / 2.0), T, TOLERANCE);
+
+	Sampler s(trajectory);
+	s.at(T / 2.0);
+	EXPECT_NEAR(0.01, s.p.value[0], TOLERANCE);
+	EXPECT_NEAR(0.2, s.v.value[0], TOLERANCE);
+}
+
+TEST(MinJerkRefTrajectory, IsSymmetricWithTextbookPeakVelocity) {
+	const jp_type start(-0.5), goal(1.5);
+	const double T = 2.0;
+	minJerkRefTrajectory<4, jp_type, jv_type, ja_type> trajectory(start, goal, T);
+
+	Sampler s(trajectory);
+	s.at(T / 2.0);
+	for (size_t j = 0; j < 4; ++j) {
+		EXPECT_NEAR(0.5, s.p.value[j], TOLERANCE);
+		EXPECT_NEAR(1.875 * 2.0 / T, s.v.value[j], TOLERANCE);	// 15/8 of the mean speed
+		EXPECT_NEAR(0.0, s.a.value[j], TOLERANCE);
+	}
+	s.at(T);
+	for (size_t j = 0; j < 4; ++j) {
+		EXPECT_NEAR(goal[j], s.p.value[j], TOLERANCE);
+	}
+	checkConsistent(trajectory, T);
+}
+
+TEST(ViaPointRefTrajectory, PassesViaPointsContinuously) {
+	std::vector<jp_type> points(4);
+	points[0] << 0.0, 0.0, 0.0, 0.0;
+	points[1] << 0.5, 0.2, -0.3, 0.1;
+	points[2] << 1.0, -0.2, -0.6, 0.1;
+	points[3] << 1.2, 0.0, 0.0, 0.0;
+	std::vector<double> durations;
+	durations.push_back(1.0);
+	durations.push_back(0.5);
+	durations.push_back(1.5);
+	viaPointRefTrajectory<4, jp_type, jv_type, ja_type> trajectory(points, durations);
+	EXPECT_NEAR(3.0, trajectory.getDuration(), TOLERANCE);
+
+	Sampler s(trajectory);
+	double t = 0.0;
+	for (size_t k = 0; k < points.size(); ++k) {
+		s.at(t);
+		for (size_t j = 0; j < 4; ++j) {
+			EXPECT_NEAR(points[k][j], s.p.value[j], TOLERANCE) << "via point " << k;
+		}
+		if (k < durations.size()) {
+			t += durations[k];
+		}
+	}
+	s.at(3.0);
+	for (size_t j = 0; j < 4; ++j) {
+		EXPECT_EQ(0.0, s.v.value[j]);
+	}
+
+	// p, v and a continuous across the segment boundaries
+	for (double b = 1.0; b < 2.0; b += 0.5) {
+		const double e = 1e-7;
+		s.at(b - e);
+		const jp_type p0 = s.p.value;
+		const jv_type v0 = s.v.value;
+		const ja_type a0 = s.a.value;
+		s.at(b + e);
+		for (size_t j = 0; j < 4; ++j) {
+			EXPECT_NEAR(p0[j], s.p.value[j], 1e-6) << "t = " << b;
+			EXPECT_NEAR(v0[j], s.v.value[j], 1e-5) << "t = " << b;
+			EXPECT_NEAR(a0[j], s.a.value[j], 1e-4) << "t = " << b;
+		}
+	}
+	checkConsistent(trajectory, 3.0);
+}
+
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
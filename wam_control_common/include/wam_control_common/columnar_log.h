@@ -0,0 +1,350 @@
+/*
+ * columnar_log.h
+ *
+ * Logging from the real-time thread straight into the binary format of
+ * trajectory_file.h (version 2), in place of PeriodicDataLogger +
+ * RealTimeWriter and the log::Reader::exportCSV() pass after it.
+ *
+ * ColumnarLogger<T> flattens every periodMultiplier-th input tuple into one
+ * record of doubles, with a schema column per tuple element (a double or a
+ * fixed-size vector/matrix such as cp_type or jp_type), and pushes it into a
+ * single-producer single-consumer ring. A writer thread drains the ring to
+ * the file, so operate() only copies the record: no lock, allocation or
+ * system call. If the writer falls more than RING_SECONDS behind, records
+ * are dropped and counted instead of stalling the control loop.
+ *
+ * closeLog() drains the ring and fills in the row count. The file can be
+ * mmapped with TrajectoryFile as it is (also while it is still being
+ * written), so there is no export step and a log can run for hours at the
+ * full loop rate.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/thread.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <eigen3/Eigen/Core>
+#include <barrett/os.h>
+#include <barrett/math/matrix.h>
+#include <barrett/systems/abstract/system.h>
+#include <barrett/systems/abstract/single_io.h>
+#include <barrett/systems/abstract/execution_manager.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/trajectory_file.h>
+
+using namespace barrett;
+
+// Width and flattening of one tuple element.
+template<typename T> struct LogColumn;
+
+template<> struct LogColumn<double> {
+	static const size_t WIDTH = 1;
+	static void copy(const double& x, double* out) { *out = x; }
+};
+
+template<int R, int C, typename Units> struct LogColumn<math::Matrix<R, C, Units> > {
+	static const size_t WIDTH = R * C;
+	static void copy(const math::Matrix<R, C, Units>& x, double* out) {
+		Eigen::Map<Eigen::Matrix<double, R, C> > m(out);
+		m = x;
+	}
+};
+
+template<int R, int C, int Options> struct LogColumn<Eigen::Matrix<double, R, C, Options> > {
+	static const size_t WIDTH = R * C;
+	static void copy(const Eigen::Matrix<double, R, C, Options>& x, double* out) {
+		Eigen::Map<Eigen::Matrix<double, R, C> > m(out);
+		m = x;
+	}
+};
+
+// A boost::tuple of the above, element I onwards.
+template<typename Tuple, size_t I = 0, size_t N = boost::tuples::length<Tuple>::value>
+struct LogRecord {
+	typedef LogColumn<typename boost::tuples::element<I, Tuple>::type> column_type;
+	typedef LogRecord<Tuple, I + 1, N> rest_type;
+
+	static const size_t COLUMNS = N - I;
+	static const size_t WIDTH = column_type::WIDTH + rest_type::WIDTH;
+
+	static void copy(const Tuple& t, double* out) {
+		column_type::copy(boost::tuples::get<I>(t), out);
+		rest_type::copy(t, out + column_type::WIDTH);
+	}
+
+	static void widths(std::vector<uint32_t>& w) {
+		w.push_back(column_type::WIDTH);
+		rest_type::widths(w);
+	}
+};
+
+template<typename Tuple, size_t N>
+struct LogRecord<Tuple, N, N> {
+	static const size_t COLUMNS = 0;
+	static const size_t WIDTH = 0;
+	static void copy(const Tuple&, double*) {}
+	static void widths(std::vector<uint32_t>&) {}
+};
+
+
+// Single-producer single-consumer ring of fixed-width records of doubles.
+// push() (the real-time thread) and peek()/pop() (one consumer thread) are
+// wait-free; a full ring drops the record and counts it.
+class RecordRing
+{
+public:
+	// capacity is rounded up to a power of two records.
+	RecordRing(size_t width, size_t capacity) : w(width), mask(0), head(0), tail(0), dropped(0) {
+		size_t n = 1;
+		while (n < capacity) {
+			n <<= 1;
+		}
+		mask = n - 1;
+		buffer.resize(n * w);
+	}
+
+	size_t width() const { return w; }
+
+	bool push(const double* record) {
+		const size_t h = head.load(std::memory_order_relaxed);
+		if (h - tail.load(std::memory_order_acquire) > mask) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		memcpy(&buffer[(h & mask) * w], record, w * sizeof(double));
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// The oldest contiguous run of pushed records, up to the end of the
+	// buffer; returns how many.
+	size_t peek(const double** records) const {
+		const size_t t = tail.load(std::memory_order_relaxed);
+		const size_t first = t & mask;
+		*records = &buffer[first * w];
+		return std::min(head.load(std::memory_order_acquire) - t, mask + 1 - first);
+	}
+
+	void pop(size_t n) { tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release); }
+
+	uint64_t droppedRecords() const { return dropped.load(std::memory_order_relaxed); }
+
+protected:
+	size_t w, mask;
+	std::vector<double> buffer;
+	std::atomic<size_t> head, tail;	// records pushed / consumed, modulo 2^64
+	std::atomic<uint64_t> dropped;
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(RecordRing);
+};
+
+
+// Owns the file, the ring and the writer thread.
+class ColumnarLogWriter
+{
+public:
+	ColumnarLogWriter(const std::string& path, const std::vector<std::string>& names, const std::vector<uint32_t>& widths,
+			size_t capacity) :
+		fd(-1), ring(recordWidth(widths), capacity), rows(0), running(false) {
+		fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd == -1) {
+			return;
+		}
+
+		TrajectoryFileHeader h;
+		memset(&h, 0, sizeof(h));
+		memcpy(h.magic, TRAJECTORY_FILE_MAGIC, sizeof(h.magic));
+		h.version = TRAJECTORY_FILE_VERSION;
+		h.byteOrder = TRAJECTORY_FILE_BYTE_ORDER;
+		h.cols = ring.width();
+		h.schemaBytes = widths.size() * sizeof(TrajectoryFileColumn);
+		h.rows = 0;
+		std::vector<TrajectoryFileColumn> schema(widths.size());
+		for (size_t i = 0; i < widths.size(); ++i) {
+			memset(&schema[i], 0, sizeof(schema[i]));
+			if (i < names.size()) {
+				strncpy(schema[i].name, names[i].c_str(), sizeof(schema[i].name) - 1);
+			} else {
+				snprintf(schema[i].name, sizeof(schema[i].name), "c%zu", i);
+			}
+			schema[i].width = widths[i];
+			schema[i].type = TRAJECTORY_FILE_FLOAT64;
+		}
+		if ( !writeAll(&h, sizeof(h)) || (!schema.empty() && !writeAll(&schema[0], h.schemaBytes))) {
+			::close(fd);
+			fd = -1;
+			return;
+		}
+
+		running.store(true);
+		thread = boost::thread(&ColumnarLogWriter::run, this);
+	}
+
+	~ColumnarLogWriter() { close(); }
+
+	bool isOpen() const { return fd != -1; }
+
+	// Real-time side: copies one record. False (and the record is dropped)
+	// if the ring is full.
+	bool push(const double* record) { return ring.push(record); }
+
+	// Stops the writer thread after it has drained the ring, and writes the
+	// row count into the header.
+	void close() {
+		if (fd == -1) {
+			return;
+		}
+		running.store(false);
+		thread.join();
+		drain();
+
+		const uint64_t n = rows;
+		if (pwrite(fd, &n, sizeof(n), offsetof(TrajectoryFileHeader, rows)) != sizeof(n)) {
+			fprintf(stderr, "ColumnarLogWriter: couldn't write the row count\n");
+		}
+		::close(fd);
+		fd = -1;
+	}
+
+	uint64_t droppedRecords() const { return ring.droppedRecords(); }
+	uint64_t writtenRecords() const { return rows; }	// only after close()
+
+protected:
+	int fd;
+	RecordRing ring;
+	uint64_t rows;
+
+	std::atomic<bool> running;
+	boost::thread thread;
+
+	static size_t recordWidth(const std::vector<uint32_t>& widths) {
+		size_t width = 0;
+		for (size_t i = 0; i < widths.size(); ++i) {
+			width += widths[i];
+		}
+		return width;
+	}
+
+	void run() {
+		while (running.load()) {
+			drain();
+			btsleep(0.01);
+		}
+	}
+
+	// Writes everything pushed so far, in at most two contiguous pieces.
+	void drain() {
+		const double* records;
+		for (size_t n = ring.peek(&records); n > 0; n = ring.peek(&records)) {
+			if ( !writeAll(records, n * ring.width() * sizeof(double))) {
+				fprintf(stderr, "ColumnarLogWriter: write failed, dropping %zu records\n", n);
+			} else {
+				rows += n;
+			}
+			ring.pop(n);
+		}
+	}
+
+	bool writeAll(const void* p, size_t bytes) {
+		const char* c = static_cast<const char*>(p);
+		while (bytes > 0) {
+			const ssize_t n = ::write(fd, c, bytes);
+			if (n <= 0) {
+				return false;
+			}
+			c += n;
+			bytes -= n;
+		}
+		return true;
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(ColumnarLogWriter);
+};
+
+
+template<typename T>
+class ColumnarLogger : public systems::System, public systems::SingleInput<T>
+{
+public:
+	static const double RING_SECONDS;	// [s] of records the writer may fall behind
+
+	// names are the schema column names, one per tuple element. Logs every
+	// periodMultiplier-th execution cycle of em, which starts managing the
+	// logger.
+	ColumnarLogger(systems::ExecutionManager* em, const std::string& path, const std::vector<std::string>& names,
+			size_t periodMultiplier = 10, const std::string& sysName = "ColumnarLogger"):
+		System(sysName), systems::SingleInput<T>(this),
+		writer(path, names, widths(), capacity(em, periodMultiplier)),
+		periodMultiplier(periodMultiplier), ecCount(0), logging(writer.isOpen())
+	{
+		if (em != NULL) {
+			em->startManaging(*this);
+		}
+	}
+
+	virtual ~ColumnarLogger() {
+		this->mandatoryCleanUp();
+		writer.close();
+	}
+
+	bool isLogging() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return logging;
+	}
+
+	// Stops logging and finishes the file. Blocks until the ring is written.
+	void closeLog() {
+		{
+			BARRETT_SCOPED_LOCK(this->getEmMutex());
+			logging = false;
+		}
+		writer.close();
+	}
+
+	uint64_t droppedRecords() const { return writer.droppedRecords(); }
+
+protected:
+	typedef LogRecord<T> record_type;
+
+	ColumnarLogWriter writer;
+	size_t periodMultiplier, ecCount;
+	bool logging;
+	double record[record_type::WIDTH];
+
+	static std::vector<uint32_t> widths() {
+		std::vector<uint32_t> w;
+		record_type::widths(w);
+		return w;
+	}
+
+	static size_t capacity(systems::ExecutionManager* em, size_t periodMultiplier) {
+		const double period = (em != NULL ? em->getPeriod() : 0.002) * periodMultiplier;
+		return static_cast<size_t>(RING_SECONDS / period) + 1;
+	}
+
+	virtual void operate() {
+		if (logging && ++ecCount >= periodMultiplier) {
+			ecCount = 0;
+			record_type::copy(this->input.getValue(), record);
+			writer.push(record);
+		}
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(ColumnarLogger);
+};
+
+template<typename T> const double ColumnarLogger<T>::RING_SECONDS = 10.0;
@@ -0,0 +1,333 @@
+/*
+ * contact_surface.h
+ *
+ * Compliant contact between the tool tip and simulated surfaces, for
+ * exercising surface estimation and hybrid force/position control on
+ * SimulatedWam (simulated_wam.h) instead of a real table.
+ *
+ * A surface is a set of patches (bounded or unbounded planes, spherical caps
+ * and cylinders; several bounded planes make a piecewise surface). Each
+ * patch has its own material. The patch the tool penetrates deepest gives
+ * the contact:
+ *
+ *     f_n = max(0, k d - b v.n)                  (spring-damper, no adhesion)
+ *     f_t = -mu f_n v_t / max(|v_t|, v_slip)     (Coulomb, viscous below v_slip)
+ *
+ * with d the penetration depth, n the outward surface normal, v the tool
+ * velocity and v_t its tangential part. ContactSurface<DOF> applies
+ * f = f_n n + f_t at the tool point; jtOutput (Jv^T f) goes to
+ * SimulatedWam::sink.externalTorqueInput and forceOutput is the ground
+ * truth for the force estimators. Everything is in the WAM base frame.
+ *
+ * Surfaces can be built in code or read from a libconfig list, e.g.
+ *
+ *     surface = (
+ *         { type = "plane"; point = [0.6, 0.0, 0.0]; normal = [0.0, 0.0, 1.0];
+ *           u = [1.0, 0.0, 0.0]; half_extents = [0.2, 0.3];
+ *           stiffness = 5000.0; damping = 30.0; friction = 0.3; },
+ *         { type = "sphere"; center = [0.6, 0.0, -0.4]; radius = 0.45; concave = false;
+ *           axis = [0.0, 0.0, 1.0]; half_angle = 0.5; stiffness = 3000.0; }
+ *     );
+ *
+ * (see config/contact_surfaces.conf for all keys and their defaults).
+ */
+
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <libconfig.h++>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+#include <barrett/detail/libconfig_utils.h>
+
+#include <wam_control_common/kinematics_bundle.h>
+
+using namespace barrett;
+
+struct ContactMaterial
+{
+	double stiffness;		// [N/m]
+	double damping;			// [N s/m]
+	double friction;		// Coulomb coefficient
+	double slipVelocity;	// [m/s] below this friction is viscous
+
+	ContactMaterial(double k = 5000.0, double b = 30.0, double mu = 0.3, double vSlip = 0.005) :
+		stiffness(k), damping(b), friction(mu), slipVelocity(vSlip) {}
+};
+
+class ContactPatch
+{
+public:
+	// Contacts deeper than maxDepth are ignored, so that the far side of a
+	// thin patch doesn't pull the tool through.
+	explicit ContactPatch(const ContactMaterial& material, double maxDepth = 0.05) :
+		material(material), maxDepth(maxDepth) {}
+	virtual ~ContactPatch() {}
+
+	// True if p is inside the patch; depth > 0 and normal is the outward
+	// unit normal of the closest surface point.
+	virtual bool penetration(const Eigen::Vector3d& p, double& depth, Eigen::Vector3d& normal) const = 0;
+
+	ContactMaterial material;
+	double maxDepth;
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// Plane through point with outward normal. With positive halfExtents it is
+// the rectangle spanned by u and normal x u around point.
+class PlanePatch : public ContactPatch
+{
+public:
+	PlanePatch(const Eigen::Vector3d& point, const Eigen::Vector3d& normal, const ContactMaterial& material,
+			const Eigen::Vector3d& u = Eigen::Vector3d::UnitX(), const Eigen::Vector2d& halfExtents = Eigen::Vector2d::Zero(),
+			double maxDepth = 0.05) :
+		ContactPatch(material, maxDepth), point(point), n(normal.normalized()), halfExtents(halfExtents) {
+		this->u = (u - u.dot(n) * n).normalized();
+		v = n.cross(this->u);
+	}
+
+	virtual bool penetration(const Eigen::Vector3d& p, double& depth, Eigen::Vector3d& normal) const {
+		const Eigen::Vector3d r = p - point;
+		depth = -r.dot(n);
+		if (depth <= 0.0 || depth > maxDepth) {
+			return false;
+		}
+		if (halfExtents[0] > 0.0 && std::fabs(r.dot(u)) > halfExtents[0]) {
+			return false;
+		}
+		if (halfExtents[1] > 0.0 && std::fabs(r.dot(v)) > halfExtents[1]) {
+			return false;
+		}
+		normal = n;
+		return true;
+	}
+
+protected:
+	Eigen::Vector3d point, n, u, v;
+	Eigen::Vector2d halfExtents;
+};
+
+// Sphere of radius around center, solid inside (convex) or outside (concave,
+// a bowl). Limited to the cap within halfAngle of axis if halfAngle < pi.
+class SpherePatch : public ContactPatch
+{
+public:
+	SpherePatch(const Eigen::Vector3d& center, double radius, bool concave, const ContactMaterial& material,
+			const Eigen::Vector3d& axis = Eigen::Vector3d::UnitZ(), double halfAngle = M_PI, double maxDepth = 0.05) :
+		ContactPatch(material, maxDepth), center(center), radius(radius), concave(concave),
+		axis(axis.normalized()), cosHalfAngle(std::cos(halfAngle)) {}
+
+	virtual bool penetration(const Eigen::Vector3d& p, double& depth, Eigen::Vector3d& normal) const {
+		const Eigen::Vector3d r = p - center;
+		const double dist = r.norm();
+		if (dist == 0.0) {
+			return false;
+		}
+		const Eigen::Vector3d radial = r / dist;
+		if (radial.dot(axis) < cosHalfAngle) {
+			return false;
+		}
+		depth = concave ? dist - radius : radius - dist;
+		if (depth <= 0.0 || depth > maxDepth) {
+			return false;
+		}
+		normal = concave ? Eigen::Vector3d(-radial) : radial;
+		return true;
+	}
+
+protected:
+	Eigen::Vector3d center;
+	double radius;
+	bool concave;
+	Eigen::Vector3d axis;
+	double cosHalfAngle;
+};
+
+// Solid cylinder of radius around the axis through point, halfLength to
+// either side of it (unbounded if halfLength <= 0). Only the curved side
+// is a contact surface.
+class CylinderPatch : public ContactPatch
+{
+public:
+	CylinderPatch(const Eigen::Vector3d& point, const Eigen::Vector3d& axis, double radius, const ContactMaterial& material,
+			double halfLength = 0.0, double maxDepth = 0.05) :
+		ContactPatch(material, maxDepth), point(point), axis(axis.normalized()), radius(radius), halfLength(halfLength) {}
+
+	virtual bool penetration(const Eigen::Vector3d& p, double& depth, Eigen::Vector3d& normal) const {
+		const Eigen::Vector3d r = p - point;
+		const double along = r.dot(axis);
+		if (halfLength > 0.0 && std::fabs(along) > halfLength) {
+			return false;
+		}
+		const Eigen::Vector3d radial = r - along * axis;
+		const double dist = radial.norm();
+		depth = radius - dist;
+		if (dist == 0.0 || depth <= 0.0 || depth > maxDepth) {
+			return false;
+		}
+		normal = radial / dist;
+		return true;
+	}
+
+protected:
+	Eigen::Vector3d point, axis;
+	double radius, halfLength;
+};
+
+template<size_t DOF>
+class ContactSurface : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+// IO  (inputs)
+public:
+	Input<KinematicsView<DOF> > kinematicsInput;
+
+// IO  (outputs)
+public:
+	Output<jt_type> jtOutput;		// Jv^T f, for SimulatedWam::sink.externalTorqueInput
+	Output<cf_type> forceOutput;	// contact force on the tool
+
+protected:
+	typename Output<jt_type>::Value* jtOutputValue;
+	typename Output<cf_type>::Value* forceOutputValue;
+
+public:
+	explicit ContactSurface(const std::string& sysName = "ContactSurface"):
+		System(sysName), kinematicsInput(this), jtOutput(this, &jtOutputValue), forceOutput(this, &forceOutputValue),
+		depth(0.0), contact(false) {
+		jt.setZero();
+		force.setZero();
+	}
+
+	virtual ~ContactSurface() {
+		this->mandatoryCleanUp();
+		clear();
+	}
+
+	// Takes ownership of patch.
+	void addPatch(ContactPatch* patch) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		patches.push_back(patch);
+	}
+
+	void clear() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		for (size_t i = 0; i < patches.size(); ++i) {
+			delete patches[i];
+		}
+		patches.clear();
+	}
+
+	// Adds the patches of a libconfig list (see the top of this file).
+	// Returns false, having added the patches before it, at the first entry
+	// of unknown type; missing required keys throw libconfig's exceptions.
+	bool configure(const libconfig::Setting& list) {
+		for (int i = 0; i < list.getLength(); ++i) {
+			const libconfig::Setting& s = list[i];
+			const std::string type = s["type"].c_str();
+			ContactMaterial m(number(s, "stiffness", 5000.0), number(s, "damping", 30.0),
+					number(s, "friction", 0.3), number(s, "slip_velocity", 0.005));
+			const double maxDepth = number(s, "max_depth", 0.05);
+
+			if (type == "plane") {
+				Eigen::Vector2d halfExtents = Eigen::Vector2d::Zero();
+				if (s.exists("half_extents")) {
+					halfExtents << detail::numericToDouble(s["half_extents"][0]), detail::numericToDouble(s["half_extents"][1]);
+				}
+				addPatch(new PlanePatch(vector(s["point"]), vector(s["normal"]), m,
+						s.exists("u") ? vector(s["u"]) : Eigen::Vector3d(Eigen::Vector3d::UnitX()), halfExtents, maxDepth));
+			} else if (type == "sphere") {
+				addPatch(new SpherePatch(vector(s["center"]), detail::numericToDouble(s["radius"]),
+						s.exists("concave") && (bool) s["concave"], m,
+						s.exists("axis") ? vector(s["axis"]) : Eigen::Vector3d(Eigen::Vector3d::UnitZ()),
+						number(s, "half_angle", M_PI), maxDepth));
+			} else if (type == "cylinder") {
+				addPatch(new CylinderPatch(vector(s["point"]), vector(s["axis"]), detail::numericToDouble(s["radius"]), m,
+						number(s, "half_length", 0.0), maxDepth));
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t size() const { return patches.size(); }
+
+	bool inContact() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return contact;
+	}
+
+	double penetrationDepth() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return depth;
+	}
+
+	cf_type getForce() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return force;
+	}
+
+protected:
+	std::vector<ContactPatch*> patches;
+	jt_type jt;
+	cf_type force;
+	double depth;
+	bool contact;
+
+	Eigen::Vector3d p, v, n, candidateNormal, vt;
+
+	virtual void operate() {
+		const KinematicsView<DOF>& kin = this->kinematicsInput.getValue();
+		p = kin.position;
+		v = kin.velocity;
+
+		const ContactPatch* deepest = NULL;
+		depth = 0.0;
+		for (size_t i = 0; i < patches.size(); ++i) {
+			double d;
+			if (patches[i]->penetration(p, d, candidateNormal) && d > depth) {
+				depth = d;
+				n = candidateNormal;
+				deepest = patches[i];
+			}
+		}
+
+		force.setZero();
+		if (deepest != NULL) {
+			const ContactMaterial& m = deepest->material;
+			const double vn = v.dot(n);
+			const double fn = std::max(0.0, m.stiffness * depth - m.damping * vn);
+			vt = v - vn * n;
+			force = fn * n - (m.friction * fn / std::max(vt.norm(), m.slipVelocity)) * vt;
+		}
+		contact = deepest != NULL;
+
+		jt = kin.Jv.transpose() * force;
+		this->jtOutputValue->setData(&jt);
+		this->forceOutputValue->setData(&force);
+	}
+
+	static double number(const libconfig::Setting& s, const char* key, double fallback) {
+		return s.exists(key) ? detail::numericToDouble(s[key]) : fallback;
+	}
+
+	static Eigen::Vector3d vector(const libconfig::Setting& s) {
+		return Eigen::Vector3d(detail::numericToDouble(s[0]), detail::numericToDouble(s[1]), detail::numericToDouble(s[2]));
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(ContactSurface);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,178 @@
+/*
+ * cubic_bezier.h
+ *
+ * Cubic Bezier segment with analytic derivatives and arc-length
+ * parameterization.
+ *
+ *     B(t) = c0 + c1 t + c2 t^2 + c3 t^3,  t in [0, 1]
+ *
+ * position/velocity/acceleration(t) are exact. The arc length is tabulated
+ * once at construction (Gauss-Legendre per table interval), together with
+ * its inverse t(s) at uniformly spaced s, so parameterAt(s) and
+ * sampleAtLength() are O(1) and never allocate; they can run every tick.
+ * sampleAtLength() also gives dB/ds and d2B/ds2, so with a timing law s(t)
+ *
+ *     v = B' sd,  a = B'' sd^2 + B' sdd
+ *
+ * are available as velocity and acceleration feedforward.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include <barrett/units.h>
+
+using namespace barrett;
+
+class CubicBezier
+{
+public:
+	typedef units::CartesianPosition::type cp_type;
+
+	static const size_t TABLE_SIZE = 65;
+
+	CubicBezier(const Eigen::Vector3d& p0, const Eigen::Vector3d& p1, const Eigen::Vector3d& p2, const Eigen::Vector3d& p3) {
+		c0 = p0;
+		c1 = 3.0 * (p1 - p0);
+		c2 = 3.0 * (p2 - 2.0 * p1 + p0);
+		c3 = p3 - 3.0 * p2 + 3.0 * p1 - p0;
+		buildTable();
+	}
+
+	// From start to end with the inner control points offset * (end - start)
+	// in from either end. 0 gives an ease-in/ease-out straight line.
+	static CubicBezier between(const Eigen::Vector3d& start, const Eigen::Vector3d& end, double offset) {
+		const Eigen::Vector3d delta = end - start;
+		return CubicBezier(start, start + offset * delta, end - offset * delta, end);
+	}
+
+	Eigen::Vector3d position(double t) const { return c0 + t * (c1 + t * (c2 + t * c3)); }
+	Eigen::Vector3d velocity(double t) const { return c1 + t * (2.0 * c2 + t * 3.0 * c3); }	// dB/dt
+	Eigen::Vector3d acceleration(double t) const { return 2.0 * c2 + 6.0 * t * c3; }		// d2B/dt2
+
+	double length() const { return totalLength; }
+
+	// Curve parameter at arc length s (clamped to [0, length()]).
+	double parameterAt(double s) const {
+		if (totalLength <= 0.0 || s <= 0.0) {
+			return 0.0;
+		}
+		if (s >= totalLength) {
+			return 1.0;
+		}
+		const double x = s / totalLength * (TABLE_SIZE - 1);
+		const size_t k = std::min(static_cast<size_t>(x), TABLE_SIZE - 2);
+		const double f = x - k, lo = tOfS[k], hi = tOfS[k + 1];
+
+		// Where the curve starts or stops with zero speed, s grows with the
+		// square of t there, so t(s) is a square root rather than a line.
+		double t;
+		if (k == 0 && restAtStart) {
+			t = lo + std::sqrt(f) * (hi - lo);
+		} else if (k == TABLE_SIZE - 2 && restAtEnd) {
+			t = hi - std::sqrt(1.0 - f) * (hi - lo);
+		} else {
+			t = lo + f * (hi - lo);
+		}
+
+		// one Newton step on s(t) - s, kept inside the table interval
+		const double speed = velocity(t).norm();
+		if (speed > 1e-12) {
+			const size_t j = std::min(static_cast<size_t>(t * (TABLE_SIZE - 1)), TABLE_SIZE - 2);
+			const double dt = 1.0 / (TABLE_SIZE - 1);
+			t -= (sOfT[j] + segmentLength(j * dt, t) - s) / speed;
+			t = std::min(std::max(t, lo), hi);
+		}
+		return t;
+	}
+
+	// Position and its first and second derivatives with respect to arc
+	// length at s. Where the curve has zero speed (a degenerate end) the
+	// derivatives are taken as zero.
+	void sampleAtLength(double s, Eigen::Vector3d& p, Eigen::Vector3d& dp, Eigen::Vector3d& ddp) const {
+		const double t = parameterAt(s);
+		p = position(t);
+		const Eigen::Vector3d v = velocity(t);
+		const double speed = v.norm();
+		if (speed < 1e-12) {
+			dp.setZero();
+			ddp.setZero();
+			return;
+		}
+		dp = v / speed;
+		const Eigen::Vector3d a = acceleration(t);
+		ddp = (a - a.dot(dp) * dp) / (speed * speed);
+	}
+
+	// count points from start to end (count >= 2). squish > 0 spaces them by
+	// a logistic over [-squish, squish] in arc length, denser at both ends;
+	// 0 spaces them evenly.
+	std::vector<cp_type> waypoints(size_t count, double squish = 0.0) const {
+		std::vector<cp_type> pts;
+		pts.reserve(count);
+		const double lo = logistic(-squish), hi = logistic(squish);
+		for (size_t i = 0; i < count; ++i) {
+			const double u = count > 1 ? static_cast<double>(i) / (count - 1) : 1.0;
+			const double f = squish > 0.0 ? (logistic(squish * (2.0 * u - 1.0)) - lo) / (hi - lo) : u;
+			pts.push_back(cp_type(position(parameterAt(f * totalLength))));
+		}
+		return pts;
+	}
+
+protected:
+	Eigen::Vector3d c0, c1, c2, c3;
+	double totalLength;
+	bool restAtStart, restAtEnd;	// zero speed at t = 0 / t = 1
+	double sOfT[TABLE_SIZE];	// arc length at t = k / (TABLE_SIZE - 1)
+	double tOfS[TABLE_SIZE];	// t at s = k / (TABLE_SIZE - 1) * totalLength
+
+	static double logistic(double x) { return 1.0 / (1.0 + std::exp(-x)); }
+
+	// Arc length over [t0, t1], 3-point Gauss-Legendre.
+	double segmentLength(double t0, double t1) const {
+		static const double x = 0.7745966692414834;	// sqrt(3/5)
+		const double m = 0.5 * (t0 + t1), h = 0.5 * (t1 - t0);
+		return h * (5.0 / 9.0 * velocity(m - h * x).norm() + 8.0 / 9.0 * velocity(m).norm()
+				+ 5.0 / 9.0 * velocity(m + h * x).norm());
+	}
+
+	void buildTable() {
+		restAtStart = velocity(0.0).norm() < 1e-12;
+		restAtEnd = velocity(1.0).norm() < 1e-12;
+
+		const double dt = 1.0 / (TABLE_SIZE - 1);
+		sOfT[0] = 0.0;
+		for (size_t k = 1; k < TABLE_SIZE; ++k) {
+			sOfT[k] = sOfT[k - 1] + segmentLength((k - 1) * dt, k * dt);
+		}
+		totalLength = sOfT[TABLE_SIZE - 1];
+
+		// invert: linear guess inside the bracketing interval, then Newton
+		size_t j = 0;
+		tOfS[0] = 0.0;
+		for (size_t k = 1; k + 1 < TABLE_SIZE; ++k) {
+			const double s = k * totalLength / (TABLE_SIZE - 1);
+			while (j + 2 < TABLE_SIZE && sOfT[j + 1] < s) {
+				++j;
+			}
+			const double ds = sOfT[j + 1] - sOfT[j];
+			double t = j * dt + (ds > 0.0 ? (s - sOfT[j]) / ds : 0.0) * dt;
+			for (int n = 0; n < 2; ++n) {
+				const double speed = velocity(t).norm();
+				if (speed < 1e-12) {
+					break;
+				}
+				t -= (sOfT[j] + segmentLength(j * dt, t) - s) / speed;
+				t = std::min(std::max(t, j * dt), (j + 1) * dt);
+			}
+			tOfS[k] = t;
+		}
+		tOfS[TABLE_SIZE - 1] = 1.0;
+	}
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,96 @@
+/*
+ * kinematics_bundle.h
+ *
+ * Publishes the tool kinematics of the current tick as one KinematicsView:
+ * Jacobian (and its linear/angular halves), tool-to-world rotation, tool
+ * position and tool velocity. The members are Eigen::Maps straight over the
+ * GSL storage that libbarrett's bt_kinematics updates in place every tick,
+ * so nothing is copied; consumers read the same memory through getValue().
+ *
+ * GSL matrices are row-major with a row stride of tda, vectors have an
+ * element stride; the maps carry both. The storage belongs to the WAM's
+ * kinematics and only holds the current tick, so read the view from
+ * operate() (and copy what has to outlive the tick).
+ */
+
+#pragma once
+
+#include <new>
+#include <string>
+#include <eigen3/Eigen/Core>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/math/kinematics.h>
+#include <barrett/detail/ca_macro.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+struct KinematicsView
+{
+	typedef Eigen::Map<const Eigen::Matrix<double, 6, DOF, Eigen::RowMajor>, Eigen::Unaligned, Eigen::OuterStride<> > jacobian_map;
+	typedef Eigen::Map<const Eigen::Matrix<double, 3, DOF, Eigen::RowMajor>, Eigen::Unaligned, Eigen::OuterStride<> > jacobian_part_map;
+	typedef Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>, Eigen::Unaligned, Eigen::OuterStride<> > rotation_map;
+	typedef Eigen::Map<const Eigen::Vector3d, Eigen::Unaligned, Eigen::InnerStride<> > vector_map;
+
+	jacobian_map J;				// tool Jacobian, linear rows first
+	jacobian_part_map Jv;		// rows 0-2 of J
+	jacobian_part_map Jw;		// rows 3-5 of J
+	rotation_map R;				// tool-to-world rotation (transpose for world-to-tool)
+	vector_map position;		// tool position
+	vector_map velocity;		// tool linear velocity
+	vector_map angularVelocity;	// tool angular velocity
+
+	KinematicsView() :
+		J(NULL, Eigen::OuterStride<>(DOF)), Jv(NULL, Eigen::OuterStride<>(DOF)), Jw(NULL, Eigen::OuterStride<>(DOF)),
+		R(NULL, Eigen::OuterStride<>(3)), position(NULL, Eigen::InnerStride<>(1)),
+		velocity(NULL, Eigen::InnerStride<>(1)), angularVelocity(NULL, Eigen::InnerStride<>(1)) {}
+
+	bool isBound() const { return J.data() != NULL; }
+
+	// Points the maps at kin's storage (Eigen's placement-new idiom for
+	// rebinding a Map). The GSL buffers live as long as kin.
+	void bind(const bt_kinematics* kin) {
+		new (&J) jacobian_map(kin->tool_jacobian->data, Eigen::OuterStride<>(kin->tool_jacobian->tda));
+		new (&Jv) jacobian_part_map(kin->tool_jacobian_linear->data, Eigen::OuterStride<>(kin->tool_jacobian_linear->tda));
+		new (&Jw) jacobian_part_map(kin->tool_jacobian_angular->data, Eigen::OuterStride<>(kin->tool_jacobian_angular->tda));
+		new (&R) rotation_map(kin->tool->rot_to_world->data, Eigen::OuterStride<>(kin->tool->rot_to_world->tda));
+		new (&position) vector_map(kin->tool->origin_pos->data, Eigen::InnerStride<>(kin->tool->origin_pos->stride));
+		new (&velocity) vector_map(kin->tool_velocity->data, Eigen::InnerStride<>(kin->tool_velocity->stride));
+		new (&angularVelocity) vector_map(kin->tool_velocity_angular->data, Eigen::InnerStride<>(kin->tool_velocity_angular->stride));
+	}
+
+private:
+	// Assigning Maps would write through them; copies are fine.
+	KinematicsView& operator=(const KinematicsView&);
+};
+
+template<size_t DOF>
+class KinematicsBundle : public systems::System, public systems::SingleOutput<KinematicsView<DOF> >,
+						 public systems::KinematicsInput<DOF>
+{
+public:
+	typedef KinematicsView<DOF> view_type;
+
+public:
+	explicit KinematicsBundle(const std::string& sysName = "KinematicsBundle"):
+		System(sysName), systems::SingleOutput<view_type>(this), systems::KinematicsInput<DOF>(this), kin(NULL) {}
+	virtual ~KinematicsBundle() { this->mandatoryCleanUp(); }
+
+protected:
+	view_type view;
+	const bt_kinematics* kin;
+
+	virtual void operate() {
+		// The kinematics object (and its storage) doesn't change while
+		// connected, so this only binds on the first tick.
+		if (this->kinInput.getValue().impl != kin) {
+			kin = this->kinInput.getValue().impl;
+			view.bind(kin);
+		}
+		this->outputValue->setData(&view);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(KinematicsBundle);
+};
@@ -0,0 +1,170 @@
+/*
+ * momentum_observer.h
+ *
+ * Generalized-momentum disturbance observer (De Luca et al.). With p = M(q) qd,
+ *
+ *     dp/dt = tau - C(q,qd) qd - g(q) + dM/dt qd + tau_ext,
+ *
+ * so the residual
+ *
+ *     r = K (p - p0 - integral(tau - C qd - g + dM/dt qd + r) dt)
+ *
+ * follows tau_ext through a first-order lag of bandwidth K without needing
+ * joint accelerations. dM/dt is a one-tick backward difference of M; the
+ * reflected rotor inertia is added to M. The wrench on the environment is
+ * recovered from J^T w = -r with the same sign convention as ForceEstimator,
+ * so the cf/ct ports are a drop-in replacement. Each tick is O(DOF^2) plus a
+ * fixed-size 3-column QR.
+ *
+ * The observer integrates, so it has to be managed by the execution manager
+ * (or be pulled every tick by a managed consumer).
+ */
+
+#pragma once
+#include <string>
+#include <eigen3/Eigen/Dense>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/math/kinematics.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/kinematics_bundle.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+class MomentumObserver: public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef Eigen::Matrix<double, DOF, DOF> mass_matrix_type;
+	typedef Eigen::Matrix<double, DOF, 1> joint_vector_type;
+
+// IO  (inputs)
+public:
+	Input<jv_type> jvInput;		// joint vel. input
+	Input<jt_type> jtInput;		// joint torque input (wam.jtSum)
+
+public:
+	Input<mass_matrix_type> M; // mass matrix input
+	Input<joint_vector_type> C; // coriolis vector input
+
+public:
+	Input<KinematicsView<DOF> > kinematicsInput;	// KinematicsBundle output
+	Input<jt_type> g;
+
+// IO  (outputs)
+public:
+	Output<cf_type> cartesianForceOutput;    // output cartesian force
+	Output<ct_type> cartesianTorqueOutput;    // output cartesian torque
+	Output<jt_type> externalTorqueOutput;    // residual r ~ tau_ext
+
+protected:
+	typename Output<cf_type>::Value* cartesianForceOutputValue;
+	typename Output<ct_type>::Value* cartesianTorqueOutputValue;
+	typename Output<jt_type>::Value* externalTorqueOutputValue;
+
+public:
+cf_type computedF;
+ct_type computedT;
+jt_type computedJt;
+
+public:
+	// gains: observer bandwidth per joint [1/s]; K * T_s should stay well below 1.
+	// rotorInertia: reflected rotor inertia in joint space (T^T diag(Im) T).
+	explicit MomentumObserver(const v_type& gains, const sqm_type& rotorInertia = sqm_type(0.0),
+			const std::string& sysName = "MomentumObserver"):
+		System(sysName), jvInput(this), jtInput(this), M(this), C(this), kinematicsInput(this), g(this),
+		cartesianForceOutput(this, &cartesianForceOutputValue), cartesianTorqueOutput(this, &cartesianTorqueOutputValue),
+		externalTorqueOutput(this, &externalTorqueOutputValue),
+		K(gains), Mr(rotorInertia), T_s(0.0), initialized(false), system(DOF, 3), systemg(DOF, 3) {
+		getSamplePeriodFromEM();
+	}
+
+	virtual ~MomentumObserver() { this->mandatoryCleanUp(); }
+
+	// Restart the observer from the current state on the next tick. Lock the
+	// execution manager's mutex before calling this while running.
+	void reset() { initialized = false; }
+
+protected:
+	joint_vector_type K;
+	mass_matrix_type Mr;
+	double T_s;
+	bool initialized;
+
+	mass_matrix_type M_inside, M_prev;
+	joint_vector_type C_inside, qd, tau, G, p, p0, integral, r, jt;
+	Eigen::Matrix<double, DOF, 3> tmp_jaco_lin_t, tmp_jaco_ang_t;
+	Eigen::Vector3d estimatedF, estimatedT;
+	Eigen::ColPivHouseholderQR<Eigen::Matrix<double, DOF, 3> > system, systemg;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		getSamplePeriodFromEM();
+	}
+
+	void getSamplePeriodFromEM() {
+		if (this->hasExecutionManager()) {
+			T_s = this->getExecutionManager()->getPeriod();
+		} else {
+			T_s = 0.0;
+		}
+	}
+
+	virtual void operate() {
+		qd = this->jvInput.getValue();
+		tau = this->jtInput.getValue();
+		M_inside = this->M.getValue() + Mr;
+		C_inside = this->C.getValue();
+		G = this->g.getValue();
+
+		p.noalias() = M_inside * qd;
+
+		if ( !initialized ) {
+			p0 = p;
+			M_prev = M_inside;
+			integral.setZero();
+			r.setZero();
+			initialized = true;
+		}
+
+		// dM/dt qd, backward difference over one tick
+		if (T_s > 0.0) {
+			jt.noalias() = (M_inside - M_prev) * qd;
+			jt /= T_s;
+		} else {
+			jt.setZero();
+		}
+		M_prev = M_inside;
+
+		// the integral holds samples up to the previous tick; this tick's
+		// derivative only enters the next residual
+		r = K.cwiseProduct(p - p0 - integral);
+		integral += (tau - C_inside - G + jt + r) * T_s;
+
+		// wrench the robot applies to the environment: J^T w = -r
+		jt = -r;
+		tmp_jaco_lin_t = this->kinematicsInput.getValue().Jv.transpose();
+		tmp_jaco_ang_t = this->kinematicsInput.getValue().Jw.transpose();
+		system.compute(tmp_jaco_lin_t);
+		systemg.compute(tmp_jaco_ang_t);
+		estimatedF = system.solve(jt);
+		estimatedT = systemg.solve(jt);
+
+		computedF = estimatedF;
+		computedT = estimatedT;
+		computedJt = r;
+
+		cartesianForceOutputValue->setData(&computedF);
+		cartesianTorqueOutputValue->setData(&computedT);
+		externalTorqueOutputValue->setData(&computedJt);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(MomentumObserver);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
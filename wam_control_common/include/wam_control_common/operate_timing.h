@@ -0,0 +1,306 @@
+/*
+ * operate_timing.h
+ *
+ * Run-time instrumentation of the execution graph.
+ *
+ * Timed<S> is a drop-in replacement for a System S (same constructor
+ * arguments) that times every S::operate() into a LatencyHistogram.
+ * GraphTimer is a managed System that, once per tick, records the summed
+ * operate() time of all Timed systems tracked with it and the tick-to-tick
+ * period, and formats p50/p99/p99.9/max of everything for ROS.
+ *
+ * The histograms are log-linear (HDR style): exact below 32 ns, then 16
+ * sub-buckets per power of two, i.e. <= 6.25% relative error, up to ~67 ms.
+ * Recording is a few relaxed atomic stores with no locks or allocation, and
+ * readers on other threads never block the real-time thread. There is one
+ * writer per histogram (the execution manager's thread).
+ *
+ * Only the operate() of tracked systems counts towards the graph time;
+ * libbarrett's own systems (the WAM's kinematics, controllers' sinks, ...)
+ * show up in the period histogram only.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <barrett/os.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+using namespace barrett;
+
+struct LatencySummary
+{
+	uint64_t count;
+	double mean, p50, p99, p999, max;	// [us]
+};
+
+class LatencyHistogram
+{
+public:
+	static const int SUB_BUCKET_BITS = 4;
+	static const size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static const int MAX_SHIFT = 22;	// top bucket ends at 2^26 ns
+	static const size_t BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+	LatencyHistogram() : tickTotal(NULL) { clear(); }
+
+	// Real-time side.
+	void record(uint64_t ns) {
+		if (resetRequested.load(std::memory_order_relaxed)) {
+			clear();
+			resetRequested.store(false, std::memory_order_relaxed);
+		}
+		std::atomic<uint64_t>& c = counts[bucketOf(ns)];
+		c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		sum.store(sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+		if (ns > maximum.load(std::memory_order_relaxed)) {
+			maximum.store(ns, std::memory_order_relaxed);
+		}
+		if (tickTotal != NULL) {
+			*tickTotal += ns;
+		}
+	}
+
+	// Reader side. The counts are read one by one, so a summary taken while
+	// recording may be off by the samples of the current tick.
+	LatencySummary summary() const {
+		LatencySummary s;
+		s.count = total.load(std::memory_order_relaxed);
+		s.max = maximum.load(std::memory_order_relaxed) * 1e-3;
+		s.mean = s.count ? sum.load(std::memory_order_relaxed) * 1e-3 / s.count : 0.0;
+
+		const uint64_t rank50 = (s.count + 1) / 2, rank99 = s.count - s.count / 100, rank999 = s.count - s.count / 1000;
+		s.p50 = s.p99 = s.p999 = 0.0;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < BUCKETS && seen < rank999; ++i) {
+			const uint64_t n = counts[i].load(std::memory_order_relaxed);
+			if (n == 0) {
+				continue;
+			}
+			const double upper = std::min<double>(upperBoundOf(i), maximum.load(std::memory_order_relaxed)) * 1e-3;
+			if (seen < rank50 && seen + n >= rank50) { s.p50 = upper; }
+			if (seen < rank99 && seen + n >= rank99) { s.p99 = upper; }
+			seen += n;
+			if (seen >= rank999) { s.p999 = upper; }
+		}
+		return s;
+	}
+
+	// Asks the writer to start over on its next sample.
+	void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+	// Per-tick accumulator of the GraphTimer this histogram is tracked by.
+	// Only change it while the writer is stopped (execution manager locked).
+	uint64_t* tickTotal;
+
+protected:
+	std::atomic<uint64_t> counts[BUCKETS];
+	std::atomic<uint64_t> total, sum, maximum;
+	std::atomic<bool> resetRequested;
+
+	void clear() {
+		for (size_t i = 0; i < BUCKETS; ++i) {
+			counts[i].store(0, std::memory_order_relaxed);
+		}
+		total.store(0, std::memory_order_relaxed);
+		sum.store(0, std::memory_order_relaxed);
+		maximum.store(0, std::memory_order_relaxed);
+		resetRequested.store(false, std::memory_order_relaxed);
+	}
+
+	static size_t bucketOf(uint64_t ns) {
+		if (ns < 2 * SUB_BUCKETS) {
+			return ns;
+		}
+		int shift = 63 - __builtin_clzll(ns) - SUB_BUCKET_BITS;
+		if (shift > MAX_SHIFT) {
+			return BUCKETS - 1;
+		}
+		return shift * SUB_BUCKETS + (ns >> shift);
+	}
+
+	static uint64_t upperBoundOf(size_t bucket) {
+		if (bucket < 2 * SUB_BUCKETS) {
+			return bucket;
+		}
+		const int shift = bucket / SUB_BUCKETS - 1;
+		return ((bucket - shift * SUB_BUCKETS + 1) << shift) - 1;
+	}
+
+private:
+	LatencyHistogram(const LatencyHistogram&);
+	LatencyHistogram& operator=(const LatencyHistogram&);
+};
+
+template<typename Base> class Timed;
+
+class GraphTimer : public systems::System
+{
+public:
+	static const size_t MAX_TRACKED = 32;
+
+	explicit GraphTimer(const std::string& sysName = "GraphTimer"):
+		System(sysName), nTracked(0), tickTotal(0), lastTick(0.0), T_s(0.0) {
+		getSamplePeriodFromEM();
+	}
+	virtual ~GraphTimer() {
+		this->mandatoryCleanUp();
+		for (size_t i = 0; i < nTracked; ++i) {
+			tracked[i].histogram->tickTotal = NULL;
+			*tracked[i].owner = NULL;
+		}
+	}
+
+	// Adds sys to the report and to the per-tick graph time. Returns false if
+	// the table is full. Takes the execution manager's lock; the table has its
+	// own mutex so report() never holds up the real-time thread.
+	template<typename Base>
+	bool track(Timed<Base>& sys);
+
+	void untrack(LatencyHistogram& h) {
+		std::lock_guard<std::mutex> tableLock(tableMutex);
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		for (size_t i = 0; i < nTracked; ++i) {
+			if (tracked[i].histogram == &h) {
+				h.tickTotal = NULL;
+				tracked[i] = tracked[--nTracked];
+				return;
+			}
+		}
+	}
+
+	void reset() {
+		graphTime.reset();
+		period.reset();
+		std::lock_guard<std::mutex> tableLock(tableMutex);
+		for (size_t i = 0; i < nTracked; ++i) {
+			tracked[i].histogram->reset();
+		}
+	}
+
+	// One line per histogram: count, mean, p50, p99, p99.9 and max in us,
+	// graph time and period first.
+	std::string report() {
+		std::lock_guard<std::mutex> tableLock(tableMutex);
+		std::string out;
+		char line[160];
+		snprintf(line, sizeof(line), "period %.0f us\n%-32s %10s %8s %8s %8s %8s %8s\n", T_s * 1e6,
+				"[us]", "count", "mean", "p50", "p99", "p99.9", "max");
+		out += line;
+		appendLine(out, "graph (tracked systems)", graphTime.summary());
+		appendLine(out, "tick period", period.summary());
+		for (size_t i = 0; i < nTracked; ++i) {
+			appendLine(out, tracked[i].name, tracked[i].histogram->summary());
+		}
+		return out;
+	}
+
+	const LatencyHistogram& graphHistogram() const { return graphTime; }
+	const LatencyHistogram& periodHistogram() const { return period; }
+
+protected:
+	struct Entry {
+		char name[40];
+		LatencyHistogram* histogram;
+		GraphTimer** owner;		// the Timed system's back pointer
+	};
+
+	std::mutex tableMutex;	// tracked/nTracked; never taken by operate()
+	Entry tracked[MAX_TRACKED];
+	size_t nTracked;
+	uint64_t tickTotal;
+	LatencyHistogram graphTime, period;
+	double lastTick, T_s;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		getSamplePeriodFromEM();
+	}
+
+	void getSamplePeriodFromEM() {
+		if (this->hasExecutionManager()) {
+			T_s = this->getExecutionManager()->getPeriod();
+		} else {
+			T_s = 0.0;
+		}
+	}
+
+	// Runs once per execution cycle. Between two runs every tracked system
+	// operated once, wherever this falls in the cycle.
+	virtual void operate() {
+		const double now = highResolutionSystemTime();
+		if (lastTick > 0.0) {
+			period.record(static_cast<uint64_t>((now - lastTick) * 1e9));
+			graphTime.record(tickTotal);
+		}
+		lastTick = now;
+		tickTotal = 0;
+	}
+
+	static void appendLine(std::string& out, const char* name, const LatencySummary& s) {
+		char line[160];
+		snprintf(line, sizeof(line), "%-32s %10llu %8.1f %8.1f %8.1f %8.1f %8.1f\n", name,
+				(unsigned long long) s.count, s.mean, s.p50, s.p99, s.p999, s.max);
+		out += line;
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(GraphTimer);
+};
+
+// Base with its operate() timed. Constructed with Base's arguments.
+template<typename Base>
+class Timed : public Base
+{
+public:
+	template<typename... Args>
+	explicit Timed(Args&&... args) : Base(std::forward<Args>(args)...), timer(NULL) {}
+
+	virtual ~Timed() {
+		this->mandatoryCleanUp();	// operate() must not run once this part is gone
+		if (timer != NULL) {
+			timer->untrack(operateTime);
+		}
+	}
+
+	LatencyHistogram operateTime;	// [ns] per operate()
+
+protected:
+	friend class GraphTimer;
+	GraphTimer* timer;
+
+	virtual void operate() {
+		const double start = highResolutionSystemTime();
+		Base::operate();
+		operateTime.record(static_cast<uint64_t>((highResolutionSystemTime() - start) * 1e9));
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(Timed);
+};
+
+template<typename Base>
+bool GraphTimer::track(Timed<Base>& sys) {
+	std::lock_guard<std::mutex> tableLock(tableMutex);
+	BARRETT_SCOPED_LOCK(this->getEmMutex());
+	if (nTracked == MAX_TRACKED) {
+		return false;
+	}
+	strncpy(tracked[nTracked].name, sys.getName().c_str(), sizeof(tracked[nTracked].name) - 1);
+	tracked[nTracked].name[sizeof(tracked[nTracked].name) - 1] = '\0';
+	tracked[nTracked].histogram = &sys.operateTime;
+	tracked[nTracked].owner = &sys.timer;
+	++nTracked;
+	sys.operateTime.tickTotal = &tickTotal;
+	sys.timer = this;
+	return true;
+}
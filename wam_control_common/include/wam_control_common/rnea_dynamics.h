@@ -0,0 +1,249 @@
+/*
+ * rnea_dynamics.h
+ *
+ * Rigid-body dynamics of an n-DOF WAM built from the link parameters in the
+ * libbarrett WAM configuration (kinematics.moving: standard DH alpha_pi, a, d;
+ * dynamics.moving: mass, com, I). All storage is fixed-size, so update() and
+ * the System below do not allocate in the real-time thread.
+ *
+ *  - Coriolis/centrifugal vector C(q, qd) * qd: recursive Newton-Euler, O(n)
+ *  - Mass matrix M(q): composite rigid body algorithm, O(n^2)
+ *
+ * RNEADynamics<DOF> has the same ports as the closed-form 4-DOF Dynamics<DOF>,
+ * so it can be swapped in on either arm.
+ *
+ *  Created on: 2024
+ *      Author: Faezeh
+ */
+
+#pragma once
+#include <string>
+#include <math.h>
+#include <eigen3/Eigen/Dense>
+#include <libconfig.h++>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+#include <barrett/detail/libconfig_utils.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+class RNEA {
+public:
+	typedef Eigen::Matrix<double, DOF, DOF> mass_matrix_type;
+	typedef Eigen::Matrix<double, DOF, 1> joint_vector_type;
+
+	// wamSetting is the WAM's group in the libbarrett config
+	// (pm.getConfig().lookup(pm.getWamDefaultConfigPath())).
+	explicit RNEA(const libconfig::Setting& wamSetting) {
+		const libconfig::Setting& kin = wamSetting["kinematics"]["moving"];
+		const libconfig::Setting& dyn = wamSetting["dynamics"]["moving"];
+		for (size_t i = 0; i < DOF; ++i) {
+			Eigen::Vector3d com;
+			Eigen::Matrix3d I;
+			for (int r = 0; r < 3; ++r) {
+				com[r] = detail::numericToDouble(dyn[i]["com"][r]);
+				for (int c = 0; c < 3; ++c) {
+					I(r, c) = detail::numericToDouble(dyn[i]["I"][r][c]);
+				}
+			}
+			setLink(i, detail::numericToDouble(kin[i]["alpha_pi"]) * M_PI,
+					detail::numericToDouble(kin[i]["a"]),
+					detail::numericToDouble(kin[i]["d"]),
+					detail::numericToDouble(dyn[i]["mass"]), com, I);
+		}
+
+		// Gravity is -z in the world frame; express it in the base frame.
+		Eigen::Matrix3d worldToBase = Eigen::Matrix3d::Identity();
+		if (wamSetting["kinematics"].exists("world_to_base")) {
+			const libconfig::Setting& wtb = wamSetting["kinematics"]["world_to_base"];
+			for (int r = 0; r < 3; ++r) {
+				for (int c = 0; c < 3; ++c) {
+					worldToBase(r, c) = detail::numericToDouble(wtb[r][c]);
+				}
+			}
+		}
+		setGravity(worldToBase.transpose() * Eigen::Vector3d(0.0, 0.0, -9.81));
+	}
+
+	// alpha in radians; com and I (about the com) expressed in link frame i.
+	void setLink(size_t i, double alpha, double a, double d, double mass,
+			const Eigen::Vector3d& com, const Eigen::Matrix3d& I) {
+		this->alpha[i] = alpha;
+		this->a[i] = a;
+		this->d[i] = d;
+		this->mass[i] = mass;
+		this->com[i] = com;
+		this->inertia[i] = I;
+		// origin of frame i relative to frame i-1, expressed in frame i
+		pstar[i] << a, d * sin(alpha), d * cos(alpha);
+	}
+
+	void setGravity(const Eigen::Vector3d& g) { gravity = g; }
+
+	// Recomputes the link rotations and base-frame poses for q.
+	void update(const joint_vector_type& q) {
+		Eigen::Matrix3d R0 = Eigen::Matrix3d::Identity();
+		Eigen::Vector3d p0 = Eigen::Vector3d::Zero();
+		for (size_t i = 0; i < DOF; ++i) {
+			const double ct = cos(q[i]), st = sin(q[i]);
+			const double ca = cos(alpha[i]), sa = sin(alpha[i]);
+			R[i] << ct, -st * ca, st * sa,
+					st, ct * ca, -ct * sa,
+					0.0, sa, ca;
+			z0[i] = R0.col(2);	// joint i rotates about z_{i-1}
+			o0[i] = p0;
+			p0 += R0 * Eigen::Vector3d(a[i] * ct, a[i] * st, d[i]);
+			R0 = R0 * R[i];
+			Rbase[i] = R0;
+			c0[i] = p0 + R0 * com[i];
+		}
+	}
+
+	// Joint torques for (q, qd, qdd) as set by the last update(q). Gravity is
+	// included only if withGravity is set.
+	const joint_vector_type& inverseDynamics(const joint_vector_type& qd,
+			const joint_vector_type& qdd, bool withGravity) {
+		const Eigen::Vector3d z(0.0, 0.0, 1.0);
+		Eigen::Vector3d w = Eigen::Vector3d::Zero();
+		Eigen::Vector3d wd = Eigen::Vector3d::Zero();
+		Eigen::Vector3d vd = withGravity ? Eigen::Vector3d(-gravity) : Eigen::Vector3d::Zero();
+
+		for (size_t i = 0; i < DOF; ++i) {
+			const Eigen::Matrix3d Rt = R[i].transpose();
+			wd = Rt * (wd + z * qdd[i] + w.cross(z * qd[i]));
+			w = Rt * (w + z * qd[i]);
+			vd = wd.cross(pstar[i]) + w.cross(w.cross(pstar[i])) + Rt * vd;
+			const Eigen::Vector3d vcd = wd.cross(com[i]) + w.cross(w.cross(com[i])) + vd;
+			F[i] = mass[i] * vcd;
+			N[i] = inertia[i] * wd + w.cross(inertia[i] * w);
+		}
+
+		Eigen::Vector3d f = Eigen::Vector3d::Zero();
+		Eigen::Vector3d n = Eigen::Vector3d::Zero();
+		for (size_t k = DOF; k-- > 0;) {
+			if (k + 1 < DOF) {
+				n = R[k + 1] * (n + (R[k + 1].transpose() * pstar[k]).cross(f));
+				f = R[k + 1] * f;
+			}
+			n += (pstar[k] + com[k]).cross(F[k]) + N[k];
+			f += F[k];
+			// joint axis z_{k-1} expressed in frame k
+			tau[k] = n.dot(R[k].row(2).transpose());
+		}
+		return tau;
+	}
+
+	// C(q, qd) * qd
+	const joint_vector_type& coriolis(const joint_vector_type& qd) {
+		return inverseDynamics(qd, joint_vector_type::Zero(), false);
+	}
+
+	const joint_vector_type& gravityTorque() {
+		return inverseDynamics(joint_vector_type::Zero(), joint_vector_type::Zero(), true);
+	}
+
+	// Composite rigid body algorithm in the base frame.
+	const mass_matrix_type& massMatrix() {
+		double mc = 0.0;
+		Eigen::Vector3d cc = Eigen::Vector3d::Zero();
+		Eigen::Matrix3d Ic = Eigen::Matrix3d::Zero();
+
+		for (size_t j = DOF; j-- > 0;) {
+			// add link j to the composite body of links j..n
+			const double m = mc + mass[j];
+			const Eigen::Vector3d c = (mc * cc + mass[j] * c0[j]) / m;
+			Ic = Ic + parallelAxis(mc, cc - c)
+					+ Rbase[j] * inertia[j] * Rbase[j].transpose()
+					+ parallelAxis(mass[j], c0[j] - c);
+			mc = m;
+			cc = c;
+
+			// wrench needed to accelerate the composite about joint j at unit rate
+			const Eigen::Vector3d fj = mc * z0[j].cross(cc - o0[j]);
+			const Eigen::Vector3d nj = Ic * z0[j];
+			for (size_t i = 0; i <= j; ++i) {
+				Mass(i, j) = z0[i].dot(nj + (cc - o0[i]).cross(fj));
+				Mass(j, i) = Mass(i, j);
+			}
+		}
+		return Mass;
+	}
+
+protected:
+	static Eigen::Matrix3d parallelAxis(double m, const Eigen::Vector3d& r) {
+		return m * (r.squaredNorm() * Eigen::Matrix3d::Identity() - r * r.transpose());
+	}
+
+	double alpha[DOF], a[DOF], d[DOF], mass[DOF];
+	Eigen::Vector3d com[DOF], pstar[DOF];
+	Eigen::Matrix3d inertia[DOF];
+	Eigen::Vector3d gravity;
+
+	Eigen::Matrix3d R[DOF], Rbase[DOF];
+	Eigen::Vector3d z0[DOF], o0[DOF], c0[DOF];
+	Eigen::Vector3d F[DOF], N[DOF];
+
+	joint_vector_type tau;
+	mass_matrix_type Mass;
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
+template<size_t DOF>
+class RNEADynamics: public systems::System {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef typename RNEA<DOF>::mass_matrix_type mass_matrix_type;
+	typedef typename RNEA<DOF>::joint_vector_type joint_vector_type;
+
+// IO  (inputs)
+public:
+	Input<jp_type> jpInputDynamics;
+	Input<jv_type> jvInputDynamics;
+
+// IO  (outputs)
+public:
+	Output<mass_matrix_type> MassMAtrixOutput;
+	Output<joint_vector_type> CVectorOutput;
+
+protected:
+	typename Output<mass_matrix_type>::Value* MassMAtrixOutputValue;
+	typename Output<joint_vector_type>::Value* CVectorOutputValue;
+
+public:
+	explicit RNEADynamics(const libconfig::Setting& wamSetting, const std::string& sysName = "RNEADynamics"):
+		System(sysName), jpInputDynamics(this), jvInputDynamics(this),
+		MassMAtrixOutput(this, &MassMAtrixOutputValue), CVectorOutput(this, &CVectorOutputValue),
+		rnea(wamSetting) {}
+
+	virtual ~RNEADynamics() { this->mandatoryCleanUp(); }
+
+protected:
+	RNEA<DOF> rnea;
+	joint_vector_type q, qd;
+	mass_matrix_type massMatrix;
+	joint_vector_type Cvec;
+
+	virtual void operate() {
+		q = this->jpInputDynamics.getValue();
+		qd = this->jvInputDynamics.getValue();
+
+		rnea.update(q);
+		massMatrix = rnea.massMatrix();
+		Cvec = rnea.coriolis(qd);
+
+		this->MassMAtrixOutputValue->setData(&massMatrix);
+		this->CVectorOutputValue->setData(&Cvec);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(RNEADynamics);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
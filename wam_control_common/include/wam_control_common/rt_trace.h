@@ -0,0 +1,129 @@
+/*
+ * rt_trace.h
+ *
+ * Debug tracing of a signal in the execution graph, in place of
+ * systems::PrintToStream.
+ *
+ * RTTraceSink<T> copies every decimation-th input value, with its tick
+ * number, into a RecordRing (columnar_log.h) as a fixed-size record of
+ * doubles; a background thread formats the records as text lines
+ *
+ *     <prefix><tick> <value_1> .. <value_n>
+ *
+ * and appends them to the file. operate() never formats, locks, allocates
+ * or makes a system call. If the file can't keep up the newest records are
+ * dropped and counted (the gap shows in the tick numbers), so tracing can be
+ * left connected on the real arm. T is anything LogColumn flattens: a
+ * double or a fixed-size vector such as cf_type.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <boost/thread.hpp>
+#include <barrett/os.h>
+#include <barrett/systems/abstract/system.h>
+#include <barrett/systems/abstract/single_io.h>
+#include <barrett/systems/abstract/execution_manager.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/columnar_log.h>
+
+using namespace barrett;
+
+template<typename T>
+class RTTraceSink : public systems::System, public systems::SingleInput<T>
+{
+public:
+	static const double RING_SECONDS;	// [s] of records the writer may fall behind
+
+	// Appends to path; the execution manager starts managing the sink.
+	RTTraceSink(systems::ExecutionManager* em, const std::string& path, const std::string& prefix = "",
+			size_t decimation = 1, const std::string& sysName = "RTTraceSink"):
+		System(sysName), systems::SingleInput<T>(this),
+		ring(WIDTH, capacity(em, decimation)), prefix(prefix), decimation(decimation), ecCount(0), tick(0),
+		file(fopen(path.c_str(), "a")), written(0), running(file != NULL)
+	{
+		if (running.load()) {
+			thread = boost::thread(&RTTraceSink::run, this);
+		}
+		if (em != NULL) {
+			em->startManaging(*this);
+		}
+	}
+
+	virtual ~RTTraceSink() {
+		this->mandatoryCleanUp();
+		if (file != NULL) {
+			running.store(false);
+			thread.join();
+			drain();
+			fclose(file);
+		}
+	}
+
+	bool isOpen() const { return file != NULL; }
+	uint64_t writtenRecords() const { return written.load(std::memory_order_relaxed); }
+	uint64_t droppedRecords() const { return ring.droppedRecords(); }
+
+protected:
+	static const size_t WIDTH = 1 + LogColumn<T>::WIDTH;	// tick, value
+
+	RecordRing ring;
+	std::string prefix;
+	size_t decimation, ecCount;
+	uint64_t tick;
+	double record[WIDTH];
+
+	FILE* file;
+	std::atomic<uint64_t> written;
+	std::atomic<bool> running;
+	boost::thread thread;
+
+	static size_t capacity(systems::ExecutionManager* em, size_t decimation) {
+		const double period = (em != NULL ? em->getPeriod() : 0.002) * decimation;
+		return static_cast<size_t>(RING_SECONDS / period) + 1;
+	}
+
+	virtual void operate() {
+		++tick;
+		if (file != NULL && ++ecCount >= decimation) {
+			ecCount = 0;
+			record[0] = static_cast<double>(tick);
+			LogColumn<T>::copy(this->input.getValue(), record + 1);
+			ring.push(record);
+		}
+	}
+
+	void run() {
+		while (running.load()) {
+			drain();
+			fflush(file);
+			btsleep(0.05);
+		}
+	}
+
+	void drain() {
+		const double* records;
+		for (size_t n = ring.peek(&records); n > 0; n = ring.peek(&records)) {
+			for (size_t i = 0; i < n; ++i) {
+				const double* r = records + i * WIDTH;
+				fprintf(file, "%s%.0f", prefix.c_str(), r[0]);
+				for (size_t k = 1; k < WIDTH; ++k) {
+					fprintf(file, " %.6g", r[k]);
+				}
+				fputc('\n', file);
+			}
+			ring.pop(n);
+			written.fetch_add(n, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(RTTraceSink);
+};
+
+template<typename T> const double RTTraceSink<T>::RING_SECONDS = 2.0;
@@ -0,0 +1,279 @@
+/*
+ * simulated_wam.h
+ *
+ * Hardware-free stand-in for systems::Wam<DOF>, for closed-loop tests and
+ * benchmarks on a plain Linux box.
+ *
+ * WamPlant<DOF> integrates the rigid-body model of rnea_dynamics.h (link
+ * parameters from the WAM's libconfig group, gravity included):
+ *
+ *     M(q) qdd = tau + tau_ext - C(q,qd) qd - g(q) - B qd
+ *
+ * with semi-implicit Euler over a few substeps per control period. M may be
+ * augmented with the reflected rotor inertia and B is an optional viscous
+ * friction.
+ *
+ * SimulatedWam<DOF> wires the plant into the execution graph like the real
+ * arm: a Source publishing jp/jv at the start of the tick, libbarrett's own
+ * KinematicsBase / ToolPosition / ToolVelocity / ToolOrientation /
+ * GravityCompensator on top of it, and jtSum (reference + gravity) feeding a
+ * Sink that advances the plant by one period. The members have the names
+ * graph code already uses on systems::Wam (jpOutput, jvOutput, jtSum,
+ * kinematicsBase, toolPosition, ...), together with trackReferenceSignal(),
+ * idle() and gravityCompensate().
+ *
+ * Nothing waits for the clock, so with a ManualExecutionManager the loop
+ * runs as fast as the graph can be evaluated.
+ */
+
+#pragma once
+
+#include <string>
+#include <eigen3/Eigen/Dense>
+#include <libconfig.h++>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/rnea_dynamics.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+class WamPlant
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef typename RNEA<DOF>::mass_matrix_type mass_matrix_type;
+	typedef typename RNEA<DOF>::joint_vector_type joint_vector_type;
+
+	// wamSetting is the WAM's group in the libbarrett config.
+	explicit WamPlant(const libconfig::Setting& wamSetting, size_t substeps = 4) :
+		rnea(wamSetting), substeps(substeps) {
+		q.setZero();
+		qd.setZero();
+		rotorInertia.setZero();
+		friction.setZero();
+	}
+
+	void setState(const jp_type& jp, const jv_type& jv) {
+		q = jp;
+		qd = jv;
+	}
+	void setRotorInertia(const sqm_type& Mr) { rotorInertia = Mr; }
+	void setViscousFriction(const v_type& B) { friction = B; }
+
+	// Advances the state by dt under constant joint torques.
+	void step(const jt_type& jt, const jt_type& jtExternal, double dt) {
+		const double h = dt / substeps;
+		tau = jt + jtExternal;
+		for (size_t i = 0; i < substeps; ++i) {
+			rnea.update(q);
+			M = rnea.massMatrix() + rotorInertia;
+			bias = rnea.inverseDynamics(qd, joint_vector_type::Zero(), true);	// C qd + g
+			bias += friction.cwiseProduct(qd);
+			llt.compute(M);
+			qdd = llt.solve(tau - bias);
+			qd += h * qdd;
+			q += h * qd;
+		}
+	}
+
+	const joint_vector_type& jointPositions() const { return q; }
+	const joint_vector_type& jointVelocities() const { return qd; }
+	const joint_vector_type& jointAccelerations() const { return qdd; }	// of the last substep
+	RNEA<DOF>& model() { return rnea; }
+
+protected:
+	RNEA<DOF> rnea;
+	size_t substeps;
+
+	joint_vector_type q, qd, qdd, tau, bias;
+	mass_matrix_type M, rotorInertia;
+	joint_vector_type friction;
+	Eigen::LLT<mass_matrix_type> llt;
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+template<size_t DOF>
+class SimulatedWam
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	// jp/jv at the start of the tick. Copied on output, so systems that run
+	// after the Sink in the same tick still see this tick's state.
+	class Source : public systems::System
+	{
+	public:
+		Output<jp_type> jpOutput;
+		Output<jv_type> jvOutput;
+
+	protected:
+		typename Output<jp_type>::Value* jpOutputValue;
+		typename Output<jv_type>::Value* jvOutputValue;
+
+	public:
+		explicit Source(SimulatedWam* parent, const std::string& sysName = "SimulatedWam::Source") :
+			System(sysName), jpOutput(this, &jpOutputValue), jvOutput(this, &jvOutputValue), parent(parent) {}
+		virtual ~Source() { this->mandatoryCleanUp(); }
+
+	protected:
+		SimulatedWam* parent;
+		jp_type jp;
+		jv_type jv;
+
+		virtual void operate() {
+			jp = parent->plant.jointPositions();
+			jv = parent->plant.jointVelocities();
+			jpOutputValue->setData(&jp);
+			jvOutputValue->setData(&jv);
+		}
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(Source);
+
+	public:
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+
+	// Applies jtSum (plus the optional external torque) for one period.
+	class Sink : public systems::System, public systems::SingleInput<jt_type>
+	{
+	public:
+		Input<jt_type> externalTorqueInput;	// optional, e.g. J^T of a contact wrench
+
+		explicit Sink(SimulatedWam* parent, const std::string& sysName = "SimulatedWam::Sink") :
+			System(sysName), systems::SingleInput<jt_type>(this), externalTorqueInput(this), parent(parent), T_s(0.0) {
+			jtExternal.setZero();
+			getSamplePeriodFromEM();
+		}
+		virtual ~Sink() { this->mandatoryCleanUp(); }
+
+	protected:
+		SimulatedWam* parent;
+		double T_s;
+		jt_type jtExternal;
+
+		virtual void onExecutionManagerChanged() {
+			System::onExecutionManagerChanged();
+			getSamplePeriodFromEM();
+		}
+
+		void getSamplePeriodFromEM() {
+			if (this->hasExecutionManager()) {
+				T_s = this->getExecutionManager()->getPeriod();
+			} else {
+				T_s = 0.0;
+			}
+		}
+
+		virtual bool inputsValid() {
+			return this->input.valueDefined();
+		}
+
+		virtual void operate() {
+			if (externalTorqueInput.valueDefined()) {
+				jtExternal = externalTorqueInput.getValue();
+			} else {
+				jtExternal.setZero();
+			}
+			parent->plant.step(this->input.getValue(), jtExternal, T_s);
+		}
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(Sink);
+
+	public:
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+
+public:
+	// Starts at rest at initialPosition, with gravity compensation off and
+	// zero reference torque. Pass em to have the Sink managed right away.
+	SimulatedWam(const libconfig::Setting& wamSetting, const jp_type& initialPosition,
+			systems::ExecutionManager* em = NULL, size_t substeps = 4) :
+		plant(wamSetting, substeps),
+		source(this), sink(this),
+		jpOutput(source.jpOutput), jvOutput(source.jvOutput),
+		kinematicsBase(wamSetting["kinematics"]),
+		gravity(wamSetting["gravity_compensation"]),
+		jtSum(), zeroTorque(jt_type(0.0))
+	{
+		plant.setState(initialPosition, jv_type(0.0));
+
+		systems::connect(source.jpOutput, kinematicsBase.jpInput);
+		systems::connect(source.jvOutput, kinematicsBase.jvInput);
+		systems::connect(kinematicsBase.kinOutput, gravity.kinInput);
+		systems::connect(kinematicsBase.kinOutput, toolPosition.kinInput);
+		systems::connect(kinematicsBase.kinOutput, toolVelocity.kinInput);
+		systems::connect(kinematicsBase.kinOutput, toolOrientation.kinInput);
+
+		systems::connect(zeroTorque.output, jtSum.getInput(0));
+		systems::connect(zeroTorque.output, jtSum.getInput(1));
+		systems::connect(jtSum.output, sink.input);
+
+		if (em != NULL) {
+			em->startManaging(sink);
+		}
+	}
+
+	void trackReferenceSignal(systems::System::Output<jt_type>& referenceSignal) {
+		systems::forceConnect(referenceSignal, jtSum.getInput(0));
+	}
+
+	void idle() {
+		systems::forceConnect(zeroTorque.output, jtSum.getInput(0));
+	}
+
+	void gravityCompensate(bool compensate = true) {
+		if (compensate) {
+			systems::forceConnect(gravity.output, jtSum.getInput(1));
+		} else {
+			systems::forceConnect(zeroTorque.output, jtSum.getInput(1));
+		}
+	}
+
+	// Teleports the arm; takes the execution manager's lock.
+	void setJointState(const jp_type& jp, const jv_type& jv = jv_type(0.0)) {
+		BARRETT_SCOPED_LOCK(sink.getEmMutex());
+		plant.setState(jp, jv);
+	}
+
+	jp_type getJointPositions() {
+		BARRETT_SCOPED_LOCK(sink.getEmMutex());
+		return jp_type(plant.jointPositions());
+	}
+
+	jv_type getJointVelocities() {
+		BARRETT_SCOPED_LOCK(sink.getEmMutex());
+		return jv_type(plant.jointVelocities());
+	}
+
+	// Only while the Sink isn't running (or with the execution manager locked).
+	WamPlant<DOF> plant;
+
+	Source source;
+	Sink sink;
+
+	systems::System::Output<jp_type>& jpOutput;
+	systems::System::Output<jv_type>& jvOutput;
+
+	systems::KinematicsBase<DOF> kinematicsBase;
+	systems::GravityCompensator<DOF> gravity;
+	systems::ToolPosition<DOF> toolPosition;
+	systems::ToolVelocity<DOF> toolVelocity;
+	systems::ToolOrientation<DOF> toolOrientation;
+
+	systems::Summer<jt_type> jtSum;		// 0: reference, 1: gravity compensation
+	systems::Constant<jt_type> zeroTorque;
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(SimulatedWam);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
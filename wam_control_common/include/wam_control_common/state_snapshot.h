@@ -0,0 +1,175 @@
+/*
+ * state_snapshot.h
+ *
+ * Hands the WAM state from the real-time loop to the ROS publisher. The
+ * StateSnapshot System copies everything publishWam() needs into one struct
+ * per tick and publishes it through a triple buffer, so the publisher gets a
+ * coherent sample (all fields from the same tick) without taking the
+ * execution manager's lock, and the RT side never waits for the reader.
+ *
+ * One writer (operate()) and one reader (latest()) only.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <eigen3/Eigen/Geometry>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/math/kinematics.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/kinematics_bundle.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+struct WamStateSnapshot
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+	unsigned long tick;		// 0 until the first sample
+	double t;				// tick * T_s
+
+	jp_type jp;
+	jv_type jv;
+	jt_type jt;
+	cp_type cp;
+	Eigen::Quaterniond orn;
+	cv_type cv;				// tool linear velocity
+	cv_type cw;				// tool angular velocity
+	math::Matrix<6,DOF> J;	// tool Jacobian
+	cf_type cf;				// estimated contact force
+
+	WamStateSnapshot() : tick(0), t(0.0) {
+		jp.setZero(); jv.setZero(); jt.setZero();
+		cp.setZero(); orn.setIdentity(); cv.setZero(); cw.setZero();
+		J.setZero(); cf.setZero();
+	}
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// Single-producer/single-consumer triple buffer. The writer fills
+// writeBuffer() and publish()es it; the reader calls update() and then
+// reads readBuffer(). Neither side blocks.
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : back(0), front(2), middle(1) {}
+
+	T& writeBuffer() { return buf[back]; }
+
+	void publish() {
+		back = middle.exchange(back | DIRTY, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Swaps in the newest published buffer; false if nothing new.
+	bool update() {
+		if ( !(middle.load(std::memory_order_relaxed) & DIRTY)) {
+			return false;
+		}
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	const T& readBuffer() const { return buf[front]; }
+
+protected:
+	static const unsigned int DIRTY = 4;
+	static const unsigned int INDEX = 3;
+
+	T buf[3];
+	unsigned int back, front;	// owned by the writer / the reader
+	std::atomic<unsigned int> middle;
+
+private:
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator=(const TripleBuffer&);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+template<size_t DOF>
+class StateSnapshot : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef WamStateSnapshot<DOF> state_type;
+
+// IO  (inputs)
+public:
+	Input<jp_type> jpInput;
+	Input<jv_type> jvInput;
+	Input<jt_type> jtInput;		// wam.jtSum
+	Input<KinematicsView<DOF> > kinematicsInput;	// cp, cv, cw and J (KinematicsBundle)
+	Input<Eigen::Quaterniond> ornInput;
+	Input<cf_type> cfInput;
+
+public:
+	explicit StateSnapshot(const std::string& sysName = "StateSnapshot"):
+		System(sysName),
+		jpInput(this), jvInput(this), jtInput(this), kinematicsInput(this), ornInput(this), cfInput(this),
+		tick(0), T_s(0.0) {
+		getSamplePeriodFromEM();
+	}
+
+	virtual ~StateSnapshot() { this->mandatoryCleanUp(); }
+
+	// Newest complete sample (tick == 0 before the first one). The reference
+	// stays valid until the next call; call from one thread only.
+	const state_type& latest() {
+		buffer.update();
+		return buffer.readBuffer();
+	}
+
+protected:
+	TripleBuffer<state_type> buffer;
+	unsigned long tick;
+	double T_s;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		getSamplePeriodFromEM();
+	}
+
+	void getSamplePeriodFromEM() {
+		if (this->hasExecutionManager()) {
+			T_s = this->getExecutionManager()->getPeriod();
+		} else {
+			T_s = 0.0;
+		}
+	}
+
+	virtual void operate() {
+		state_type& s = buffer.writeBuffer();
+
+		++tick;
+		s.tick = tick;
+		s.t = tick * T_s;
+
+		s.jp = this->jpInput.getValue();
+		s.jv = this->jvInput.getValue();
+		s.jt = this->jtInput.getValue();
+		s.orn = this->ornInput.getValue();
+		s.cf = this->cfInput.getValue();
+
+		const KinematicsView<DOF>& kin = this->kinematicsInput.getValue();
+		s.cp = kin.position;
+		s.cv = kin.velocity;
+		s.cw = kin.angularVelocity;
+		s.J = kin.J;
+
+		buffer.publish();
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(StateSnapshot);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
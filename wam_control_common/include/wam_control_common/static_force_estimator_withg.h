@@ -13,8 +13,40 @@
 #include <barrett/systems.h>
 #include <barrett/math/kinematics.h> 
 
+#include <wam_control_common/kinematics_bundle.h>
+
 using namespace barrett;
 
+// Solves J^T * w = jt for the tool wrench w (least squares for 7-DOF, minimum
+// pivoted solution for 4-DOF). All storage is fixed-size and sized at
+// construction, so solve() never touches the heap from the real-time thread.
+template<size_t DOF>
+class WrenchSolver
+{
+public:
+	typedef Eigen::Matrix<double, DOF, 6> jacobian_transpose_type;
+	typedef Eigen::Matrix<double, DOF, 1> joint_vector_type;
+	typedef Eigen::Matrix<double, 6, 1> wrench_type;
+
+	WrenchSolver() : qr(DOF, 6) { Jt.setZero(); w.setZero(); }
+
+	template<typename JacobianType>
+	const wrench_type& solve(const JacobianType& J, const joint_vector_type& jt) {
+		Jt = J.transpose();
+		qr.compute(Jt);
+		w = qr.solve(jt);
+		return w;
+	}
+
+protected:
+	jacobian_transpose_type Jt;
+	Eigen::ColPivHouseholderQR<jacobian_transpose_type> qr;
+	wrench_type w;
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 template<size_t DOF>
 class StaticForceEstimatorwithG: public systems::System
 {
@@ -25,7 +57,7 @@ public:
 	Input<jt_type> jtInput;		// joint torque input
 
 public:
-	Input<math::Matrix<6,DOF>> Jacobian;
+	Input<KinematicsView<DOF> > kinematicsInput;	// KinematicsBundle output
 	Input<jt_type> g;
 
 // IO  (outputs)
@@ -40,11 +72,10 @@ protected:
 public:
 cf_type computedF;
 ct_type computedT;
-math::Matrix<6,DOF> J;
 
 public:
 	explicit StaticForceEstimatorwithG(const std::string& sysName = "ForceEstimator"):
-		System(sysName), jtInput(this), Jacobian(this), g(this), cartesianForceOutput(this, &cartesianForceOutputValue), cartesianTorqueOutput(this, &cartesianTorqueOutputValue){}
+		System(sysName), jtInput(this), kinematicsInput(this), g(this), cartesianForceOutput(this, &cartesianForceOutputValue), cartesianTorqueOutput(this, &cartesianTorqueOutputValue){}
 
 	virtual ~StaticForceEstimatorwithG() { this->mandatoryCleanUp(); }
 
@@ -54,18 +85,16 @@ protected:
 
 	jt_type jt_sys, G;
 	jt_type jt;
-	Eigen::VectorXd estimatedF;
+	WrenchSolver<DOF> solver;
+	typename WrenchSolver<DOF>::wrench_type estimatedF;
 
 	virtual void operate() {
 		/*Taking feedback values from the input terminal of this system*/
 		jt_sys = this->jtInput.getValue();
 		G = this->g.getValue();	
-		J = this->Jacobian.getValue();	
-
-		Eigen::ColPivHouseholderQR<Eigen::MatrixXd> system(J.transpose());
 
 		jt = jt_sys - (G);
-		estimatedF = system.solve(jt);
+		estimatedF = solver.solve(this->kinematicsInput.getValue().J, jt);
 
 		computedF << estimatedF[0], estimatedF[1], estimatedF[2];
 		computedT << estimatedF[3], estimatedF[4], estimatedF[5];
@@ -79,4 +108,7 @@ protected:
 
 private:
 	DISALLOW_COPY_AND_ASSIGN(StaticForceEstimatorwithG);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
\ No newline at end of file
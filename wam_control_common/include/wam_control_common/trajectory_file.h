@@ -0,0 +1,232 @@
+/*
+ * trajectory_file.h
+ *
+ * Compact binary format for recorded trajectories and calibration logs
+ * (cp_sample_type / config_sample_type records), with an mmap-backed reader.
+ *
+ * Layout: a 32-byte TrajectoryFileHeader, schemaBytes of column
+ * descriptions, then `rows` records of `cols` native doubles each. A column
+ * is one element of the logged tuple (t, the tool position, the joint
+ * positions, ...) and spans `width` consecutive doubles of the record; for
+ * the recorders that is t, x, y, z[, q_1 .. q_DOF]. The reader maps the file
+ * read-only and exposes the columns as strided Eigen::Maps over the mapping,
+ * so loading is an open + mmap regardless of the length.
+ *
+ * Version 1 files have no schema. ColumnarLogger (columnar_log.h) writes
+ * version 2 files directly from the real-time thread; a log that was never
+ * closed has rows = 0 and is read up to its last complete record. CSV files
+ * from before this format can be converted with trajectory_converter
+ * (wam_spf_control) or convertCSVToTrajectoryFile().
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <eigen3/Eigen/Core>
+
+static const char TRAJECTORY_FILE_MAGIC[8] = {'W', 'A', 'M', 'T', 'R', 'J', '\0', '\0'};
+static const uint32_t TRAJECTORY_FILE_VERSION = 2;
+static const uint32_t TRAJECTORY_FILE_BYTE_ORDER = 0x01020304;
+
+struct TrajectoryFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;	// TRAJECTORY_FILE_BYTE_ORDER as written by the recording machine
+	uint32_t cols;		// doubles per record
+	uint32_t schemaBytes;	// TrajectoryFileColumns between the header and the records (0 in version 1)
+	uint64_t rows;		// number of records; 0 while a log is being written
+};
+
+static const uint32_t TRAJECTORY_FILE_FLOAT64 = 0;
+
+struct TrajectoryFileColumn {
+	char name[24];		// NUL-terminated
+	uint32_t width;		// doubles in this column
+	uint32_t type;		// TRAJECTORY_FILE_FLOAT64
+};
+
+class TrajectoryFile {
+public:
+	typedef Eigen::Map<const Eigen::VectorXd, 0, Eigen::InnerStride<> > time_map;
+	typedef Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic>, 0, Eigen::OuterStride<> > position_map;
+	typedef Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<> > joint_map;
+
+	TrajectoryFile() : base(NULL), length(0), data(NULL), schema(NULL), nRows(0), nCols(0), nColumns(0) {}
+	explicit TrajectoryFile(const std::string& path) : base(NULL), length(0), data(NULL), schema(NULL), nRows(0), nCols(0), nColumns(0) {
+		open(path);
+	}
+	~TrajectoryFile() { close(); }
+
+	// Maps `path`. Returns false (and stays closed) if the file is missing or
+	// is not a trajectory file of a supported version.
+	bool open(const std::string& path) {
+		close();
+
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == -1 || (size_t) st.st_size < sizeof(TrajectoryFileHeader)) {
+			::close(fd);
+			return false;
+		}
+		void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED) {
+			return false;
+		}
+		base = p;
+		length = st.st_size;
+
+		const TrajectoryFileHeader* h = static_cast<const TrajectoryFileHeader*>(base);
+		const size_t schemaBytes = h->version >= 2 ? h->schemaBytes : 0;
+		if (memcmp(h->magic, TRAJECTORY_FILE_MAGIC, sizeof(h->magic)) != 0 || h->version < 1 || h->version > TRAJECTORY_FILE_VERSION
+				|| h->byteOrder != TRAJECTORY_FILE_BYTE_ORDER || h->cols < 1
+				|| schemaBytes % sizeof(TrajectoryFileColumn) != 0 || length - sizeof(TrajectoryFileHeader) < schemaBytes) {
+			close();
+			return false;
+		}
+		const size_t available = (length - sizeof(TrajectoryFileHeader) - schemaBytes) / sizeof(double) / h->cols;
+		if (h->rows > available) {
+			close();
+			return false;
+		}
+		nRows = h->rows > 0 ? h->rows : available;
+		nCols = h->cols;
+		schema = reinterpret_cast<const TrajectoryFileColumn*>(static_cast<const char*>(base) + sizeof(TrajectoryFileHeader));
+		nColumns = schemaBytes / sizeof(TrajectoryFileColumn);
+		size_t width = 0;
+		for (size_t i = 0; i < nColumns; ++i) {
+			width += schema[i].width;
+		}
+		if (nColumns > 0 && width != nCols) {
+			close();
+			return false;
+		}
+		data = reinterpret_cast<const double*>(static_cast<const char*>(base) + sizeof(TrajectoryFileHeader) + schemaBytes);
+		return true;
+	}
+
+	void close() {
+		if (base != NULL) {
+			munmap(base, length);
+		}
+		base = NULL;
+		length = 0;
+		data = NULL;
+		schema = NULL;
+		nRows = nCols = nColumns = 0;
+	}
+
+	bool isOpen() const { return base != NULL; }
+	size_t rows() const { return nRows; }
+	size_t cols() const { return nCols; }
+	size_t jointCount() const { return nCols > 4 ? nCols - 4 : 0; }
+
+	// Schema of a version 2 file (none for version 1).
+	size_t columnCount() const { return nColumns; }
+	const char* columnName(size_t i) const { return schema[i].name; }
+	size_t columnWidth(size_t i) const { return schema[i].width; }
+
+	// Views into the mapping; valid until close(). The trajectory views
+	// assume the t, x, y, z[, q ...] layout of the recorders.
+	time_map time() const { return time_map(data, nRows, Eigen::InnerStride<>(nCols)); }
+	position_map positions() const { return position_map(data + 1, 3, nRows, Eigen::OuterStride<>(nCols)); }
+	joint_map jointPositions() const { return joint_map(data + 4, jointCount(), nRows, Eigen::OuterStride<>(nCols)); }
+
+	// The named column, one record per Eigen column; empty if there is no
+	// such column.
+	joint_map column(const std::string& name) const {
+		size_t offset = 0;
+		for (size_t i = 0; i < nColumns; ++i) {
+			if (name == schema[i].name) {
+				return joint_map(data + offset, schema[i].width, nRows, Eigen::OuterStride<>(nCols));
+			}
+			offset += schema[i].width;
+		}
+		return joint_map(data, 0, 0, Eigen::OuterStride<>(nCols));
+	}
+
+protected:
+	void* base;
+	size_t length;
+	const double* data;
+	const TrajectoryFileColumn* schema;
+	size_t nRows, nCols, nColumns;
+
+private:
+	TrajectoryFile(const TrajectoryFile&);
+	TrajectoryFile& operator=(const TrajectoryFile&);
+};
+
+// Writes `records` (one record per column: t, x, y, z[, q ...]) to `path`.
+inline bool writeTrajectoryFile(const std::string& path, const Eigen::MatrixXd& records) {
+	if (records.rows() < 4) {
+		return false;
+	}
+	TrajectoryFileHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, TRAJECTORY_FILE_MAGIC, sizeof(h.magic));
+	h.version = TRAJECTORY_FILE_VERSION;
+	h.byteOrder = TRAJECTORY_FILE_BYTE_ORDER;
+	h.cols = records.rows();
+	h.rows = records.cols();
+
+	std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+	if ( !out.is_open()) {
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(double));
+	return out.good();
+}
+
+// Converts a CSV exported by log::Reader::exportCSV() (one record per line,
+// comma separated, same number of fields on every line).
+inline bool convertCSVToTrajectoryFile(const std::string& csvPath, const std::string& path) {
+	std::ifstream in(csvPath.c_str());
+	if ( !in.is_open()) {
+		return false;
+	}
+
+	std::vector<double> values;
+	size_t cols = 0, rows = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		const char* s = line.c_str();
+		char* end;
+		size_t n = 0;
+		for (double v = strtod(s, &end); end != s; v = strtod(s, &end)) {
+			values.push_back(v);
+			++n;
+			s = end;
+			while (*s == ' ' || *s == ',') {
+				++s;
+			}
+		}
+		if (n == 0) {
+			continue;
+		}
+		if (cols == 0) {
+			cols = n;
+		} else if (n != cols) {
+			return false;
+		}
+		++rows;
+	}
+	if (cols < 4) {
+		return false;
+	}
+	return writeTrajectoryFile(path, Eigen::Map<const Eigen::MatrixXd>(values.data(), cols, rows));
+}
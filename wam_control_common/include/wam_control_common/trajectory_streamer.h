@@ -0,0 +1,299 @@
+/*
+ * trajectory_streamer.h
+ *
+ * Streams a preloaded Cartesian trajectory to the impedance controller,
+ * interpolating on every execution-manager tick instead of stepping the
+ * setpoint from a service thread.
+ *
+ * Position: cubic Hermite through the knots with Catmull-Rom tangents
+ * (time-weighted, zero velocity at the first and last knot).
+ * Orientation: SLERP between consecutive knot quaternions.
+ *
+ * A CubicBezier can be streamed instead of knots: the arc length follows a
+ * rest-to-rest quintic s(t) and the setpoint is sampled from the curve with
+ * sampleAtLength() every tick, so approaches need no waypoint vector.
+ *
+ * velocityOutput is the derivative of the streamed setpoint (zero while
+ * holding), for velocity feedforward.
+ *
+ * Knot storage is allocated once at construction. enqueue(), hold() and
+ * cancel() take the execution manager's mutex, so they can be called from
+ * ROS service threads while the trajectory is playing; isDone() reads an
+ * atomic flag. operate() never allocates.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <eigen3/Eigen/Geometry>
+#include <eigen3/Eigen/StdVector>
+#include <barrett/os.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/cubic_bezier.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+class TrajectoryStreamer : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef std::vector<Eigen::Quaterniond, Eigen::aligned_allocator<Eigen::Quaterniond> > quaternion_vector;
+
+	static const double MIN_KNOT_INTERVAL;	// [s] shortest time between knots
+
+// IO  (outputs)
+public:
+	Output<cp_type> positionOutput;
+	Output<Eigen::Quaterniond> orientationOutput;
+	Output<cv_type> velocityOutput;
+
+protected:
+	typename Output<cp_type>::Value* positionOutputValue;
+	typename Output<Eigen::Quaterniond>::Value* orientationOutputValue;
+	typename Output<cv_type>::Value* velocityOutputValue;
+
+public:
+	explicit TrajectoryStreamer(size_t capacity = 4096, const std::string& sysName = "TrajectoryStreamer"):
+		System(sysName), positionOutput(this, &positionOutputValue), orientationOutput(this, &orientationOutputValue),
+		velocityOutput(this, &velocityOutputValue),
+		knots(capacity), orns(capacity), times(capacity), n(0), seg(0), t(0.0), T_s(0.0), holding(false), active(false),
+		curve(CubicBezier::between(Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero(), 0.0)), curveMode(false), curveDuration(0.0),
+		cv_out(0.0) {
+		getSamplePeriodFromEM();
+	}
+
+	virtual ~TrajectoryStreamer() { this->mandatoryCleanUp(); }
+
+	// Stop any motion and hold the given pose.
+	void hold(const cp_type& cp, const Eigen::Quaterniond& orn) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		cp_out = cp;
+		orn_out = orn;
+		cv_out.setZero();
+		n = 0;
+		curveMode = false;
+		active = false;
+		holding = true;
+	}
+
+	// Append waypoints. dt[i] is the time from the previous knot to pts[i]
+	// (the first one is measured from the current setpoint if idle). An empty
+	// orns keeps the last orientation. Returns false if the buffer is full,
+	// nothing is held yet or a curve is playing.
+	bool enqueue(const std::vector<cp_type>& pts, const quaternion_vector& orns_in, const std::vector<double>& dt) {
+		if (pts.size() != dt.size() || ( !orns_in.empty() && orns_in.size() != pts.size())) {
+			return false;
+		}
+
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		if ( !holding || curveMode ) {
+			return false;
+		}
+		if ( !active ) {
+			// restart from where the setpoint currently is
+			knots[0] = cp_out;
+			orns[0] = orn_out;
+			times[0] = 0.0;
+			n = 1;
+			seg = 0;
+			t = 0.0;
+		}
+		if (n + pts.size() > knots.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < pts.size(); ++i) {
+			knots[n] = pts[i];
+			orns[n] = orns_in.empty() ? orns[n - 1] : orns_in[i];
+			if (orns[n].coeffs().dot(orns[n - 1].coeffs()) < 0.0) {
+				orns[n].coeffs() = -orns[n].coeffs();	// shortest path for SLERP
+			}
+			times[n] = times[n - 1] + std::max(dt[i], std::max(T_s, MIN_KNOT_INTERVAL));
+			++n;
+		}
+		active = n > 1;
+		return true;
+	}
+
+	// Knot times from chord length at a constant speed [m/s]. Returns false
+	// for a speed that is not positive.
+	bool enqueue(const std::vector<cp_type>& pts, const quaternion_vector& orns_in, double speed) {
+		if ( !(speed > 0.0) ) {
+			return false;
+		}
+		std::vector<double> dt(pts.size());
+		cp_type prev = currentPosition();
+		for (size_t i = 0; i < pts.size(); ++i) {
+			dt[i] = (pts[i] - prev).norm() / speed;
+			prev = pts[i];
+		}
+		return enqueue(pts, orns_in, dt);
+	}
+
+	// Stream path from its start (which should be the held setpoint) to its
+	// end, rotating to orn on the way. The quintic timing law peaks at speed
+	// [m/s] halfway along. Returns false if speed is not positive, nothing is
+	// held yet or a trajectory is still playing.
+	bool enqueue(const CubicBezier& path, const Eigen::Quaterniond& orn, double speed) {
+		if ( !(speed > 0.0) ) {
+			return false;
+		}
+
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		if ( !holding || active ) {
+			return false;
+		}
+		curve = path;
+		curveOrnStart = orn_out;
+		curveOrnEnd = orn;
+		if (curveOrnEnd.coeffs().dot(curveOrnStart.coeffs()) < 0.0) {
+			curveOrnEnd.coeffs() = -curveOrnEnd.coeffs();	// shortest path for SLERP
+		}
+		curveDuration = std::max(QUINTIC_PEAK_SPEED * curve.length() / speed, std::max(T_s, MIN_KNOT_INTERVAL));
+		t = 0.0;
+		curveMode = true;
+		active = true;
+		return true;
+	}
+
+	// Stop at the current setpoint and drop the remaining knots.
+	void cancel() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		n = 0;
+		curveMode = false;
+		cv_out.setZero();
+		active = false;
+	}
+
+	bool isDone() const { return !active; }
+
+	// Blocks the calling (non real-time) thread until the trajectory is done.
+	void waitForCompletion(double pollPeriod = 0.01) const {
+		while ( !isDone() ) {
+			btsleep(pollPeriod);
+		}
+	}
+
+	cp_type currentPosition() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		if ( !active ) {
+			return cp_out;
+		}
+		return curveMode ? cp_type(curve.position(1.0)) : knots[n - 1];
+	}
+
+protected:
+	std::vector<cp_type> knots;
+	quaternion_vector orns;
+	std::vector<double> times;
+	size_t n, seg;
+	double t, T_s;
+	bool holding;
+	std::atomic<bool> active;	// read by isDone() without the lock
+
+	static const double QUINTIC_PEAK_SPEED;	// peak of ds/dt for s(t) over unit length and duration
+
+	CubicBezier curve;
+	bool curveMode;
+	double curveDuration;
+	Eigen::Quaterniond curveOrnStart, curveOrnEnd;
+	Eigen::Vector3d p, dp, ddp;	// this tick's sample of the curve
+
+	cp_type cp_out;
+	Eigen::Quaterniond orn_out;
+	cv_type cv_out;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		getSamplePeriodFromEM();
+	}
+
+	void getSamplePeriodFromEM() {
+		if (this->hasExecutionManager()) {
+			T_s = this->getExecutionManager()->getPeriod();
+		} else {
+			T_s = 0.0;
+		}
+	}
+
+	// Catmull-Rom tangent at knot i, zero at the ends
+	cp_type tangent(size_t i) const {
+		if (i == 0 || i + 1 >= n) {
+			return cp_type(0.0);
+		}
+		return (knots[i + 1] - knots[i - 1]) / (times[i + 1] - times[i - 1]);
+	}
+
+	// One tick along the curve: quintic s(t), then an O(1) sample at s
+	void operateCurve() {
+		t += T_s;
+		if (t >= curveDuration) {
+			cp_out = curve.position(1.0);
+			orn_out = curveOrnEnd;
+			cv_out.setZero();
+			curveMode = false;
+			active = false;
+			return;
+		}
+		const double u = t / curveDuration, u2 = u * u, u3 = u2 * u;
+		const double f = u3 * (10.0 - 15.0 * u + 6.0 * u2);			// s / length
+		const double fd = 30.0 * u2 * (1.0 - 2.0 * u + u2) / curveDuration;	// ds/dt / length
+		curve.sampleAtLength(f * curve.length(), p, dp, ddp);
+		cp_out = p;
+		cv_out = dp * (fd * curve.length());
+		orn_out = curveOrnStart.slerp(f, curveOrnEnd);
+	}
+
+	virtual void operate() {
+		if (active && curveMode) {
+			operateCurve();
+		} else if (active) {
+			t += T_s;
+			while (seg + 2 < n && t >= times[seg + 1]) {
+				++seg;
+			}
+
+			if (t >= times[n - 1]) {
+				cp_out = knots[n - 1];
+				orn_out = orns[n - 1];
+				cv_out.setZero();
+				active = false;
+			} else {
+				const double h = times[seg + 1] - times[seg];
+				const double s = (t - times[seg]) / h;
+				const double s2 = s * s, s3 = s2 * s;
+				cp_out = (2 * s3 - 3 * s2 + 1) * knots[seg] + (s3 - 2 * s2 + s) * h * tangent(seg)
+						+ (-2 * s3 + 3 * s2) * knots[seg + 1] + (s3 - s2) * h * tangent(seg + 1);
+				cv_out = (6 * s2 - 6 * s) / h * knots[seg] + (3 * s2 - 4 * s + 1) * tangent(seg)
+						+ (6 * s - 6 * s2) / h * knots[seg + 1] + (3 * s2 - 2 * s) * tangent(seg + 1);
+				orn_out = orns[seg].slerp(s, orns[seg + 1]);
+			}
+		}
+
+		if (holding) {
+			positionOutputValue->setData(&cp_out);
+			orientationOutputValue->setData(&orn_out);
+			velocityOutputValue->setData(&cv_out);
+		} else {
+			positionOutputValue->setUndefined();
+			orientationOutputValue->setUndefined();
+			velocityOutputValue->setUndefined();
+		}
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(TrajectoryStreamer);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// One WAM tick, so knot times stay strictly increasing before T_s is known
+template<size_t DOF> const double TrajectoryStreamer<DOF>::MIN_KNOT_INTERVAL = 0.002;
+template<size_t DOF> const double TrajectoryStreamer<DOF>::QUINTIC_PEAK_SPEED = 1.875;
@@ -0,0 +1,77 @@
+/*
+ * cubic_bezier_test.cpp
+ *
+ * CubicBezier arc-length parameterization against a fine numerical
+ * integration of |B'(t)|, on a general curve and on the ease-in/ease-out
+ * lines between() gives for offset 0, which stop with zero speed at both
+ * ends.
+ */
+
+#include <wam_control_common/cubic_bezier.h>
+#include <cmath>
+#include <gtest/gtest.h>
+
+namespace {
+
+const int STEPS = 200000;	// midpoint rule for the reference arc length
+
+// Arc length from 0 to t, midpoint rule
+double arcLength(const CubicBezier& curve, double t) {
+	double s = 0.0;
+	const double h = t / STEPS;
+	for (int i = 0; i < STEPS; ++i) {
+		s += curve.velocity((i + 0.5) * h).norm() * h;
+	}
+	return s;
+}
+
+void checkInverse(const CubicBezier& curve) {
+	const double L = curve.length();
+	EXPECT_NEAR(L, arcLength(curve, 1.0), 1e-9);
+
+	// through the table, and down to the first tick of a slow start
+	const double fractions[] = { 1e-12, 1e-9, 1e-6, 1e-3, 0.01, 0.1, 0.37, 0.5, 0.9, 0.99, 1.0 - 1e-6, 1.0 - 1e-12 };
+	for (size_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); ++i) {
+		const double s = fractions[i] * L;
+		const double t = curve.parameterAt(s);
+		EXPECT_NEAR(arcLength(curve, t), s, 1e-6 * L) << "s / L = " << fractions[i];
+	}
+	EXPECT_EQ(curve.parameterAt(0.0), 0.0);
+	EXPECT_EQ(curve.parameterAt(L), 1.0);
+}
+
+TEST(CubicBezier, ParameterAtInvertsArcLength) {
+	checkInverse(CubicBezier(Eigen::Vector3d(0.0, 0.0, 0.0), Eigen::Vector3d(0.1, 0.3, 0.0),
+			Eigen::Vector3d(0.4, -0.1, 0.2), Eigen::Vector3d(0.5, 0.2, 0.1)));
+	checkInverse(CubicBezier::between(Eigen::Vector3d(0.4, -0.1, 0.2), Eigen::Vector3d(0.6, 0.1, -0.1), 0.5));
+}
+
+TEST(CubicBezier, ParameterAtInvertsArcLengthFromRest) {
+	checkInverse(CubicBezier::between(Eigen::Vector3d(0.6, 0.1, -0.1), Eigen::Vector3d(0.4, -0.1, 0.2), 0.0));
+}
+
+TEST(CubicBezier, SampleAtLengthIsUnitSpeed) {
+	const CubicBezier curve = CubicBezier::between(Eigen::Vector3d(0.4, -0.1, 0.2), Eigen::Vector3d(0.6, 0.1, -0.1), 0.5);
+	Eigen::Vector3d p, dp, ddp;
+	for (int i = 1; i < 100; ++i) {
+		const double s = i / 100.0 * curve.length();
+		curve.sampleAtLength(s, p, dp, ddp);
+		EXPECT_NEAR(dp.norm(), 1.0, 1e-12);
+		EXPECT_NEAR(dp.dot(ddp), 0.0, 1e-9);	// arc-length parameterized: B'' is normal to B'
+
+		// against central differences in s
+		const double h = 1e-5;
+		Eigen::Vector3d pp, pm, d;
+		curve.sampleAtLength(s + h, pp, d, d);
+		curve.sampleAtLength(s - h, pm, d, d);
+		EXPECT_LE(((pp - pm) / (2.0 * h) - dp).norm(), 1e-6);
+		EXPECT_LE(((pp - 2.0 * p + pm) / (h * h) - ddp).norm(), 1e-2 * (1.0 + ddp.norm()));
+	}
+}
+
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/*
+ * trajectory_streamer_test.cpp
+ *
+ * TrajectoryStreamer streaming a CubicBezier: the setpoint starts at rest on
+ * the held pose, stays on the curve, ends at rest on its end, peaks at the
+ * requested speed, and velocityOutput is the derivative of positionOutput.
+ * Both speed overloads of enqueue() refuse a speed that is not positive.
+ */
+
+#include <wam_control_common/trajectory_streamer.h>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+
+using namespace barrett;
+
+namespace {
+
+typedef units::CartesianPosition::type cp_type;
+typedef units::CartesianVelocity::type cv_type;
+
+const double T_S = 0.002;	// [s] as on the WAM
+const double SPEED = 0.05;	// [m/s]
+
+// Latches its input every tick so the outputs can be read back
+template<typename T>
+class Sink : public systems::System {
+public:
+	Input<T> input;
+	T value;
+
+	Sink() : System("Sink"), input(this) {}
+	virtual ~Sink() { this->mandatoryCleanUp(); }
+
+protected:
+	virtual void operate() { value = input.getValue(); }
+};
+
+TEST(TrajectoryStreamer, StreamsCubicBezierAtRestToRest) {
+	systems::ManualExecutionManager mem(T_S);
+	TrajectoryStreamer<4> streamer(2);
+	Sink<cp_type> position;
+	Sink<cv_type> velocity;
+	Sink<Eigen::Quaterniond> orientation;
+	systems::connect(streamer.positionOutput, position.input);
+	systems::connect(streamer.velocityOutput, velocity.input);
+	systems::connect(streamer.orientationOutput, orientation.input);
+	mem.startManaging(position);
+	mem.startManaging(velocity);
+	mem.startManaging(orientation);
+	mem.startManaging(streamer);	// for its sample period
+
+	const cp_type start(0.4, -0.1, 0.2), end(0.6, 0.1, -0.1);
+	const CubicBezier curve = CubicBezier::between(start, end, 0.5);
+	const Eigen::Quaterniond ornStart = Eigen::Quaterniond::Identity();
+	const Eigen::Quaterniond ornEnd(Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitZ()));
+
+	streamer.hold(start, ornStart);
+	ASSERT_TRUE(streamer.enqueue(curve, ornEnd, SPEED));
+	EXPECT_FALSE(streamer.isDone());
+	EXPECT_LE((streamer.currentPosition() - end).norm(), 1e-12);
+
+	// one tick at a time until done, checking each step
+	cp_type prev = start;
+	double peak = 0.0;
+	size_t ticks = 0;
+	while ( !streamer.isDone() ) {
+		mem.runExecutionCycle();
+		++ticks;
+		ASSERT_LT(ticks, 100000u);
+
+		const double speed = velocity.value.norm();
+		peak = std::max(peak, speed);
+
+		// the finite difference of the setpoint matches the velocity output
+		// to first order in T_S
+		const cv_type fd = (position.value - prev) / T_S;
+		EXPECT_LE((fd - velocity.value).norm(), 1e-3) << "tick " << ticks;
+		prev = position.value;
+
+		// and the setpoint is a point of the curve
+		double best = 1e9;
+		for (int k = 0; k <= 1000; ++k) {
+			best = std::min(best, (curve.position(k / 1000.0) - position.value).norm());
+		}
+		EXPECT_LE(best, 1e-3) << "tick " << ticks;
+	}
+
+	EXPECT_LE((position.value - end).norm(), 1e-12);
+	EXPECT_EQ(velocity.value.norm(), 0.0);
+	EXPECT_NEAR(std::fabs(orientation.value.dot(ornEnd)), 1.0, 1e-12);
+	EXPECT_NEAR(peak, SPEED, 1e-3 * SPEED);
+	EXPECT_NEAR(ticks * T_S, 1.875 * curve.length() / SPEED, 2 * T_S);
+
+	// the first sample leaves the start at rest
+	streamer.hold(end, ornEnd);
+	ASSERT_TRUE(streamer.enqueue(CubicBezier::between(end, start, 0.0), ornStart, SPEED));
+	mem.runExecutionCycle();
+	EXPECT_LE((position.value - end).norm(), 1e-6);
+	EXPECT_LE(velocity.value.norm(), 1e-3 * SPEED);
+
+	// no knots can be appended to a curve, nor a curve to a moving setpoint
+	std::vector<cp_type> pts(1, start);
+	std::vector<double> dt(1, 1.0);
+	EXPECT_FALSE(streamer.enqueue(pts, TrajectoryStreamer<4>::quaternion_vector(), dt));
+	EXPECT_FALSE(streamer.enqueue(curve, ornEnd, SPEED));
+
+	// cancel() stops at the current setpoint
+	streamer.cancel();
+	EXPECT_TRUE(streamer.isDone());
+	const cp_type stopped = position.value;
+	mem.runExecutionCycle();
+	EXPECT_LE((position.value - stopped).norm(), 1e-12);
+	EXPECT_EQ(velocity.value.norm(), 0.0);
+}
+
+}
+
+TEST(TrajectoryStreamer, RejectsSpeedsThatAreNotPositive) {
+	systems::ManualExecutionManager mem(T_S);
+	TrajectoryStreamer<4> streamer(2);
+	mem.startManaging(streamer);
+
+	const cp_type start(0.4, -0.1, 0.2), end(0.6, 0.1, -0.1);
+	const CubicBezier curve = CubicBezier::between(start, end, 0.5);
+	const std::vector<cp_type> pts(1, end);
+	streamer.hold(start, Eigen::Quaterniond::Identity());
+
+	const double speeds[] = { 0.0, -SPEED, std::nan("") };
+	for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+		EXPECT_FALSE(streamer.enqueue(curve, Eigen::Quaterniond::Identity(), speeds[i])) << speeds[i];
+		EXPECT_FALSE(streamer.enqueue(pts, TrajectoryStreamer<4>::quaternion_vector(), speeds[i])) << speeds[i];
+		EXPECT_TRUE(streamer.isDone());
+	}
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
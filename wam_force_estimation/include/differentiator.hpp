@@ -3,11 +3,28 @@
  *
  *  Created on: 28-Feb-2015
  *      Author: nilxwam
+ *
+ * Savitzky-Golay smoother/differentiator over a sliding window.
+ *
+ * The window length and polynomial order are free (window <= MAX_WINDOW,
+ * order < window); the least-squares coefficients are computed once at
+ * construction. Samples go into a fixed-size ring that stores every sample
+ * twice (at i and i + window), so the last `window` samples are always one
+ * contiguous block and each tick is a single insert plus three dot products
+ * per joint, with no shifting and no allocation.
+ *
+ * `lag` picks the sample the polynomial is evaluated at, counted back from
+ * the newest one: 0 gives causal end-point estimates, (window - 1) / 2 gives
+ * the classic centered filter (less noise, (window - 1) / 2 ticks of delay).
+ *
+ * Outputs: smoothedOutput (T1), outputSignal = first derivative (T2) and
+ * secondDerivativeOutput (also T2, scaled per second squared).
  */
 
 #ifndef DIFFERENTIATOR_HPP_
 #define DIFFERENTIATOR_HPP_
 
+#include <stdexcept>
 #include <barrett/math/traits.h>
 #include <list>
 #include <barrett/units.h>
@@ -15,6 +32,7 @@
 #include <barrett/systems/abstract/system.h>
 
 #include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Dense>
 #include <libconfig.h++>
 
 #include <barrett/detail/ca_macro.h>
@@ -25,7 +43,7 @@
 using namespace barrett;
 using namespace systems;
 
-template<size_t DOF, class T1, class T2>
+template<size_t DOF, class T1, class T2, int MAX_WINDOW = 32>
 class differentiator: public System {
 
 	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
@@ -35,23 +53,56 @@ public:
 	Input<T1> inputSignal; // the input signal is either a jp_type , jv_type
 
 public:
-	Output<T2> outputSignal; // the output signal is either a jv_type , jv_type
+	Output<T2> outputSignal; // first derivative, either a jv_type , ja_type
+	Output<T1> smoothedOutput; // smoothed input signal
+	Output<T2> secondDerivativeOutput; // second derivative
 
 protected:
 	typename Output<T2>::Value* outputSignalOutputValue;
+	typename Output<T1>::Value* smoothedOutputValue;
+	typename Output<T2>::Value* secondDerivativeOutputValue;
 
 public:
 T2 outputSignalValue;
 
 public:
-	differentiator(int MODE) :
-			time(this), inputSignal(this), outputSignal(this,
-					&outputSignalOutputValue), mode(MODE) {
-//		if (mode == 0 || mode == 1 || mode == 2) { // Mode denotes the total number of data that has to be used to estimate
-//			printf("set correct mode");
-//		}
-		container = Eigen::MatrixXd::Zero(mode, (int) DOF);
-		time_vector = Eigen::Vector2d::Zero();
+	explicit differentiator(int window, int order = 2, int lag = 0) :
+			time(this), inputSignal(this), outputSignal(this, &outputSignalOutputValue),
+			smoothedOutput(this, &smoothedOutputValue),
+			secondDerivativeOutput(this, &secondDerivativeOutputValue),
+			window(window), head(0), initialized(false), prev_time(0.0), del_time(0.0) {
+		if (window < 2 || window > MAX_WINDOW) {
+			throw std::invalid_argument("(differentiator::differentiator()): window must be in [2, MAX_WINDOW].");
+		}
+		if (order < 1 || order >= window) {
+			throw std::invalid_argument("(differentiator::differentiator()): order must be in [1, window - 1].");
+		}
+		if (lag < 0 || lag >= window) {
+			throw std::invalid_argument("(differentiator::differentiator()): lag must be in [0, window - 1].");
+		}
+
+		// Least-squares fit of a degree-`order` polynomial to samples at
+		// tau = j - (window - 1 - lag), j = 0 (oldest) .. window - 1 (newest);
+		// row d of (A^T A)^-1 A^T times d! is the d-th derivative at tau = 0.
+		Eigen::MatrixXd A(window, order + 1);
+		for (int j = 0; j < window; ++j) {
+			double tau = j - (window - 1 - lag);
+			A(j, 0) = 1.0;
+			for (int k = 1; k <= order; ++k) {
+				A(j, k) = A(j, k - 1) * tau;
+			}
+		}
+		Eigen::MatrixXd P = (A.transpose() * A).ldlt().solve(A.transpose());
+
+		c0.setZero();
+		c1.setZero();
+		c2.setZero();
+		c0.head(window) = P.row(0).transpose();
+		c1.head(window) = P.row(1).transpose();
+		if (order >= 2) {
+			c2.head(window) = 2.0 * P.row(2).transpose();
+		}
+		samples.setZero();
 	}
 
 	virtual ~differentiator() {
@@ -59,72 +110,61 @@ public:
 	}
 
 protected:
-	int mode; // the mode of differentiator
-	Eigen::MatrixXd container;
-	int i, j;
-	Eigen::RowVectorXd diff_output;
-	Eigen::Vector2d time_vector;
-	double del_time;
-	T2 tmp_out_value;
-	double tmp_time;
+	int window; // number of samples in the fit
+	int head; // ring position of the next write
+	bool initialized;
+	Eigen::Matrix<double, DOF, 2 * MAX_WINDOW> samples;
+	Eigen::Matrix<double, MAX_WINDOW, 1> c0, c1, c2;
+	Eigen::Matrix<double, DOF, 1> x;
+	double prev_time, del_time;
+	T1 smoothed_value;
+	T2 tmp_out_value, second_value;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		if (this->hasExecutionManager()) {
+			del_time = this->getExecutionManager()->getPeriod();
+		}
+	}
 
 	virtual void operate() {
-
-		time_vector[0] = time_vector[1];
-		time_vector[1] = this->time.getValue();
-		del_time = time_vector[0] - time_vector[1];
-
-		for (j = 0; j < mode - 1; j++) {
-			for (i = 0; i < (int) DOF; i++) {
-				container(j, i) = container(j + 1, i);
-			}
+		const double t = this->time.getValue();
+		if (initialized && t > prev_time) {
+			del_time = t - prev_time;
 		}
-		for (i = 0; i < (int) DOF; i++) // updating the last entry
-				{
-			container(mode - 1, i) = this->inputSignal.getValue()[i];
-		}
-
-		if (mode == 3) // for mode 2
-				{
-			diff_output = (container.block(0, 0, 1, (int) DOF)
-					- container.block(2, 0, 1, (int) DOF)) / (2.0 * del_time);
+		prev_time = t;
 
+		x = this->inputSignal.getValue();
+		if ( !initialized ) {
+			// start from rest at the first sample instead of ramping up from zero
+			samples = x.replicate(1, 2 * MAX_WINDOW);
+			initialized = true;
 		}
-		if (mode == 4) // for mode 3
-				{
-			diff_output = (container.block(0, 0, 1, (int) DOF)
-					+ container.block(1, 0, 1, (int) DOF)
-					- container.block(2, 0, 1, (int) DOF)
-					- container.block(3, 0, 1, (int) DOF)) / (4.0 * del_time);
-		}
-		if (mode == 5) // for mode 4
-				{
-			diff_output = (container.block(0, 0, 1, (int) DOF)
-					+ 2.0 * container.block(1, 0, 1, (int) DOF)
-					- 2.0 * container.block(3, 0, 1, (int) DOF)
-					- container.block(4, 0, 1, (int) DOF)) / (8.0 * del_time);
-		}
-		if (mode == 6) // for mode 5
-				{
-			diff_output = (container.block(0, 0, 1, (int) DOF)
-					+ 3.0 * container.block(1, 0, 1, (int) DOF)
-					+ 2.0 * container.block(2, 0, 1, (int) DOF)
-					- 2.0 * container.block(2, 0, 1, (int) DOF)
-					- 3.0 * container.block(4, 0, 1, (int) DOF)
-					- 1.0 * container.block(5, 0, 1, (int) DOF)
-			) / (16.0 * del_time);
+		samples.col(head) = x;
+		samples.col(head + window) = x;
+		head = (head + 1) % window;
+
+		// oldest .. newest are contiguous at [head, head + window)
+		smoothed_value = samples.block(0, head, DOF, window) * c0.head(window);
+		if (del_time > 0.0) {
+			tmp_out_value = samples.block(0, head, DOF, window) * c1.head(window) / del_time;
+			second_value = samples.block(0, head, DOF, window) * c2.head(window) / (del_time * del_time);
+		} else {
+			tmp_out_value.setZero();
+			second_value.setZero();
 		}
 
-		for(i=1;i<(int)DOF;i++)
-		{
-		tmp_out_value[i] = diff_output[i];
-		}
 		outputSignalValue = tmp_out_value;
 		this->outputSignalOutputValue->setData(&tmp_out_value);
-
+		this->smoothedOutputValue->setData(&smoothed_value);
+		this->secondDerivativeOutputValue->setData(&second_value);
 	}
+
 private:
 	DISALLOW_COPY_AND_ASSIGN(differentiator);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 }
 ;
 
@@ -12,6 +12,8 @@
 #include <barrett/units.h>
 #include <barrett/systems.h>
 
+#include <wam_control_common/kinematics_bundle.h>
+
 using namespace barrett;
 
 template<size_t DOF>
@@ -26,7 +28,7 @@ public:
 
 
 public:
-	Input<math::Matrix<6,DOF>> Jacobian;
+	Input<KinematicsView<DOF> > kinematicsInput;	// KinematicsBundle output
 
 // IO  (outputs)
 public:
@@ -40,12 +42,11 @@ protected:
 public:
 cf_type computedF;
 ct_type computedT;
-math::Matrix<6,DOF> J;
 
 
 public:
 	explicit ForceEstimator( const std::string& sysName = "ForceEstimator"):
-		System(sysName), Jacobian(this), jtWAMInput(this), jtCompInput(this), cartesianForceOutput(this, &cartesianForceOutputValue),
+		System(sysName), kinematicsInput(this), jtWAMInput(this), jtCompInput(this), cartesianForceOutput(this, &cartesianForceOutputValue),
 		 cartesianTorqueOutput(this, &cartesianTorqueOutputValue){
 		 jt = Eigen::MatrixXd(DOF, 1);
 		 tmp_jaco = Eigen::MatrixXd(DOF, 6);}
@@ -62,8 +63,7 @@ protected:
 		jt_wam_sys = this->jtWAMInput.getValue();
 		jt_comp_sys = this->jtCompInput.getValue();
 
-		J = this->Jacobian.getValue();
-		tmp_jaco = J.transpose();
+		tmp_jaco = this->kinematicsInput.getValue().J.transpose();
 
 		jt = jt_wam_sys - jt_comp_sys;
 		Eigen::ColPivHouseholderQR<Eigen::MatrixXd> system(tmp_jaco);
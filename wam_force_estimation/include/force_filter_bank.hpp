@@ -0,0 +1,317 @@
+/*
+ * force_filter_bank.hpp
+ *
+ * Anti-aliased decimation of a force (or any fixed-size vector) signal in
+ * the real-time graph, for publishing at rates below the control rate.
+ *
+ * Each branch filters the input at the control rate and produces a sample
+ * every `decimation` ticks:
+ *
+ *   MOVING_AVERAGE  mean of the last `decimation` samples
+ *   CIC             `order` cascaded moving averages (sinc^order response);
+ *                   evaluated as the equivalent FIR of length
+ *                   order * (decimation - 1) + 1, so there are no
+ *                   integrators to grow without bound in floating point
+ *   BUTTERWORTH     low-pass of `order` 2 or 4 (biquads by the bilinear
+ *                   transform) with its cutoff at `cutoff` times the output
+ *                   Nyquist frequency, sampled every `decimation` ticks
+ *   MEDIAN          per-component median of the last `decimation` samples
+ *
+ * output(i) holds branch i's latest sample between decimation instants.
+ * Every sample is also pushed, with its tick number, into the branch's
+ * wait-free queue (RecordRing, columnar_log.h), which holds QUEUE_SECONDS
+ * of them; popSample() takes them off on one non-real-time thread, so a
+ * publisher sees each decimated sample exactly once and never reads a
+ * half-written value.
+ *
+ * Storage is allocated by the constructor; operate() doesn't allocate.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/StdVector>
+#include <barrett/systems/abstract/system.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/columnar_log.h>
+
+using namespace barrett;
+
+struct FilterBranch {
+	enum Kind { MOVING_AVERAGE, CIC, BUTTERWORTH, MEDIAN };
+
+	Kind kind;
+	size_t decimation;	// input ticks per output sample
+	size_t order;		// CIC stages, or Butterworth order (2 or 4)
+	double cutoff;		// Butterworth: fraction of the output Nyquist frequency
+
+	static FilterBranch movingAverage(size_t decimation) { return make(MOVING_AVERAGE, decimation, 1, 0.0); }
+	static FilterBranch cic(size_t decimation, size_t order = 3) { return make(CIC, decimation, order, 0.0); }
+	static FilterBranch butterworth(size_t decimation, double cutoff = 0.8, size_t order = 4) { return make(BUTTERWORTH, decimation, order, cutoff); }
+	static FilterBranch median(size_t decimation) { return make(MEDIAN, decimation, 1, 0.0); }
+
+private:
+	static FilterBranch make(Kind kind, size_t decimation, size_t order, double cutoff) {
+		FilterBranch b;
+		b.kind = kind;
+		b.decimation = decimation;
+		b.order = order;
+		b.cutoff = cutoff;
+		return b;
+	}
+};
+
+template<typename T>
+class ForceFilterBank : public systems::System
+{
+public:
+	static const int SIZE = T::SizeAtCompileTime;
+	static const double QUEUE_SECONDS;	// [s] of samples per branch held until popSample()
+
+	struct Sample {
+		uint64_t tick;	// input tick the sample was taken at
+		T value;
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+
+// IO  (inputs)
+public:
+	Input<T> input;
+
+protected:
+	struct Branch;
+
+public:
+	// T_s [s] is the execution manager's period; the Butterworth
+	// coefficients and the queue sizes depend on it.
+	ForceFilterBank(const std::vector<FilterBranch>& config, double T_s, const std::string& sysName = "ForceFilterBank"):
+		System(sysName), input(this), T_s(T_s), tick(0) {
+		if (T_s <= 0.0) {
+			throw std::invalid_argument("(ForceFilterBank::ForceFilterBank()): T_s must be positive.");
+		}
+		for (size_t i = 0; i < config.size(); ++i) {
+			branches.push_back(new Branch(this, config[i], T_s));
+		}
+	}
+
+	virtual ~ForceFilterBank() {
+		this->mandatoryCleanUp();
+		for (size_t i = 0; i < branches.size(); ++i) {
+			delete branches[i];
+		}
+	}
+
+	size_t size() const { return branches.size(); }
+	Output<T>& output(size_t i) { return branches[i]->output; }
+	double outputPeriod(size_t i) const { return T_s * branches[i]->config.decimation; }	// [s]
+
+	// Oldest queued sample of branch i, on the (single) consumer thread.
+	// False if there is none.
+	bool popSample(size_t i, Sample& s) {
+		const double* r;
+		if (branches[i]->queue.peek(&r) == 0) {
+			return false;
+		}
+		s.tick = static_cast<uint64_t>(r[0]);
+		for (int k = 0; k < SIZE; ++k) {
+			s.value[k] = r[1 + k];
+		}
+		branches[i]->queue.pop(1);
+		return true;
+	}
+
+	uint64_t droppedSamples(size_t i) const { return branches[i]->queue.droppedRecords(); }
+
+protected:
+	typedef Eigen::Matrix<double, SIZE, 1> vector_type;
+
+	// Direct form II transposed biquad, one state pair per component.
+	struct Biquad {
+		double b0, b1, b2, a1, a2;
+		vector_type z1, z2;
+
+		Biquad() : b0(1.0), b1(0.0), b2(0.0), a1(0.0), a2(0.0), z1(vector_type::Zero()), z2(vector_type::Zero()) {}
+
+		// Low-pass at normalized cutoff w = tan(pi fc / fs), quality q.
+		void lowPass(double w, double q) {
+			const double n = 1.0 / (1.0 + w / q + w * w);
+			b0 = w * w * n;
+			b1 = 2.0 * b0;
+			b2 = b0;
+			a1 = 2.0 * (w * w - 1.0) * n;
+			a2 = (1.0 - w / q + w * w) * n;
+		}
+
+		void step(const vector_type& x, vector_type& y) {
+			y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+		}
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+
+	struct Branch {
+		FilterBranch config;
+		Output<T> output;
+		typename Output<T>::Value* outputValue;
+		T value;
+		size_t count;	// input ticks since the last output sample
+
+		// FIR branches (moving average, CIC, median): the last `taps` inputs,
+		// stored twice so they are always one contiguous block
+		size_t taps, head;
+		std::vector<vector_type, Eigen::aligned_allocator<vector_type> > history;
+		std::vector<double> coefficients;
+		std::vector<double> scratch;	// median
+
+		// Butterworth
+		size_t sections;
+		Biquad biquads[2];
+		vector_type stage, filtered;
+
+		RecordRing queue;
+		double record[1 + SIZE];
+
+		Branch(System* parent, const FilterBranch& c, double T_s) :
+			config(c), output(parent, &outputValue), value(T(0.0)), count(0), taps(0), head(0), sections(0),
+			stage(vector_type::Zero()), filtered(vector_type::Zero()),
+			queue(1 + SIZE, static_cast<size_t>(QUEUE_SECONDS / (T_s * std::max<size_t>(c.decimation, 1))) + 1) {
+			if (c.decimation < 1) {
+				throw std::invalid_argument("(ForceFilterBank::ForceFilterBank()): decimation must be at least 1.");
+			}
+			switch (c.kind) {
+			case FilterBranch::MOVING_AVERAGE:
+				taps = c.decimation;
+				coefficients.assign(taps, 1.0 / taps);
+				break;
+			case FilterBranch::CIC: {
+				if (c.order < 1) {
+					throw std::invalid_argument("(ForceFilterBank::ForceFilterBank()): CIC order must be at least 1.");
+				}
+				// Impulse response of `order` boxcars of length decimation, normalized to unit DC gain
+				coefficients.assign(1, 1.0);
+				for (size_t k = 0; k < c.order; ++k) {
+					std::vector<double> h(coefficients.size() + c.decimation - 1, 0.0);
+					for (size_t i = 0; i < coefficients.size(); ++i) {
+						for (size_t j = 0; j < c.decimation; ++j) {
+							h[i + j] += coefficients[i] / c.decimation;
+						}
+					}
+					coefficients.swap(h);
+				}
+				taps = coefficients.size();
+				break;
+			}
+			case FilterBranch::MEDIAN:
+				taps = c.decimation;
+				scratch.resize(taps);
+				break;
+			case FilterBranch::BUTTERWORTH: {
+				if (c.order != 2 && c.order != 4) {
+					throw std::invalid_argument("(ForceFilterBank::ForceFilterBank()): Butterworth order must be 2 or 4.");
+				}
+				if ( !(c.cutoff > 0.0 && c.cutoff < c.decimation)) {
+					throw std::invalid_argument("(ForceFilterBank::ForceFilterBank()): Butterworth cutoff must be in (0, decimation).");
+				}
+				// fc = cutoff * fs / (2 decimation), prewarped
+				const double w = std::tan(M_PI * c.cutoff * 0.5 / c.decimation);
+				if (c.order == 2) {
+					sections = 1;
+					biquads[0].lowPass(w, M_SQRT1_2);
+				} else {
+					sections = 2;
+					biquads[0].lowPass(w, 1.0 / (2.0 * std::cos(M_PI / 8.0)));
+					biquads[1].lowPass(w, 1.0 / (2.0 * std::cos(3.0 * M_PI / 8.0)));
+				}
+				break;
+			}
+			}
+			history.assign(2 * taps, vector_type::Zero());
+		}
+
+		void step(const vector_type& x, uint64_t tick) {
+			if (sections > 0) {
+				// step() reads x after writing y, so each section gets its own output
+				stage = x;
+				for (size_t s = 0; s < sections; ++s) {
+					biquads[s].step(stage, filtered);
+					stage = filtered;
+				}
+			} else {
+				head = (head + 1) % taps;
+				history[head] = x;
+				history[head + taps] = x;
+			}
+
+			if (++count < config.decimation) {
+				return;
+			}
+			count = 0;
+
+			if (sections > 0) {
+				value = filtered;
+			} else if (config.kind == FilterBranch::MEDIAN) {
+				// history[head + 1 .. head + taps] is oldest to newest
+				for (int k = 0; k < SIZE; ++k) {
+					for (size_t i = 0; i < taps; ++i) {
+						scratch[i] = history[head + 1 + i][k];
+					}
+					std::nth_element(scratch.begin(), scratch.begin() + taps / 2, scratch.end());
+					double m = scratch[taps / 2];
+					if (taps % 2 == 0) {
+						m = 0.5 * (m + *std::max_element(scratch.begin(), scratch.begin() + taps / 2));
+					}
+					value[k] = m;
+				}
+			} else {
+				filtered.setZero();
+				for (size_t i = 0; i < taps; ++i) {
+					filtered += coefficients[i] * history[head + taps - i];	// newest first
+				}
+				value = filtered;
+			}
+
+			record[0] = static_cast<double>(tick);
+			for (int k = 0; k < SIZE; ++k) {
+				record[1 + k] = value[k];
+			}
+			queue.push(record);
+		}
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+	private:
+		DISALLOW_COPY_AND_ASSIGN(Branch);
+	};
+
+	double T_s;
+	uint64_t tick;
+	std::vector<Branch*> branches;
+	vector_type x;
+
+	virtual void operate() {
+		++tick;
+		x = this->input.getValue();
+		for (size_t i = 0; i < branches.size(); ++i) {
+			branches[i]->step(x, tick);
+			branches[i]->outputValue->setData(&branches[i]->value);
+		}
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(ForceFilterBank);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+template<typename T> const double ForceFilterBank<T>::QUEUE_SECONDS = 2.0;
@@ -11,6 +11,8 @@
 #include <barrett/systems.h>
 #include <ros/ros.h>
 
+#include <wam_control_common/kinematics_bundle.h>
+
 using namespace barrett;
 
 template <size_t DOF>
@@ -19,9 +21,8 @@ class SurfaceEstimator : public systems::System {
 
 public:
     // Inputs
-    Input<cp_type> cpInput;               // WAM cartesian position input
+    Input<KinematicsView<DOF> > kinematicsInput;  // tool position and rotation (KinematicsBundle)
     Input<cf_type> cfInput;               // WAM cartesian force normal input
-    Input<math::Matrix<3, 3>> rotInput;  // WAM world-to-tool rotation matrix
 
     // Outputs
     Output<cp_type> P1;  // Position direction
@@ -37,7 +38,7 @@ public:
     math::Matrix<3, 3> p;
 
     explicit SurfaceEstimator(const std::string& sysName = "SurfaceEstimator") :
-        System(sysName), cpInput(this), cfInput(this), rotInput(this), P1(this, &P1Value), P3(this, &P3Value), P2(this, &P2Value) {}
+        System(sysName), kinematicsInput(this), cfInput(this), P1(this, &P1Value), P3(this, &P3Value), P2(this, &P2Value) {}
 
     virtual ~SurfaceEstimator() { this->mandatoryCleanUp(); }
 
@@ -46,7 +47,6 @@ protected:
     cp_type p3;
     cp_type p1, p1n;
     cf_type p2, p2n;
-    math::Matrix<3, 3> R;
     Eigen::Matrix<double, 3, 2> cps;  // Cartesian position, current and previous
     bool contacted_first_time = true;
     double reach;
@@ -60,21 +60,21 @@ protected:
         if (p2.norm() > 15) {
             if (contacted_first_time) {
                 ROS_INFO_STREAM("Contact detected");
-                cps.col(0) = this->cpInput.getValue();
+                cps.col(0) = this->kinematicsInput.getValue().position;
                 contacted_first_time = false;
             }
 
-            cps.col(1) = this->cpInput.getValue();
+            cps.col(1) = this->kinematicsInput.getValue().position;
             p1 = cps.col(1) - cps.col(0);
             p1n = p1.normalized();
             
 
             if (p1.norm() > 0.05) {
-                cps.col(0) = this->cpInput.getValue();
-                R = this->rotInput.getValue();
-            
-                p2 = R * p2n;  // Transforming from world to tool
-                p1 = R * p1n;
+                cps.col(0) = this->kinematicsInput.getValue().position;
+                const typename KinematicsView<DOF>::rotation_map& R = this->kinematicsInput.getValue().R;
+
+                p2 = R.transpose() * p2n;  // Transforming from world to tool
+                p1 = R.transpose() * p1n;
 
                 p3 = p1n.cross(p2);
 
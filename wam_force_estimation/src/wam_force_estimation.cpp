@@ -9,7 +9,9 @@
 #include <differentiator.hpp>
 #include <force_estimator.hpp>
 #include <extended_ramp.hpp>
-#include <get_jacobian_system.hpp>
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/columnar_log.h>
+#include <force_filter_bank.hpp>
 #include <unistd.h>
 #include <iostream>
 #include <string>
@@ -36,19 +38,14 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	//Initialising ROS node and publishers
 	ros::init(argc, argv, "force_estimator_node");
     ros::NodeHandle nh;
-	ros::Publisher force_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_topic", 1);
-	ros::Publisher force_avg_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_avg_topic", 1);
+	// Samples are published in bursts of however many queued up since the last pass
+	ros::Publisher force_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_topic", 10);
+	ros::Publisher force_avg_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_avg_topic", 10);
 
 	//Setting up real-time command timeouts and initial values
 	ros::Duration rt_msg_timeout;
     rt_msg_timeout.fromSec(0.2); //rt_status will be determined false if rt message is not received in specified time
 
-	char tmpFile[] = "/tmp/btXXXXXX";
-	if (mkstemp(tmpFile) == -1) {
-		printf("ERROR: Couldn't create temporary file!\n");
-		return 1;
-	}
-
 	//Moving to start pose
 	jp_type start_pose;
 	start_pose<< 0.0,1.0,0.0, 1.5;
@@ -58,7 +55,7 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	wam.gravityCompensate();
 	usleep(1500);
 
-	// Set the differentiator mode indicating how many data points it uses
+	// Savitzky-Golay window length (samples) of the differentiator
 	int mode = 5;  
 	ja_type zero_acc; 
 
@@ -78,9 +75,9 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	systems::InverseDynamics<DOF> id(pm.getConfig().lookup(pm.getWamDefaultConfigPath())["dynamics"]);
 	systems::Summer<jt_type> idSum;
 	ForceEstimator<DOF> forceEstimator;
-	getJacobian<DOF> getWAMJacobian;
+	KinematicsBundle<DOF> kinematics;
 	systems::Constant<ja_type> zero(zero_acc);
-	differentiator<DOF, jv_type, ja_type> diff(mode);
+	differentiator<DOF, jv_type, ja_type> diff(mode, 2, (mode - 1) / 2);	// centered, as the old fixed five-point formula
 	ExtendedRamp time(pm.getExecutionManager(), 1.0);
 	systems::TupleGrouper<double, cf_type, ct_type> tg;
 	systems::Gain<jv_type, double, ja_type> changeUnits(1.0);
@@ -93,10 +90,13 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	//FrictionCompensator<DOF> friction_comp();
 
 	const size_t PERIOD_MULTIPLIER = 1;
-	systems::PeriodicDataLogger<tuple_type> logger(
-			pm.getExecutionManager(),
-			new log::RealTimeWriter<tuple_type>(tmpFile, PERIOD_MULTIPLIER * pm.getExecutionManager()->getPeriod()),
-			PERIOD_MULTIPLIER);
+	const char* columns[] = {"t", "cf", "ct"};
+	ColumnarLogger<tuple_type> logger(pm.getExecutionManager(), argv[1],
+			std::vector<std::string>(columns, columns + 3), PERIOD_MULTIPLIER);
+	if ( !logger.isLogging()) {
+		printf("ERROR: Couldn't create %s\n", argv[1]);
+		return 1;
+	}
 
 	//Connecting system potrs
 	systems::connect(time.output, diff.time);
@@ -117,11 +117,11 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 
 	systems::connect(wam.jvOutput, id.jvInput);
 	systems::connect(wam.kinematicsBase.kinOutput, id.kinInput);
-	systems::connect(wam.kinematicsBase.kinOutput, getWAMJacobian.kinInput);
+	systems::connect(wam.kinematicsBase.kinOutput, kinematics.kinInput);
 	systems::connect(id.output, idSum.getInput(0));
 	systems::connect(driveInertias.output, idSum.getInput(1));
 	systems::connect(idSum.output, forceEstimator.jtCompInput);
-	systems::connect(getWAMJacobian.output, forceEstimator.Jacobian);
+	systems::connect(kinematics.output, forceEstimator.kinematicsInput);
 
 	systems::connect(wam.jtSum.output, forceEstimator.jtWAMInput);
 
@@ -130,8 +130,20 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	
 	systems::connect(tg.output, logger.input);
 
-	// Reset and start the time counter
+	// force_topic gets every estimate; force_avg_topic an anti-aliased
+	// FORCE_AVG_DECIMATION-tick decimation of it
+	const size_t FORCE_AVG_DECIMATION = 20;
+	std::vector<FilterBranch> forceBranches;
+	forceBranches.push_back(FilterBranch::movingAverage(1));
+	forceBranches.push_back(FilterBranch::butterworth(FORCE_AVG_DECIMATION));
+	const double T_s = pm.getExecutionManager()->getPeriod();
+	ForceFilterBank<cf_type> forceFilters(forceBranches, T_s);
+	systems::connect(forceEstimator.cartesianForceOutput, forceFilters.input);
+
+	// Reset and start the time counter; the filter bank starts with it, so a
+	// sample's tick * T_s is its time
 	{BARRETT_SCOPED_LOCK(pm.getExecutionManager()->getMutex());
+	pm.getExecutionManager()->startManaging(forceFilters);
 	time.reset();
 	time.start();}
 
@@ -151,8 +163,7 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 
 	ros::Rate pub_rate(500);
 
-	int i = 0;
-	cf_type cf_avg;	
+	ForceFilterBank<cf_type>::Sample sample;
 	wam_force_estimation::RTCartForce force_msg;
 	wam_force_estimation::RTCartForce force_avg_msg;
 	btsleep(1);
@@ -168,31 +179,23 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
             }
         }
 		
-		//std::cout<< cf_avg << std::endl;
-
-		i++;
-		cf_avg = cf_avg + forceEstimator.computedF;
-		//std::cout << "Estimated F:" <<forceEstimator.computedF << std::endl;
-		force_msg.force[0] = forceEstimator.computedF[0];
-		force_msg.force[1] = forceEstimator.computedF[1];
-		force_msg.force[2] = forceEstimator.computedF[2];
-		force_msg.time = time.getYValue();
-		force_msg.force_norm = forceEstimator.computedF.norm()/9.81;
-		//force_msg.force_dir = forceEstimator.computedF.normalize();
-		force_publisher.publish(force_msg);
-		
-		if(i == 20){
-			cf_avg = cf_avg/i;
-			force_avg_msg.force[0] = cf_avg[0];
-			force_avg_msg.force[1] = cf_avg[1];
-			force_avg_msg.force[2] = cf_avg[2];
-			force_avg_msg.time= time.getYValue();
-			force_avg_msg.force_norm = cf_avg.norm()/9.81;
-			//force_avg_msg.force_dir = cf_avg.normalize();
+		// Every sample since the last pass, each exactly once
+		while (forceFilters.popSample(0, sample)) {
+			force_msg.force[0] = sample.value[0];
+			force_msg.force[1] = sample.value[1];
+			force_msg.force[2] = sample.value[2];
+			force_msg.time = sample.tick * T_s;
+			force_msg.force_norm = sample.value.norm()/9.81;
+			force_publisher.publish(force_msg);
+		}
+		while (forceFilters.popSample(1, sample)) {
+			force_avg_msg.force[0] = sample.value[0];
+			force_avg_msg.force[1] = sample.value[1];
+			force_avg_msg.force[2] = sample.value[2];
+			force_avg_msg.time = sample.tick * T_s;
+			force_avg_msg.force_norm = sample.value.norm()/9.81;
 			force_avg_publisher.publish(force_avg_msg);
-			i = 0;
-			cf_avg<< 0.0, 0.0, 0.0;
-			}
+		}
 		
 		pub_rate.sleep();
 	}
@@ -209,10 +212,14 @@ int wam_main(int argc, char** argv, ProductManager& pm,	systems::Wam<DOF>& wam)
 	logger.closeLog();
 	printf("Logging stopped.\n");
 
-	log::Reader<tuple_type> lr(tmpFile);
-	lr.exportCSV(argv[1]);
+	if (logger.droppedRecords() > 0) {
+		printf("WARNING: %llu records were dropped.\n", static_cast<unsigned long long>(logger.droppedRecords()));
+	}
+	if (forceFilters.droppedSamples(0) + forceFilters.droppedSamples(1) > 0) {
+		printf("WARNING: %llu force samples weren't published.\n",
+				static_cast<unsigned long long>(forceFilters.droppedSamples(0) + forceFilters.droppedSamples(1)));
+	}
 	printf("Output written to %s.\n", argv[1]);
-	std::remove(tmpFile);
 
 	// Wait for user input before moving home
 	barrett::detail::waitForEnter();
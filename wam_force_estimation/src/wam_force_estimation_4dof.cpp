@@ -1,22 +1,24 @@
 /*
  * wam_force_estimator.cpp
  *
- * In this script, we use dynamic matrices derived for 4-DOF WAM by Aritra Mitra et al.
+ * M and C come from RNEADynamics, built from the link parameters in the WAM config.
+ * The closed-form 4-DOF matrices derived by Aritra Mitra et al. are kept as M_4D.h/C_4D.h in wam_control_common.
  * GitHub Repo: https://github.com/raj111samant/Model-based-control-of-4-DOF-Barrett-Wam/tree/master/WAM-C%2B%2B-Codes
  * 
  * Created on: August, 2023
  * Author: Faezeh
  */
 
-#include <Dynamics.hpp>
-#include <differentiator.hpp>
-#include <force_estimator_4dof.hpp>
+#include <wam_control_common/rnea_dynamics.h>
+#include <wam_control_common/momentum_observer.h>
 #include <wam_surface_Estimator.hpp>
 #include <extended_ramp.hpp>
-#include <get_tool_position_system.hpp>
-#include <get_jacobian_system.hpp>
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/cubic_bezier.h>
+#include <wam_control_common/trajectory_streamer.h>
+#include <wam_control_common/columnar_log.h>
+#include <force_filter_bank.hpp>
 #include <robust_cartesian.h>
-#include <extended_Tool_Orientation.hpp>
 
 #include <libconfig.h++>
 #include <unistd.h>
@@ -76,71 +78,26 @@ std::vector<units::CartesianPosition::type> generateCubicSplineWaypointsAndMove(
     return waypoints;
 }
 */
-// Function to generate waypoints along a Cubic Bezier curve and move to them
+static const double APPROACH_SPEED = 0.05; // [m/s] peak tool speed along the approach curves
+
+// Move the tool along a Cubic Bezier curve from where it is to finalPos. The
+// streamer samples the curve every tick and the tool position controller
+// tracks it; the arm keeps holding finalPos afterwards.
 template <size_t DOF>
-std::vector<units::CartesianPosition::type> generateCubicSplineWaypointsAndMove(
+void moveAlongCubicBezier(
     Wam<DOF>& wam,
-    const units::CartesianPosition::type& initialPos,
+    TrajectoryStreamer<DOF>& streamer,
     const units::CartesianPosition::type& finalPos,
     double offset
 ) {
-    BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
-    std::vector<units::CartesianPosition::type> waypoints;
-
-    Eigen::Vector3d deltaPos = finalPos - initialPos;
-    double totalDistance = deltaPos.norm();
-
-    // Calculate intermediate positions by offsetting x, y, and z
-    Eigen::Vector3d yeeb = initialPos + deltaPos * offset;
-    Eigen::Vector3d goalb = finalPos - deltaPos * offset;
-
-    // Bezier interpolation
-    int numPop = 1000;
-    std::vector<Eigen::Vector3d> plPop;
-    for (int i = 0; i < numPop; ++i) {
-        double t = static_cast<double>(i) / (numPop - 1);
-        Eigen::Vector3d pl = (1 - t) * (1 - t) * (1 - t) * initialPos +
-                             3 * (1 - t) * (1 - t) * t * yeeb +
-                             3 * (1 - t) * t * t * goalb +
-                             t * t * t * finalPos;
-        plPop.push_back(pl);
+    const units::CartesianPosition::type initialPos = wam.getToolPosition();
+    streamer.hold(initialPos, wam.getToolOrientation());
+    wam.trackReferenceSignal(streamer.positionOutput);
+    if (!streamer.enqueue(CubicBezier::between(initialPos, finalPos, offset), wam.getToolOrientation(), APPROACH_SPEED)) {
+        printf("WARNING: couldn't start the move along the curve\n");
+        return;
     }
-
-    // Calculate the subset of points to sample
-    int steps = 20;
-    double squish = 2.0;
-    std::vector<double> midArr;
-    for (double t = -squish; t <= squish; t += squish / (steps - 1)) {
-        midArr.push_back(static_cast<double>(numPop) / (1 + std::exp(-t)));
-    }
-
-    double minMidArr = *std::min_element(midArr.begin(), midArr.end());
-    double maxMidArr = *std::max_element(midArr.begin(), midArr.end());
-    double m = (numPop - 1) / (maxMidArr - minMidArr);
-
-    std::vector<int> iArr;
-    for (double t : midArr) {
-        int index = static_cast<int>(m * (t - minMidArr));
-        iArr.push_back(index);
-    }
-
-    iArr[0] = 0;
-    iArr.back() = numPop - 1;
-
-    // List of points as a sample of bezier
-    std::vector<units::CartesianPosition::type> pl;
-    for (int index : iArr) {
-        pl.push_back(cp_type(plPop[index]));
-    }
-
-    for (const auto& waypoint : pl) {
-        waypoints.push_back(waypoint);
-
-        // Move to the waypoint
-        wam.moveTo(waypoint, true, 0.05);
-    }
-
-    return waypoints;
+    streamer.waitForCompletion();
 }
 
 template <size_t DOF>
@@ -151,20 +108,14 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
     // Initialize ROS node and publishers
     ros::init(argc, argv, "force_estimator_node");
     ros::NodeHandle nh;
-    ros::Publisher force_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_topic", 1);
-    ros::Publisher force_avg_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_avg_topic", 1);
+    // Samples are published in bursts of however many queued up since the last pass
+    ros::Publisher force_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_topic", 10);
+    ros::Publisher force_avg_publisher = nh.advertise<wam_force_estimation::RTCartForce>("force_avg_topic", 10);
 
     // Setting up real-time command timeouts and initial values
     ros::Duration rt_msg_timeout;
     rt_msg_timeout.fromSec(0.2); // rt_status will be determined false if rt message is not received in the specified time
 
-    // Temporary file for logger
-    char tmpFile[] = "/tmp/btXXXXXX";
-    if (mkstemp(tmpFile) == -1) {
-        printf("ERROR: Couldn't create a temporary file!\n");
-        return 1;
-    }
-
     // Moving to the start pose
     jp_type POS_READY;
     POS_READY << 0.002227924477643431, -0.1490540623980915, -0.04214558734519736, 1.6803055108189549;
@@ -174,10 +125,6 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
     wam.gravityCompensate();
     usleep(1500);
 
-    // Set the differentiator mode indicating how many data points it uses
-    int mode = 5;
-    ja_type zero_acc;
-
     // Load configuration settings
     v_type drive_inertias;
     drive_inertias[0] = 11631e-8;
@@ -188,78 +135,58 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
 
     // Instantiate systems
     GravityCompensator<DOF> gravityTerm(setting["gravity_compensation"]);
-    getJacobian<DOF> getWAMJacobian;
-    ForceEstimator<DOF> forceEstimator(true);
-    Dynamics<DOF> wam4dofDynamics;
-    differentiator<DOF, jv_type, ja_type> diff(mode);
+    KinematicsBundle<DOF> kinematics;
+    RNEADynamics<DOF> wamDynamics(setting);
     ExtendedRamp time(pm.getExecutionManager(), 1.0);
-    Constant<ja_type> zero(zero_acc);
     const LowLevelWam<DOF>& llw = wam.getLowLevelWam();
-    Gain<ja_type, sqm_type, jt_type> driveInertias(llw.getJointToMotorPositionTransform().transpose() * drive_inertias.asDiagonal() * llw.getJointToMotorPositionTransform());
+    sqm_type driveInertias(llw.getJointToMotorPositionTransform().transpose() * drive_inertias.asDiagonal() * llw.getJointToMotorPositionTransform());
+
+    // Momentum observer bandwidth [1/s]; the residual reaches ~50% of a step
+    // in external torque two ticks after contact at 500 Hz
+    v_type observer_gains(150.0);
+    MomentumObserver<DOF> forceEstimator(observer_gains, driveInertias);
     TupleGrouper<double, cp_type, cp_type, cf_type> tg;
     PrintToStream<cf_type> print(pm.getExecutionManager());
 
     // Add surface estimator parts
     SurfaceEstimator<DOF> surface_estimator;
-    ExtendedToolOrientation<DOF> rot;
-    getToolPosition<DOF> cp;
-
-    // First-order filter instead of differentiator
-    double omega_p = 180.0;
-    FirstOrderFilter<jv_type> hp;
-    hp.setHighPass(jv_type(omega_p), jv_type(omega_p));
-    pm.getExecutionManager()->startManaging(hp);
-    Gain<jv_type, double, ja_type> changeUnits(1.0);
 
     // Real-time data logger
     const size_t PERIOD_MULTIPLIER = 1;
-    PeriodicDataLogger<tuple_type> logger(
-        pm.getExecutionManager(),
-        new log::RealTimeWriter<tuple_type>(tmpFile, PERIOD_MULTIPLIER * pm.getExecutionManager()->getPeriod()),
-        PERIOD_MULTIPLIER);
+    const char* columns[] = {"t", "P1", "P2", "P3"};
+    ColumnarLogger<tuple_type> logger(pm.getExecutionManager(), argv[1],
+        std::vector<std::string>(columns, columns + 4), PERIOD_MULTIPLIER);
+    if (!logger.isLogging()) {
+        printf("ERROR: Couldn't create %s\n", argv[1]);
+        return 1;
+    }
 
     // Connecting system ports
     connect(time.output, tg.template getInput<0>());
 
-    // Using First-order filter instead of differentiator
-    // connect(wam.jvOutput, hp.input);
-    // connect(hp.output, changeUnits.input);
-    // connect(changeUnits.output, forceEstimator.jaInput);
-    // connect(changeUnits.output, driveInertias.input);
+    // Momentum observer: joint velocities only, no differentiation
+    connect(wam.jvOutput, forceEstimator.jvInput);
 
-    // Using differentiator
-    connect(time.output, diff.time);
-    connect(wam.jvOutput, diff.inputSignal);
-    connect(diff.outputSignal, forceEstimator.jaInput);
-    connect(diff.outputSignal, driveInertias.input);
-
-    // Zero Acc
-    // connect(zero.output, forceEstimator.jaInput);
-    
-    connect(wam.kinematicsBase.kinOutput, getWAMJacobian.kinInput);
-    connect(getWAMJacobian.output, forceEstimator.Jacobian);
+    connect(wam.kinematicsBase.kinOutput, kinematics.kinInput);
+    connect(kinematics.output, forceEstimator.kinematicsInput);
 
     connect(wam.kinematicsBase.kinOutput, gravityTerm.kinInput);
     connect(gravityTerm.output, forceEstimator.g);
 
-    // connect(zero.output, driveInertias.input);
-    connect(driveInertias.output, forceEstimator.rotorInertiaEffect);
-
     connect(wam.jtSum.output, forceEstimator.jtInput);
 
-    connect(wam.jpOutput, wam4dofDynamics.jpInputDynamics);
-    connect(wam.jvOutput, wam4dofDynamics.jvInputDynamics);
-    connect(wam4dofDynamics.MassMAtrixOutput, forceEstimator.M);
-    connect(wam4dofDynamics.CVectorOutput, forceEstimator.C);
+    connect(wam.jpOutput, wamDynamics.jpInputDynamics);
+    connect(wam.jvOutput, wamDynamics.jvInputDynamics);
+    connect(wamDynamics.MassMAtrixOutput, forceEstimator.M);
+    connect(wamDynamics.CVectorOutput, forceEstimator.C);
+
+    // The observer integrates, so it must run every tick
+    pm.getExecutionManager()->startManaging(forceEstimator);
 
     // systems::connect(forceEstimator.cartesianForceOutput, tg.template getInput<1>());
 
     // Connecting input and outputs for surface estimator
-    connect(wam.kinematicsBase.kinOutput, rot.kinInput);
-    connect(rot.output, surface_estimator.rotInput);
-
-    connect(wam.kinematicsBase.kinOutput, cp.kinInput);
-    connect(cp.output, surface_estimator.cpInput);
+    connect(kinematics.output, surface_estimator.kinematicsInput);
 
     connect(forceEstimator.cartesianForceOutput, surface_estimator.cfInput);
     // connect(forceEstimator.cartesianForceOutput, print.input);
@@ -291,11 +218,12 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
     wam.tpController.setKd(cp_kd);
 
     // Making a spline from the current cp to the start cp
+    TrajectoryStreamer<DOF> approach;
     cp_type start_pose;
     start_pose[0] = 0.554666;
     start_pose[1] = 0.019945;
     start_pose[2] = -0.18;
-    std::vector<cp_type> waypoints = generateCubicSplineWaypointsAndMove(wam, wam.getToolPosition(), start_pose, 0.05);
+    moveAlongCubicBezier(wam, approach, start_pose, 0.05);
 
     printf("Logging started.\n");
 
@@ -315,7 +243,7 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
 
     cp_type next_pose;
     next_pose << 0.6560848991017444, 0.019945, -0.18;
-    std::vector<cp_type> waypoints2 = generateCubicSplineWaypointsAndMove(wam, wam.getToolPosition(), next_pose, 0.05);
+    moveAlongCubicBezier(wam, approach, next_pose, 0.05);
     usleep(10);
 
 	cp_type test_pose, p_test;
@@ -325,7 +253,7 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
 		0, 0, 0;
 	test_pose << 0.7060848991017444, 0.119945, 0.4;
 	p_test = wam.getToolOrientation()*surface_estimator.p.inverse()*s*surface_estimator.p*wam.getToolOrientation().inverse()*test_pose;
-	//std::vector<cp_type> waypoints3 = generateCubicSplineWaypointsAndMove(wam, wam.getToolPosition(), p_test, 0.05);
+	//moveAlongCubicBezier(wam, approach, p_test, 0.05);
     std::cout<<surface_estimator.p*wam.getToolOrientation().inverse()<<std::endl;
     
     
@@ -340,8 +268,26 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
 
 
 
-    int i = 0;
-    cf_type cf_avg;
+    // force_topic gets every estimate; force_avg_topic an anti-aliased
+    // FORCE_AVG_DECIMATION-tick decimation of it
+    const size_t FORCE_AVG_DECIMATION = 20;
+    std::vector<FilterBranch> forceBranches;
+    forceBranches.push_back(FilterBranch::movingAverage(1));
+    forceBranches.push_back(FilterBranch::butterworth(FORCE_AVG_DECIMATION));
+    const double T_s = pm.getExecutionManager()->getPeriod();
+    ForceFilterBank<cf_type> forceFilters(forceBranches, T_s);
+    connect(forceEstimator.cartesianForceOutput, forceFilters.input);
+
+    // Started only now so the queues don't fill during the moves above; a
+    // sample's time is t0 + tick * T_s
+    double t0;
+    {
+        BARRETT_SCOPED_LOCK(pm.getExecutionManager()->getMutex());
+        pm.getExecutionManager()->startManaging(forceFilters);
+        t0 = time.getYValue();
+    }
+
+    ForceFilterBank<cf_type>::Sample sample;
     wam_force_estimation::RTCartForce force_msg;
     wam_force_estimation::RTCartForce force_avg_msg;
     btsleep(1);
@@ -357,27 +303,22 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
             }
         }
 
-        i++;
-        cf_avg = cf_avg + forceEstimator.computedF;
-        force_msg.force[0] = forceEstimator.computedF[0];
-        force_msg.force[1] = forceEstimator.computedF[1];
-        force_msg.force[2] = forceEstimator.computedF[2];
-        force_msg.force_norm = forceEstimator.computedF.norm() / 9.81;
-        // force_msg.force_dir = forceEstimator.computedF.normalize();
-        force_msg.time = time.getYValue();
-        force_publisher.publish(force_msg);
-
-        if (i == 20) {
-            cf_avg = cf_avg / i;
-            force_avg_msg.force[0] = cf_avg[0];
-            force_avg_msg.force[1] = cf_avg[1];
-            force_avg_msg.force[2] = cf_avg[2];
-            force_avg_msg.time = time.getYValue();
-            force_avg_msg.force_norm = cf_avg.norm() / 9.81;
-            // force_avg_msg.force_dir = cf_avg.normalize();
+        // Every sample since the last pass, each exactly once
+        while (forceFilters.popSample(0, sample)) {
+            force_msg.force[0] = sample.value[0];
+            force_msg.force[1] = sample.value[1];
+            force_msg.force[2] = sample.value[2];
+            force_msg.force_norm = sample.value.norm() / 9.81;
+            force_msg.time = t0 + sample.tick * T_s;
+            force_publisher.publish(force_msg);
+        }
+        while (forceFilters.popSample(1, sample)) {
+            force_avg_msg.force[0] = sample.value[0];
+            force_avg_msg.force[1] = sample.value[1];
+            force_avg_msg.force[2] = sample.value[2];
+            force_avg_msg.force_norm = sample.value.norm() / 9.81;
+            force_avg_msg.time = t0 + sample.tick * T_s;
             force_avg_publisher.publish(force_avg_msg);
-            i = 0;
-            cf_avg << 0.0, 0.0, 0.0;
         }
 
         pub_rate.sleep();
@@ -395,10 +336,14 @@ int wam_main(int argc, char** argv, ProductManager& pm, Wam<DOF>& wam) {
     logger.closeLog();
     printf("Logging stopped.\n");
 
-    log::Reader<tuple_type> lr(tmpFile);
-    lr.exportCSV(argv[1]);
+    if (logger.droppedRecords() > 0) {
+        printf("WARNING: %llu records were dropped.\n", static_cast<unsigned long long>(logger.droppedRecords()));
+    }
+    if (forceFilters.droppedSamples(0) + forceFilters.droppedSamples(1) > 0) {
+        printf("WARNING: %llu force samples weren't published.\n",
+                static_cast<unsigned long long>(forceFilters.droppedSamples(0) + forceFilters.droppedSamples(1)));
+    }
     printf("Output written to %s.\n", argv[1]);
-    std::remove(tmpFile);
 
     return 0;
 }
\ No newline at end of file
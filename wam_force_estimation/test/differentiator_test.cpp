@@ -0,0 +1,117 @@
+/*
+ * differentiator_test.cpp
+ *
+ * The Savitzky-Golay differentiator on polynomials it has to reproduce
+ * exactly: a quadratic through a window fitted with order 2 comes back with
+ * its value, first and second derivative at the lagged sample, for both the
+ * causal and the centered filter.
+ */
+
+#include <differentiator.hpp>
+#include <cmath>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+
+using namespace barrett;
+
+namespace {
+
+typedef units::JointPositions<4>::type jp_type;
+typedef units::JointVelocities<4>::type jv_type;
+
+const double T_S = 0.002;	// [s] as on the WAM
+const double TOLERANCE = 1e-6;
+
+// x_j(t) = a_j + b_j t + c_j t^2
+const double A[4] = { 0.5, -1.0, 0.0, 2.0 };
+const double B[4] = { 1.0, 0.3, -2.0, 0.0 };
+const double C[4] = { -0.5, 4.0, 1.0, 10.0 };
+
+jp_type position(double t) {
+	jp_type x;
+	for (size_t j = 0; j < 4; ++j) {
+		x[j] = A[j] + B[j] * t + C[j] * t * t;
+	}
+	return x;
+}
+
+// Latches its input every tick so the outputs can be read back
+template<typename T>
+class Sink : public systems::System {
+public:
+	Input<T> input;
+	T value;
+
+	Sink() : System("Sink"), input(this) {}
+	virtual ~Sink() { this->mandatoryCleanUp(); }
+
+protected:
+	virtual void operate() { value = input.getValue(); }
+};
+
+// Runs 3 * window samples of position(t) through differentiator(window, 2,
+// lag) and checks every output once the window holds no startup samples.
+void checkQuadratic(int window, int lag) {
+	systems::ManualExecutionManager mem(T_S);
+	differentiator<4, jp_type, jv_type> diff(window, 2, lag);
+	systems::ExposedOutput<double> time;
+	systems::ExposedOutput<jp_type> source;
+	systems::connect(time.output, diff.time);
+	systems::connect(source.output, diff.inputSignal);
+	Sink<jp_type> smoothed;
+	Sink<jv_type> first, second;
+	systems::connect(diff.smoothedOutput, smoothed.input);
+	systems::connect(diff.outputSignal, first.input);
+	systems::connect(diff.secondDerivativeOutput, second.input);
+	mem.startManaging(smoothed);
+	mem.startManaging(first);
+	mem.startManaging(second);
+
+	for (int i = 0; i < 3 * window; ++i) {
+		const double t = i * T_S;
+		time.setValue(t);
+		source.setValue(position(t));
+		mem.runExecutionCycle();
+		if (i < window) {
+			continue;	// still holding the first sample
+		}
+
+		const double tl = t - lag * T_S;
+		const jp_type x = position(tl);
+		for (size_t j = 0; j < 4; ++j) {
+			EXPECT_NEAR(x[j], smoothed.value[j], TOLERANCE) << "window " << window << ", lag " << lag;
+			EXPECT_NEAR(B[j] + 2.0 * C[j] * tl, first.value[j], TOLERANCE) << "window " << window << ", lag " << lag;
+			EXPECT_NEAR(2.0 * C[j], second.value[j], 1e-3) << "window " << window << ", lag " << lag;
+		}
+	}
+}
+
+TEST(Differentiator, ReproducesQuadraticCausal) {
+	checkQuadratic(5, 0);
+	checkQuadratic(11, 0);
+}
+
+TEST(Differentiator, ReproducesQuadraticCentered) {
+	checkQuadratic(5, 2);
+	checkQuadratic(11, 5);
+}
+
+TEST(Differentiator, RejectsBadConfigurations) {
+	typedef differentiator<4, jp_type, jv_type, 8> small_type;
+	EXPECT_THROW(small_type(1), std::invalid_argument);
+	EXPECT_THROW(small_type(9), std::invalid_argument);
+	EXPECT_THROW(small_type(5, 0), std::invalid_argument);
+	EXPECT_THROW(small_type(5, 5), std::invalid_argument);
+	EXPECT_THROW(small_type(5, 2, -1), std::invalid_argument);
+	EXPECT_THROW(small_type(5, 2, 5), std::invalid_argument);
+	EXPECT_NO_THROW(small_type(8, 7, 7));
+}
+
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+/*
+ * force_filter_bank_test.cpp
+ *
+ * Gains of ForceFilterBank's branches, measured by driving the bank with a
+ * sinusoid under a ManualExecutionManager and fitting a sinusoid of the
+ * same frequency to the decimated output.
+ */
+
+#include <force_filter_bank.hpp>
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <eigen3/Eigen/Dense>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+
+using namespace barrett;
+
+namespace {
+
+typedef units::CartesianForce::type cf_type;
+
+const double T_S = 0.002;		// [s] as on the WAM
+const double SETTLE = 1.0;		// [s] of output ignored before fitting
+const double DURATION = 5.0;	// [s]
+
+// |H(f)| of branch 0 of a bank built from `branch`, in x (y and z carry DC)
+double gain(const FilterBranch& branch, double f) {
+	systems::ManualExecutionManager mem(T_S);
+	ForceFilterBank<cf_type> bank(std::vector<FilterBranch>(1, branch), T_S);
+	systems::ExposedOutput<cf_type> source;
+	systems::connect(source.output, bank.input);
+	mem.startManaging(bank);
+
+	const size_t ticks = static_cast<size_t>(DURATION / T_S);
+	std::vector<double> t, x;
+	ForceFilterBank<cf_type>::Sample s;
+	for (size_t i = 1; i <= ticks; ++i) {
+		source.setValue(cf_type(std::cos(2.0 * M_PI * f * i * T_S), 1.0, -1.0));
+		mem.runExecutionCycle();
+		while (bank.popSample(0, s)) {
+			if (s.tick * T_S > SETTLE) {
+				t.push_back(s.tick * T_S);
+				x.push_back(s.value[0]);
+			}
+		}
+	}
+
+	// Least squares a cos + b sin (+ c) through the output samples
+	Eigen::MatrixXd A(t.size(), f > 0.0 ? 3 : 1);
+	Eigen::VectorXd y(t.size());
+	for (size_t k = 0; k < t.size(); ++k) {
+		A(k, 0) = 1.0;
+		if (f > 0.0) {
+			A(k, 1) = std::cos(2.0 * M_PI * f * t[k]);
+			A(k, 2) = std::sin(2.0 * M_PI * f * t[k]);
+		}
+		y[k] = x[k];
+	}
+	const Eigen::VectorXd c = A.colPivHouseholderQr().solve(y);
+	return f > 0.0 ? std::sqrt(c[1] * c[1] + c[2] * c[2]) : c[0];
+}
+
+// Butterworth cutoff [Hz] for a decimation and cutoff fraction of the output Nyquist frequency
+double cutoff(size_t decimation, double fraction) {
+	return fraction * 0.5 / (decimation * T_S);
+}
+
+TEST(ForceFilterBank, ButterworthGainAtDcAndCutoff) {
+	for (size_t order = 2; order <= 4; order += 2) {
+		const FilterBranch b = FilterBranch::butterworth(20, 0.8, order);
+		const double fc = cutoff(20, 0.8);	// 10 Hz
+		EXPECT_NEAR(1.0, gain(b, 0.0), 1e-6) << "order " << order;
+		EXPECT_NEAR(M_SQRT1_2, gain(b, fc), 0.01) << "order " << order;
+		EXPECT_NEAR(1.0 / std::sqrt(1.0 + std::pow(0.5, 2.0 * order)), gain(b, fc / 2.0), 0.01) << "order " << order;
+	}
+}
+
+TEST(ForceFilterBank, ButterworthAttenuatesAboveCutoff) {
+	// 4th order, two octaves above a 10 Hz cutoff: about -48 dB (the 40 Hz tone
+	// aliases to 10 Hz in the 25 Hz output, the fit still sees its amplitude)
+	EXPECT_LT(gain(FilterBranch::butterworth(20, 0.8, 4), 40.0), 0.01);
+}
+
+TEST(ForceFilterBank, FirBranchesHaveUnitDcGain) {
+	EXPECT_NEAR(1.0, gain(FilterBranch::movingAverage(20), 0.0), 1e-12);
+	EXPECT_NEAR(1.0, gain(FilterBranch::cic(20, 3), 0.0), 1e-12);
+	EXPECT_NEAR(1.0, gain(FilterBranch::median(5), 0.0), 1e-12);
+}
+
+TEST(ForceFilterBank, EverySampleIsQueuedOnce) {
+	systems::ManualExecutionManager mem(T_S);
+	std::vector<FilterBranch> config;
+	config.push_back(FilterBranch::movingAverage(1));
+	config.push_back(FilterBranch::butterworth(20));
+	ForceFilterBank<cf_type> bank(config, T_S);
+	systems::ExposedOutput<cf_type> source(cf_type(0.0));
+	systems::connect(source.output, bank.input);
+	mem.startManaging(bank);
+
+	for (size_t i = 0; i < 200; ++i) {
+		mem.runExecutionCycle();
+	}
+	ForceFilterBank<cf_type>::Sample s;
+	uint64_t last = 0;
+	size_t n = 0;
+	while (bank.popSample(1, s)) {
+		EXPECT_EQ(last + 20, s.tick);
+		last = s.tick;
+		++n;
+	}
+	EXPECT_EQ(10u, n);
+	n = 0;
+	while (bank.popSample(0, s)) {
+		++n;
+	}
+	EXPECT_EQ(200u, n);
+	EXPECT_EQ(0u, bank.droppedSamples(0) + bank.droppedSamples(1));
+}
+
+TEST(ForceFilterBank, RejectsBadConfigurations) {
+	EXPECT_THROW(ForceFilterBank<cf_type>(std::vector<FilterBranch>(1, FilterBranch::movingAverage(0)), T_S), std::invalid_argument);
+	EXPECT_THROW(ForceFilterBank<cf_type>(std::vector<FilterBranch>(1, FilterBranch::butterworth(20, 0.8, 3)), T_S), std::invalid_argument);
+	EXPECT_THROW(ForceFilterBank<cf_type>(std::vector<FilterBranch>(1, FilterBranch::butterworth(20, 25.0)), T_S), std::invalid_argument);
+	EXPECT_THROW(ForceFilterBank<cf_type>(std::vector<FilterBranch>(1, FilterBranch::movingAverage(1)), 0.0), std::invalid_argument);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+/*
+ * contact_detector.h
+ *
+ * Make/break detection of tool contact from the estimated Cartesian force,
+ * at the control rate.
+ *
+ * Contact is made once |F| has been above makeForce (or, with a rate
+ * criterion, d|F|/dt above makeRate while |F| is above breakForce) for
+ * makeTicks consecutive ticks, and broken once |F| has been below
+ * breakForce for breakTicks ticks. makeForce > breakForce is the
+ * hysteresis; the tick counts debounce the estimate's noise. d|F|/dt is
+ * taken over the last RATE_WINDOW ticks.
+ *
+ * contactOutput follows the state from the tick it changes, so other
+ * systems in the graph can react one tick later. Each change is also pushed
+ * as a ContactEvent into a wait-free queue (RecordRing, columnar_log.h),
+ * stamped with the tick at which the criterion was first met and the tick it
+ * was confirmed; popEvent() drains it on a non-real-time thread.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/columnar_log.h>
+
+using namespace barrett;
+
+struct ContactEvent {
+	bool contact;			// made (true) or broken
+	uint64_t onsetTick;		// first tick the criterion held
+	uint64_t confirmTick;	// tick the event was emitted
+	units::CartesianForce::type force;	// [N] at confirmTick
+	double forceRate;		// [N/s] d|F|/dt at confirmTick
+};
+
+class ContactDetector : public systems::System
+{
+public:
+	typedef units::CartesianForce::type cf_type;
+
+	static const size_t RATE_WINDOW = 8;		// [ticks]
+	static const size_t EVENT_CAPACITY = 64;	// events held until popEvent()
+
+// IO  (inputs)
+public:
+	Input<cf_type> cfInput;
+
+// IO  (outputs)
+public:
+	Output<bool> contactOutput;
+
+protected:
+	Output<bool>::Value* contactOutputValue;
+
+public:
+	// makeRate [N/s] <= 0 disables the rate criterion.
+	ContactDetector(double makeForce, double breakForce, size_t makeTicks, size_t breakTicks, double makeRate = 0.0,
+			const std::string& sysName = "ContactDetector"):
+		System(sysName), cfInput(this), contactOutput(this, &contactOutputValue),
+		makeForce(makeForce), breakForce(breakForce), makeTicks(makeTicks), breakTicks(breakTicks), makeRate(makeRate),
+		T_s(0.0), tick(0), inContact(false), pending(0), onset(0), forceRate(0.0), events(EVENT_SIZE, EVENT_CAPACITY), lastTick(0) {
+		for (size_t i = 0; i < RATE_WINDOW; ++i) {
+			history[i] = 0.0;
+		}
+		contactOutputValue->setData(&inContact);
+		getSamplePeriodFromEM();
+	}
+
+	virtual ~ContactDetector() { this->mandatoryCleanUp(); }
+
+	void setThresholds(double makeForce_, double breakForce_, size_t makeTicks_, size_t breakTicks_, double makeRate_ = 0.0) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		makeForce = makeForce_;
+		breakForce = breakForce_;
+		makeTicks = makeTicks_;
+		breakTicks = breakTicks_;
+		makeRate = makeRate_;
+	}
+
+	// Oldest queued event, on the (single) consumer thread. False if none.
+	bool popEvent(ContactEvent& e) {
+		const double* r;
+		if (events.peek(&r) == 0) {
+			return false;
+		}
+		e.contact = r[0] != 0.0;
+		e.onsetTick = static_cast<uint64_t>(r[1]);
+		e.confirmTick = static_cast<uint64_t>(r[2]);
+		e.force << r[3], r[4], r[5];
+		e.forceRate = r[6];
+		events.pop(1);
+		return true;
+	}
+
+	uint64_t currentTick() const { return lastTick.load(std::memory_order_relaxed); }
+	double period() const { return T_s; }	// [s] per tick, 0 until managed
+	uint64_t droppedEvents() const { return events.droppedRecords(); }
+
+protected:
+	static const size_t EVENT_SIZE = 7;	// contact, onset, confirm, force, rate
+
+	double makeForce, breakForce;	// [N]
+	size_t makeTicks, breakTicks;
+	double makeRate;				// [N/s]
+
+	double T_s;
+	uint64_t tick;
+	bool inContact;
+	size_t pending;		// consecutive ticks the opposite state's criterion has held
+	uint64_t onset;
+	double history[RATE_WINDOW];	// |F| of the last ticks, circular
+	double forceRate;
+	double record[EVENT_SIZE];
+
+	RecordRing events;
+	std::atomic<uint64_t> lastTick;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		getSamplePeriodFromEM();
+	}
+
+	void getSamplePeriodFromEM() {
+		T_s = this->hasExecutionManager() ? this->getExecutionManager()->getPeriod() : 0.0;
+	}
+
+	virtual void operate() {
+		++tick;
+		const cf_type& f = this->cfInput.getValue();
+		const double norm = f.norm();
+		double& oldest = history[tick % RATE_WINDOW];
+		forceRate = (tick > RATE_WINDOW && T_s > 0.0) ? (norm - oldest) / (RATE_WINDOW * T_s) : 0.0;
+		oldest = norm;
+
+		const bool criterion = inContact ? norm < breakForce
+				: (norm > makeForce || (makeRate > 0.0 && forceRate > makeRate && norm > breakForce));
+		if ( !criterion) {
+			pending = 0;
+		} else if (pending++ == 0) {
+			onset = tick;
+		}
+
+		if (pending >= (inContact ? breakTicks : makeTicks) && pending > 0) {
+			inContact = !inContact;
+			pending = 0;
+			record[0] = inContact ? 1.0 : 0.0;
+			record[1] = static_cast<double>(onset);
+			record[2] = static_cast<double>(tick);
+			record[3] = f[0];
+			record[4] = f[1];
+			record[5] = f[2];
+			record[6] = forceRate;
+			events.push(record);
+		}
+
+		lastTick.store(tick, std::memory_order_relaxed);
+		contactOutputValue->setData(&inContact);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(ContactDetector);
+};
@@ -0,0 +1,241 @@
+/*
+ * guarded_move.h
+ *
+ * Guarded Cartesian move: streams a straight-line position setpoint along a
+ * direction at constant speed to the impedance controller, and watches the
+ * estimated contact force on the same tick.
+ *
+ * The first tick |F - F_0| exceeds the threshold (F_0 is the estimate when
+ * the move starts, so the estimator's bias doesn't count) the measured tool
+ * position, force and tick are latched and the approach stops. The setpoint
+ * then either holds the latched position, which unloads the controller's
+ * spring so the tool rests on the surface, or backs off along the direction
+ * by the retract distance at the approach speed. If there is no contact
+ * within the maximum distance the setpoint stops at its end.
+ *
+ * start() and cancel() take the execution manager's mutex, so they can be
+ * called from ROS service threads; operate() never allocates.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <barrett/os.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+class GuardedMove : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	enum State {
+		IDLE,			// never started, or cancelled
+		APPROACHING,
+		HOLDING,		// in contact, at the latched position
+		RETRACTING,
+		RETRACTED,		// in contact, backed off
+		MISSED			// no contact within the maximum distance
+	};
+
+	struct Result {
+		State state;
+		bool contact;
+		cp_type position;	// [m] measured tool position on the contact tick
+		cf_type force;		// [N] estimate on the contact tick
+		cf_type forceRise;	// [N] F - F_0 on the contact tick
+		double distance;	// [m] setpoint travel to contact (or to the end)
+		uint64_t ticks;		// from start() to contact (or to the end)
+
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+
+// IO  (inputs)
+public:
+	Input<cp_type> cpInput;
+	Input<cf_type> cfInput;
+
+// IO  (outputs)
+public:
+	Output<cp_type> positionOutput;
+
+protected:
+	typename Output<cp_type>::Value* positionOutputValue;
+
+public:
+	explicit GuardedMove(const std::string& sysName = "GuardedMove"):
+		System(sysName), cpInput(this), cfInput(this), positionOutput(this, &positionOutputValue),
+		state(IDLE), started(false), speed(0.0), maxDistance(0.0), threshold(0.0), retractDistance(0.0), retract(false),
+		T_s(0.0), tick(0), s(0.0), baselineSet(false) {
+		result.state = IDLE;
+		result.contact = false;
+		getSamplePeriodFromEM();
+	}
+
+	virtual ~GuardedMove() { this->mandatoryCleanUp(); }
+
+	// Approach from `from` along `direction` (normalized here) at speed
+	// [m/s] for at most maxDistance [m]; contact is |F - F_0| > forceThreshold
+	// [N]. After contact, back off retractDistance [m] if retract, else hold.
+	// Returns false (and doesn't move) on a nonsensical request.
+	bool start(const cp_type& from, const cp_type& direction, double speed_, double maxDistance_, double forceThreshold,
+			bool retract_ = false, double retractDistance_ = 0.0) {
+		if (direction.norm() == 0.0 || speed_ <= 0.0 || maxDistance_ <= 0.0 || forceThreshold <= 0.0
+				|| (retract_ && retractDistance_ <= 0.0)) {
+			return false;
+		}
+
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		origin = from;
+		dir = direction / direction.norm();
+		speed = speed_;
+		maxDistance = maxDistance_;
+		threshold = forceThreshold;
+		retract = retract_;
+		retractDistance = retractDistance_;
+
+		cp_out = origin;
+		s = 0.0;
+		tick = 0;
+		baselineSet = false;
+		result.state = APPROACHING;
+		result.contact = false;
+		result.distance = 0.0;
+		result.ticks = 0;
+		state = APPROACHING;
+		started = true;
+		return true;
+	}
+
+	// Stop where the setpoint is.
+	void cancel() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		if (state == APPROACHING || state == RETRACTING) {
+			state = IDLE;
+			result.state = IDLE;
+		}
+	}
+
+	bool isDone() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return state != APPROACHING && state != RETRACTING;
+	}
+
+	// Blocks the calling (non real-time) thread until the move is done or
+	// timeout [s] has passed. Returns isDone().
+	bool waitForCompletion(double timeout, double pollPeriod = 0.01) {
+		for (double t = 0.0; t < timeout; t += pollPeriod) {
+			if (isDone()) {
+				return true;
+			}
+			btsleep(pollPeriod);
+		}
+		return isDone();
+	}
+
+	Result getResult() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return result;
+	}
+
+	cp_type currentSetpoint() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return cp_out;
+	}
+
+	double period() const { return T_s; }	// [s] per tick, 0 until managed
+
+protected:
+	State state;
+	bool started;
+
+	cp_type origin, dir;
+	double speed, maxDistance, threshold, retractDistance;
+	bool retract;
+
+	double T_s;
+	uint64_t tick;
+	double s;			// [m] setpoint travel along dir (back off: from the contact position)
+	bool baselineSet;
+	cf_type baseline;
+	Result result;
+
+	cp_type cp_out;
+
+	virtual void onExecutionManagerChanged() {
+		System::onExecutionManagerChanged();
+		getSamplePeriodFromEM();
+	}
+
+	void getSamplePeriodFromEM() {
+		T_s = this->hasExecutionManager() ? this->getExecutionManager()->getPeriod() : 0.0;
+	}
+
+	virtual void operate() {
+		switch (state) {
+		case APPROACHING: {
+			++tick;
+			const cf_type& f = this->cfInput.getValue();
+			if ( !baselineSet) {
+				baseline = f;
+				baselineSet = true;
+			}
+
+			if ((f - baseline).norm() > threshold) {
+				result.contact = true;
+				result.position = this->cpInput.getValue();
+				result.force = f;
+				result.forceRise = f - baseline;
+				result.distance = s;
+				result.ticks = tick;
+				if (retract) {
+					// back off from where the tool is, not from the setpoint ahead of it
+					origin = result.position;
+					s = 0.0;
+					state = RETRACTING;
+				} else {
+					state = HOLDING;
+				}
+				cp_out = result.position;
+			} else if (s >= maxDistance) {
+				result.distance = s;
+				result.ticks = tick;
+				state = MISSED;
+			} else {
+				s = std::min(s + speed * T_s, maxDistance);
+				cp_out = origin + s * dir;
+			}
+			result.state = state;
+			break;
+		}
+		case RETRACTING:
+			s = std::min(s + speed * T_s, retractDistance);
+			cp_out = origin - s * dir;
+			if (s >= retractDistance) {
+				state = RETRACTED;
+				result.state = state;
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (started) {
+			positionOutputValue->setData(&cp_out);
+		} else {
+			positionOutputValue->setUndefined();
+		}
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(GuardedMove);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,134 @@
+/*
+ * hybrid_force_position_controller.h
+ *
+ * Hybrid force/position control on a surface. The 6-DOF impedance law runs
+ * as before; its force is then split with the selection matrix built from
+ * the surface normal n on every tick:
+ *
+ *     F = (I - n n^T) F_imp + n n^T (-Dx v) + n f_n,
+ *     f_n = n.F_d + Kp e + Ki integral(e),   e = n.(F_d - F_measured)
+ *
+ * i.e. position impedance in the tangent plane, PI regulation of the contact
+ * force along the normal, with the normal stiffness dropped and the normal
+ * damping kept. The integral is clamped to +/- integralLimit [N]
+ * (anti-windup). With force control disabled (the default) or a zero normal
+ * it is the plain ImpedanceController6DOF.
+ *
+ * ForceInput has to be an estimate that does not follow from this
+ * controller's own command, e.g. the MomentumObserver residual (see
+ * momentum_observer.h). A static J^T+ (tau - g) estimate fed with wam.jtSum
+ * just returns the commanded force, so the loop would close on itself and
+ * the PI would act as feedforward.
+ */
+
+#pragma once
+
+#include "planar_surface_hybrid_control/impedence_controller.h"
+
+namespace barrett
+{
+	namespace systems
+	{
+
+		template <size_t DOF>
+		class HybridForcePositionController : public ImpedanceController6DOF<DOF>
+		{
+			BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+			// IO  (inputs)
+		public:
+			System::Input<cp_type> SurfaceNormalInput; // surface normal in the base frame (any length)
+			System::Input<cf_type> ForceDesInput;      // desired contact force; only its normal component is regulated
+			System::Input<cf_type> ForceInput;         // measured contact force, independent of the command
+
+		public:
+			double forceError; // normal force error of the last tick, for display
+
+		public:
+			HybridForcePositionController(double forceKp = 0.2, double forceKi = 10.0, double integralLimit = 10.0,
+				const std::string &sysName = "HybridForcePositionController") : ImpedanceController6DOF<DOF>(sysName),
+																				 SurfaceNormalInput(this), ForceDesInput(this), ForceInput(this),
+																				 forceError(0.0), Kp_f(forceKp), Ki_f(forceKi), integralLimit(integralLimit),
+																				 T_s(0.0), forceControl(false), integral(0.0)
+			{
+				getSamplePeriodFromEM();
+			}
+			virtual ~HybridForcePositionController()
+			{
+				this->mandatoryCleanUp();
+			}
+
+			// Switches the normal direction between impedance and force regulation.
+			// Resets the integrator; safe to call while running.
+			void setForceControl(bool enable)
+			{
+				BARRETT_SCOPED_LOCK(this->getEmMutex());
+				forceControl = enable;
+				integral = 0.0;
+			}
+
+			bool isForceControlled() const { return forceControl; }
+
+		protected:
+			double Kp_f, Ki_f, integralLimit;
+			double T_s;
+			bool forceControl;
+			double integral;
+
+			cp_type n;
+			cf_type F_imp;
+			cf_type F_damp;
+
+			virtual void onExecutionManagerChanged()
+			{
+				System::onExecutionManagerChanged();
+				getSamplePeriodFromEM();
+			}
+
+			void getSamplePeriodFromEM()
+			{
+				if (this->hasExecutionManager())
+				{
+					T_s = this->getExecutionManager()->getPeriod();
+				}
+				else
+				{
+					T_s = 0.0;
+				}
+			}
+
+			virtual void operate()
+			{
+				ImpedanceController6DOF<DOF>::operate(); // this->cf, this->ct
+
+				n = SurfaceNormalInput.getValue();
+				const double norm = n.norm();
+				if ( !forceControl || norm < 1e-6)
+				{
+					forceError = 0.0;
+					return;
+				}
+				n /= norm;
+
+				const double f_d = n.dot(ForceDesInput.getValue());
+				forceError = f_d - n.dot(ForceInput.getValue());
+
+				integral += forceError * T_s;
+				if (Ki_f > 0.0)
+				{
+					integral = std::max(-integralLimit / Ki_f, std::min(integralLimit / Ki_f, integral));
+				}
+				const double f_n = f_d + Kp_f * forceError + Ki_f * integral;
+
+				// tangent-plane impedance + normal damping + normal force
+				F_imp = this->cf;
+				F_damp = -this->Dx.cwiseProduct(this->Vcurr);
+				this->cf = F_imp - n * n.dot(F_imp) + n * (n.dot(F_damp) + f_n);
+				this->computedF = this->cf;
+			}
+
+		private:
+			DISALLOW_COPY_AND_ASSIGN(HybridForcePositionController);
+		};
+	}
+}
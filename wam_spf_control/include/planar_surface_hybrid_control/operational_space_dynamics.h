@@ -0,0 +1,205 @@
+/*
+ * operational_space_dynamics.h
+ *
+ * Operational-space quantities of the tool task and a posture controller
+ * that acts only in its null space.
+ *
+ * OperationalSpaceDynamics takes the mass matrix M (RNEADynamics) and the
+ * tool Jacobian (KinematicsBundle) and computes, for the first TASK rows of
+ * J (3: position, 6: position and orientation),
+ *
+ *     Lambda = (J M^-1 J^T)^-1                     task-space inertia
+ *     Jbar   = M^-1 J^T Lambda                     dynamically consistent inverse
+ *     N      = I - J^T Jbar^T                      torque null-space projector
+ *
+ * A torque N tau0 produces no task-space acceleration, so adding it to
+ * J^T F leaves the tool alone. M^-1 comes from an LLT factor of M that is
+ * refactored once M has moved more than refactorTolerance (relative,
+ * Frobenius norm) from the matrix it was factored at; at control rate M
+ * changes by far less than that per tick, so the factor is reused across
+ * ticks while the arm moves slowly. N stays a projector with the cached
+ * M^-1, only the dynamic consistency is approximate in between. Near a
+ * task singularity J M^-1 J^T loses
+ * rank; its eigenvalues below minEigenvalue are damped instead of inverted,
+ * so Lambda stays bounded. All storage is fixed-size.
+ *
+ * NullSpacePosture outputs N (kp (q0 - q) - kd qd) while enabled and zero
+ * otherwise, for a redundant arm (7-DOF with TASK = 6) to hold its elbow
+ * while the tool follows the surface.
+ */
+
+#pragma once
+
+#include <string>
+#include <eigen3/Eigen/Dense>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+#include <wam_control_common/kinematics_bundle.h>
+
+using namespace barrett;
+
+template<size_t DOF, int TASK = (DOF >= 6 ? 6 : 3)>
+class OperationalSpaceDynamics : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef Eigen::Matrix<double, DOF, DOF> mass_matrix_type;
+	typedef Eigen::Matrix<double, TASK, TASK> task_inertia_type;
+	typedef Eigen::Matrix<double, DOF, DOF> projector_type;
+
+// IO  (inputs)
+public:
+	Input<mass_matrix_type> massMatrixInput;
+	Input<KinematicsView<DOF> > kinematicsInput;
+
+// IO  (outputs)
+public:
+	Output<task_inertia_type> lambdaOutput;
+	Output<projector_type> nullSpaceProjectorOutput;
+
+protected:
+	typename Output<task_inertia_type>::Value* lambdaOutputValue;
+	typename Output<projector_type>::Value* nullSpaceProjectorOutputValue;
+
+public:
+	explicit OperationalSpaceDynamics(double minEigenvalue = 1e-3, double refactorTolerance = 1e-3,
+			const std::string& sysName = "OperationalSpaceDynamics"):
+		System(sysName), massMatrixInput(this), kinematicsInput(this),
+		lambdaOutput(this, &lambdaOutputValue), nullSpaceProjectorOutput(this, &nullSpaceProjectorOutputValue),
+		minEigenvalue(minEigenvalue), refactorTolerance(refactorTolerance), factored(false) {
+		M.setZero();
+		Minv.setZero();
+		lambda.setZero();
+		N.setIdentity();
+	}
+
+	virtual ~OperationalSpaceDynamics() { this->mandatoryCleanUp(); }
+
+protected:
+	typedef Eigen::Matrix<double, TASK, DOF> task_jacobian_type;
+
+	double minEigenvalue;	// [1/kg] or [1/(kg m^2)], of J M^-1 J^T
+	double refactorTolerance;
+	bool factored;
+
+	mass_matrix_type M, Minv;	// M as of the last factorization
+	Eigen::LLT<mass_matrix_type> llt;
+	task_jacobian_type J;
+	Eigen::Matrix<double, DOF, TASK> MinvJt, Jbar;
+	task_inertia_type lambdaInverse, lambda;
+	Eigen::SelfAdjointEigenSolver<task_inertia_type> eig;
+	Eigen::Matrix<double, TASK, 1> inverseEigenvalues;
+	projector_type N;
+
+	virtual void operate() {
+		const mass_matrix_type& Min = this->massMatrixInput.getValue();
+		if ( !factored || (Min - M).norm() > refactorTolerance * M.norm()) {
+			factored = true;
+			M = Min;
+			llt.compute(M);
+			Minv.setIdentity();
+			llt.solveInPlace(Minv);
+		}
+
+		J = this->kinematicsInput.getValue().J.template topRows<TASK>();
+		MinvJt.noalias() = Minv * J.transpose();
+		lambdaInverse.noalias() = J * MinvJt;
+
+		// Lambda = (J M^-1 J^T)^-1, with the small eigenvalues damped
+		eig.compute(lambdaInverse);
+		for (int i = 0; i < TASK; ++i) {
+			const double l = eig.eigenvalues()[i];
+			inverseEigenvalues[i] = l / (l * l + minEigenvalue * minEigenvalue);
+		}
+		lambda.noalias() = eig.eigenvectors() * inverseEigenvalues.asDiagonal() * eig.eigenvectors().transpose();
+
+		Jbar.noalias() = MinvJt * lambda;
+		N.setIdentity();
+		N.noalias() -= J.transpose() * Jbar.transpose();
+
+		this->lambdaOutputValue->setData(&lambda);
+		this->nullSpaceProjectorOutputValue->setData(&N);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(OperationalSpaceDynamics);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+
+template<size_t DOF>
+class NullSpacePosture : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef Eigen::Matrix<double, DOF, DOF> projector_type;
+
+// IO  (inputs)
+public:
+	Input<jp_type> jpInput;
+	Input<jv_type> jvInput;
+	Input<projector_type> nullSpaceProjectorInput;
+
+// IO  (outputs)
+public:
+	Output<jt_type> jtOutput;
+
+protected:
+	typename Output<jt_type>::Value* jtOutputValue;
+
+public:
+	// kp [Nm/rad] and kd [Nm s/rad] per joint.
+	NullSpacePosture(const jv_type& kp, const jv_type& kd, const std::string& sysName = "NullSpacePosture"):
+		System(sysName), jpInput(this), jvInput(this), nullSpaceProjectorInput(this), jtOutput(this, &jtOutputValue),
+		kp(kp), kd(kd), posture(0.0), enabled(false), jt(0.0) {}
+
+	virtual ~NullSpacePosture() { this->mandatoryCleanUp(); }
+
+	// Holds q0 from the next tick on.
+	void enable(const jp_type& q0) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		posture = q0;
+		enabled = true;
+	}
+
+	void disable() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		enabled = false;
+	}
+
+	void setGains(const jv_type& kp_, const jv_type& kd_) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		kp = kp_;
+		kd = kd_;
+	}
+
+protected:
+	jv_type kp, kd;
+	jp_type posture;
+	bool enabled;
+
+	Eigen::Matrix<double, DOF, 1> tau0;
+	jt_type jt;
+
+	virtual void operate() {
+		if (enabled) {
+			tau0 = kp.cwiseProduct(posture - this->jpInput.getValue()) - kd.cwiseProduct(this->jvInput.getValue());
+			jt = this->nullSpaceProjectorInput.getValue() * tau0;
+		} else {
+			jt.setZero();
+		}
+		this->jtOutputValue->setData(&jt);
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(NullSpacePosture);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -28,6 +28,10 @@
 
 #include "wam_srvs/StaticForceEstimationwithG.h"
 #include "wam_msgs/RTCartForce.h"
+#include "wam_spf_control/ContactEvent.h"
+#include "wam_spf_control/SurfacePlane.h"
+#include "wam_spf_control/GuardedMove.h"
+#include "wam_spf_control/ProbeSurface.h"
 #include "sensor_msgs/JointState.h"
 #include "geometry_msgs/PoseStamped.h"
 #include "wam_msgs/RTOrtn.h"
@@ -36,6 +40,8 @@
 #include "wam_msgs/MatrixMN.h"
 #include "wam_msgs/RTToolInfo.h"
 #include "std_srvs/Empty.h"
+#include "std_srvs/Trigger.h"
+#include "std_msgs/String.h"
 #include "wam_srvs/JointMoveBlock.h"
 #include "wam_srvs/Teach.h"
 #include "wam_srvs/Play.h"
@@ -58,12 +64,53 @@
 #include <fcntl.h>
 #include <termios.h>
 
+#include <wam_control_common/momentum_observer.h>
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/state_snapshot.h>
+#include <wam_control_common/trajectory_streamer.h>
+#include <wam_control_common/trajectory_file.h>
+#include <wam_control_common/columnar_log.h>
+#include <wam_control_common/rt_trace.h>
+#include <wam_control_common/operate_timing.h>
+#include <wam_control_common/cubic_bezier.h>
+#include <wam_control_common/rnea_dynamics.h>
+
 #include "planar_surface_hybrid_control/impedence_controller.h"
-#include "planar_surface_hybrid_control/static_force_estimator_withg.h"
-#include "planar_surface_hybrid_control/get_jacobian_system.h"
+#include "planar_surface_hybrid_control/hybrid_force_position_controller.h"
+#include "planar_surface_hybrid_control/plane_estimator.h"
+#include "planar_surface_hybrid_control/contact_detector.h"
+#include "planar_surface_hybrid_control/guarded_move.h"
+#include "planar_surface_hybrid_control/time_optimal_scaling.h"
+#include "planar_surface_hybrid_control/operational_space_dynamics.h"
 
 static const int PUBLISH_FREQ = 250; // Default Control Loop / Publishing Frequency
 static const double SPEED = 0.03; // Default Cartesian Velocity
+static const double VELOCITY_LIMIT = 1.5; // [m/s] safety module tool/elbow velocity limit
+static const double JOINT_VELOCITY_LIMIT = 1.5; // [rad/s] for the time-optimal replay
+static const double REPLAY_VELOCITY_MARGIN = 0.3; // fraction of VELOCITY_LIMIT the time-optimal replay may use
+static const double REPLAY_TORQUE_MARGIN = 0.5; // fraction of jtLimits for the path; the rest is left to the impedance/force feedback
+static const double CONTACT_FORCE_THRESHOLD = 5.0; // [N] estimated force above which the tool is taken to be in contact
+static const double CONTACT_MAKE_FORCE = 14.0; // [N] ContactDetector: contact made above this...
+static const double CONTACT_BREAK_FORCE = 10.0; // [N] ...and broken below this
+static const size_t CONTACT_MAKE_TICKS = 5; // control ticks the make criterion must hold
+static const size_t CONTACT_BREAK_TICKS = 25; // control ticks the break criterion must hold
+static const double CONTACT_MAKE_RATE = 0.0; // [N/s] d|F|/dt that also makes contact (above CONTACT_BREAK_FORCE); 0 disables
+static const double GUARDED_MOVE_MAX_SPEED = 0.1; // [m/s] fastest approach the guarded_move service accepts
+static const double GUARDED_MOVE_TIMEOUT_MARGIN = 2.0; // [s] allowed beyond the nominal duration of a guarded move
+static const double PROBE_TRANSIT_SPEED = 0.05; // [m/s] between the points of the probe_surface grid
+static const double PROBE_TRANSIT_MIN_DISTANCE = 0.001; // [m] shorter transits to a grid point are skipped
+static const double PROBE_MIN_SPREAD = 0.02; // [m] in-plane spread of the contacts for full fit confidence, as PlaneEstimator's
+static const double PROBE_MIN_CONFIDENCE = 0.95; // probe_surface fits below this are rejected
+static const double PROBE_MIN_ALIGNMENT = 0.5; // cosine between a probe's force rise and its approach below which the contact isn't the surface pushing back
+static const double OPERATE_TIMING_PERIOD = 1.0; // [s] between operate_timing summaries
+static const double PLANE_MIN_CONFIDENCE = 0.95; // running surface fits below this are neither adopted nor replayed on
+static const double PLANE_PUBLISH_PERIOD = 0.1; // [s] between surface_plane messages
+static const double NULL_SPACE_STIFFNESS = 10.0; // [Nm/rad] posture held in the null space of the tool task
+static const double NULL_SPACE_DAMPING = 1.0; // [Nm s/rad]
+static const double MOMENTUM_OBSERVER_GAIN = 150.0; // [1/s] per joint, bandwidth of the force the hybrid controller regulates
+static const char FORCE_TRACE_PATH[] = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/force_trace.txt"; // estimated contact force, see rt_trace.h
+static const double PLAYBACK_SKIP = 0.8; // [s] of a recorded trajectory dropped before the first waypoint
+static const double PLAYBACK_WAYPOINT_PERIOD = 0.1; // [s] between replayed waypoints
 
 using namespace barrett;
 using barrett::detail::waitForEnter;
@@ -112,11 +159,13 @@ class PlanarHybridControl
 
 		libconfig::Setting& setting;
 		libconfig::Config config;
+		TimeOptimalScaling<DOF> timeScaling; // knot timing for trajectory replay
 
 		bool locked_joints;
 		bool systems_connected;		
 
 		bool force_estimated;
+		bool surface_calibrated;
 		cf_type force_norm;
 
         systems::Wam<DOF>& wam;
@@ -132,6 +181,9 @@ class PlanarHybridControl
 		wam_msgs::MatrixMN wam_jacobian_mn;
 		wam_msgs::RTToolInfo wam_tool_info;
 		wam_msgs::RTCartForce force_msg;
+		wam_spf_control::ContactEvent contact_event_msg;
+		std_msgs::String operate_timing_msg;
+		wam_spf_control::SurfacePlane surface_plane_msg;
 
 		// publishers
 		ros::Publisher wam_joint_state_pub;
@@ -139,6 +191,11 @@ class PlanarHybridControl
 		ros::Publisher wam_jacobian_mn_pub;
 		ros::Publisher wam_tool_pub;
 		ros::Publisher wam_estimated_contact_force_pub;
+		ros::Publisher contact_event_pub;
+		ros::Publisher operate_timing_pub;
+		ros::Timer operate_timing_timer;
+		ros::Publisher surface_plane_pub;
+		ros::Timer surface_plane_timer;
 
         // services
 		ros::ServiceServer disconnect_systems_srv;
@@ -151,28 +208,42 @@ class PlanarHybridControl
 		ros::ServiceServer cp_impedance_control_srv;
 		ros::ServiceServer grid_test_calib_srv;
 		ros::ServiceServer grid_test_srv;
+		ros::ServiceServer operate_timing_srv;
+		ros::ServiceServer reset_operate_timing_srv;
+		ros::ServiceServer guarded_move_srv;
+		ros::ServiceServer probe_surface_srv;
+
+		//operate() timing of the systems below, see operate_timing.h
+		GraphTimer graphTimer;
 
 		//Contace Force Estimation
-		StaticForceEstimatorwithG<DOF> staticForceEstimator;
-		getJacobian<DOF> getWAMJacobian;
+		Timed<MomentumObserver<DOF> > momentumObserver; // the contact force every consumer below uses
+		Timed<KinematicsBundle<DOF> > kinematics;
 		systems::GravityCompensator<DOF> gravityTerm;
-		std::ofstream outputFile; 
-		systems::PrintToStream<cf_type> print;
+		Timed<RTTraceSink<cf_type> > forceTrace;
+		Timed<PlaneEstimator<DOF> > planeEstimator;
+		Timed<ContactDetector> contactDetector; // make/break events -> contact_events
+		Timed<StateSnapshot<DOF> > stateSnapshot; // RT -> publishWam
 
-		//Impedance Control
-		systems::ImpedanceController6DOF<DOF> ImpControl;
+		//Impedance Control (hybrid force/position along the surface normal when enabled)
+		Timed<systems::HybridForcePositionController<DOF> > ImpControl;
 		systems::ExposedOutput<cp_type> KxSet;
 		systems::ExposedOutput<cp_type> DxSet;
-		systems::ExposedOutput<cp_type> XdSet;
 		systems::ExposedOutput<cp_type> OrnKxSet;
 		systems::ExposedOutput<cp_type> OrnDxSet;
-		systems::ExposedOutput<Eigen::Quaterniond> OrnXdSet;
+		Timed<TrajectoryStreamer<DOF> > refStreamer; // streams Xd and the orientation reference
+		Timed<GuardedMove<DOF> > guardedMove; // streams Xd instead during a guarded move
 		systems::ExposedOutput<cp_type> KthSet;
-		systems::ExposedOutput<cf_type> FeedFwdForce;
+		systems::ExposedOutput<cp_type> SurfaceNormalSet;
+		systems::ExposedOutput<cf_type> ForceDesSet;
 		systems::ToolForceToJointTorques<DOF> toolforce2jt;
-		systems::ToolForceToJointTorques<DOF> toolforcefeedfwd2jt;
-		systems::Summer<jt_type> torqueSum;
+		systems::Summer<jt_type, 3> torqueSum; // force, orientation torque, null-space posture
 		systems::ToolTorqueToJointTorques<DOF> tt2jt_ortn_split;
+
+		//Null-space posture control (redundant arms), see operational_space_dynamics.h
+		Timed<RNEADynamics<DOF> > dynamics;
+		Timed<OperationalSpaceDynamics<DOF> > osDynamics;
+		Timed<NullSpacePosture<DOF> > nullSpacePosture;
 		
 
     public:
@@ -186,8 +257,14 @@ class PlanarHybridControl
             jtLimits(20.0), 
 			jtSat(boost::bind(saturateJt<DOF>, _1, jtLimits)),
 			setting(pm.getConfig().lookup(pm.getWamDefaultConfigPath())),
+			timeScaling(setting),
+			momentumObserver(v_type(MOMENTUM_OBSERVER_GAIN)),
 			gravityTerm(setting["gravity_compensation"]),
-			print(pm.getExecutionManager(),"Data: ", outputFile){}
+			forceTrace(pm.getExecutionManager(), FORCE_TRACE_PATH, "Data: "),
+			planeEstimator(CONTACT_FORCE_THRESHOLD),
+			contactDetector(CONTACT_MAKE_FORCE, CONTACT_BREAK_FORCE, CONTACT_MAKE_TICKS, CONTACT_BREAK_TICKS, CONTACT_MAKE_RATE),
+			dynamics(setting),
+			nullSpacePosture(jv_type(NULL_SPACE_STIFFNESS), jv_type(NULL_SPACE_DAMPING)){}
 
         ~PlanarHybridControl(){}
 
@@ -198,13 +275,25 @@ class PlanarHybridControl
         bool jointMoveBlockCallback(wam_srvs::JointMoveBlock::Request &req, wam_srvs::JointMoveBlock::Response &res);
         void publishWam(ProductManager& pm);
 		bool SPFCartImpCOntroller(wam_srvs::Play::Request &req, wam_srvs::Play::Response &res);
-		std::vector<units::CartesianPosition::type> generateCubicSplineWaypoints(const units::CartesianPosition::type& initialPos, const units::CartesianPosition::type& finalPos, double offset);
 		void disconnectSystems();
 		bool disconnectSystems(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res);
+		bool operateTimingCallback(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res);
+		bool resetOperateTimingCallback(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res);
+		bool guardedMoveCallback(wam_spf_control::GuardedMove::Request &req, wam_spf_control::GuardedMove::Response &res);
+		bool probeSurface(wam_spf_control::ProbeSurface::Request &req, wam_spf_control::ProbeSurface::Response &res);
+		void holdToolPose();
+		bool runGuardedMove(const cp_type& direction, double speed, double max_distance, double force_threshold,
+		                    bool retract, double retract_distance, typename GuardedMove<DOF>::Result& result);
+		void publishOperateTiming(const ros::TimerEvent& event);
+		void publishSurfacePlane(const ros::TimerEvent& event);
+		std::string operateTimingReport();
 		void goHome();
 		void CartImpController(std::vector<cp_type> &Trajectory, int step = 1, const cp_type &KpApplied = Eigen::Vector3d::Zero(), const cp_type &KdApplied = Eigen::Vector3d::Zero(),
                                                  bool orientation_control = false, const cp_type &OrnKpApplied = Eigen::Vector3d::Zero(), const cp_type &OrnKdApplied = Eigen::Vector3d::Zero(),
-                                                 bool ext_force = false, const cf_type &des_force = Eigen::Vector3d::Zero(), bool null_space = false);         
+                                                 bool ext_force = false, const cf_type &des_force = Eigen::Vector3d::Zero(), bool null_space = false,
+                                                 bool time_optimal = false);         
+		void CartImpApproach(const cp_type &target, double offset, const cp_type &KpApplied, const cp_type &KdApplied,
+                                                 const Eigen::Quaterniond &orn, const cp_type &OrnKpApplied, const cp_type &OrnKdApplied);
 		Eigen::Matrix3d computeDesiredRotationMatrix(const Eigen::Vector3d& surfaceNormal);
         	bool areOrientationsDifferent(const Eigen::Quaterniond& q1, const Eigen::Quaterniond& q2);
         	std::vector<Eigen::Quaterniond> generateQuaternionWaypoints(const Eigen::Quaterniond& start, const Eigen::Quaterniond& end, int numWaypoints);
@@ -0,0 +1,223 @@
+/*
+ * plane_estimator.h
+ *
+ * Streaming plane fit of the surface under the tool. While the contact
+ * force is above a threshold, every tool position updates an exponentially
+ * weighted mean and covariance (forgetting factor lambda, O(1) per sample):
+ *
+ *     w <- lambda w + 1,  a = 1 / w,  e = x - m
+ *     m <- m + a e
+ *     C <- (1 - a) (C + a e e^T)
+ *
+ * The normal is the eigenvector of the smallest eigenvalue l0 of C (fixed
+ * 3x3 solve), oriented against the measured contact force so it points out
+ * of the surface; offset = normal . m, so the plane is normal . x = offset.
+ * With a zero threshold every sample is used and, with no contact force
+ * to go by, the normal is oriented towards the robot base instead.
+ *
+ * Confidence in [0, 1] is (1 - l0 / l1) * min(1, sqrt(l1) / minSpread):
+ * the points have to be planar and spread at least minSpread [m] (standard
+ * deviation) in the weaker in-plane direction. Outputs stay undefined until a few samples
+ * have been taken.
+ *
+ * The estimator has to be managed by the execution manager to keep running
+ * in the background.
+ *
+ * fitPlane() is the batch version for a handful of discrete points (probed
+ * contact positions): the same normal, offset and confidence from the
+ * unweighted mean and covariance, plus the residuals normal . x - offset.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/detail/ca_macro.h>
+
+using namespace barrett;
+
+struct PlaneFit {
+	Eigen::Vector3d normal;		// unit, towards the `outside` given to fitPlane()
+	double offset;				// plane: normal . x = offset
+	double confidence;			// as PlaneEstimator's
+	double rmsResidual, maxResidual;	// [m]
+	std::vector<double> residuals;		// [m] per point, signed
+
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+// False for fewer than 3 points (the fit is then left alone).
+template<typename Point>
+bool fitPlane(const std::vector<Point>& points, const Eigen::Vector3d& outside, double minSpread, PlaneFit& fit) {
+	const size_t n = points.size();
+	if (n < 3) {
+		return false;
+	}
+	Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+	for (size_t i = 0; i < n; ++i) {
+		mean += points[i];
+	}
+	mean /= n;
+	Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+	for (size_t i = 0; i < n; ++i) {
+		const Eigen::Vector3d e = points[i] - mean;
+		cov += e * e.transpose();
+	}
+	cov /= n;
+
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig;
+	eig.computeDirect(cov);	// eigenvalues in increasing order
+	const Eigen::Vector3d& l = eig.eigenvalues();
+	fit.normal = eig.eigenvectors().col(0);
+	if (fit.normal.dot(outside) < 0.0) {
+		fit.normal = -fit.normal;
+	}
+	fit.offset = fit.normal.dot(mean);
+	fit.confidence = (l[1] > 0.0) ?
+			std::max(0.0, 1.0 - l[0] / l[1]) * std::min(1.0, std::sqrt(l[1]) / minSpread) : 0.0;
+
+	fit.residuals.resize(n);
+	double sq = 0.0;
+	fit.maxResidual = 0.0;
+	for (size_t i = 0; i < n; ++i) {
+		fit.residuals[i] = fit.normal.dot(points[i]) - fit.offset;
+		sq += fit.residuals[i] * fit.residuals[i];
+		fit.maxResidual = std::max(fit.maxResidual, std::fabs(fit.residuals[i]));
+	}
+	fit.rmsResidual = std::sqrt(sq / n);
+	return true;
+}
+
+template<size_t DOF>
+class PlaneEstimator : public systems::System
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+// IO  (inputs)
+public:
+	Input<cp_type> cpInput;		// tool position
+	Input<cf_type> cfInput;		// estimated contact force
+
+// IO  (outputs)
+public:
+	Output<cp_type> normalOutput;		// unit normal, pointing out of the surface
+	Output<double> offsetOutput;		// plane: normal . x = offset
+	Output<double> confidenceOutput;
+
+protected:
+	typename Output<cp_type>::Value* normalOutputValue;
+	typename Output<double>::Value* offsetOutputValue;
+	typename Output<double>::Value* confidenceOutputValue;
+
+public:
+	// lambda: forgetting factor per accepted sample (1 = never forget).
+	explicit PlaneEstimator(double contactThreshold = 5.0, double lambda = 0.999, double minSpread = 0.02,
+			const std::string& sysName = "PlaneEstimator"):
+		System(sysName), cpInput(this), cfInput(this),
+		normalOutput(this, &normalOutputValue), offsetOutput(this, &offsetOutputValue), confidenceOutput(this, &confidenceOutputValue),
+		contactThreshold(contactThreshold), lambda(lambda), minSpread(minSpread) {
+		resetState();
+	}
+
+	virtual ~PlaneEstimator() { this->mandatoryCleanUp(); }
+
+	// Forget all samples. Safe to call while running.
+	void reset() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		resetState();
+	}
+
+	// Consistent snapshot of the current fit; false until the first fit.
+	bool getPlane(cp_type& normal_, double& offset_, double& confidence_) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		if (count < MIN_SAMPLES) {
+			return false;
+		}
+		normal_ = normal;
+		offset_ = offset;
+		confidence_ = confidence;
+		return true;
+	}
+
+	void setContactThreshold(double threshold) {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		contactThreshold = threshold;
+	}
+
+	double getConfidence() {
+		BARRETT_SCOPED_LOCK(this->getEmMutex());
+		return count < MIN_SAMPLES ? 0.0 : confidence;
+	}
+
+protected:
+	static const size_t MIN_SAMPLES = 10;
+
+	double contactThreshold, lambda, minSpread;
+
+	size_t count;
+	double w;
+	Eigen::Vector3d mean, e, f;
+	Eigen::Matrix3d cov;
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig;
+
+	cp_type normal;
+	double offset, confidence, sign;
+
+	void resetState() {
+		count = 0;
+		w = 0.0;
+		mean.setZero();
+		cov.setZero();
+		normal.setZero();
+		offset = 0.0;
+		confidence = 0.0;
+	}
+
+	virtual void operate() {
+		f = this->cfInput.getValue();
+		if (contactThreshold <= 0.0 || f.norm() > contactThreshold) {
+			e = this->cpInput.getValue() - mean;
+			w = lambda * w + 1.0;
+			const double a = 1.0 / w;
+			mean += a * e;
+			cov = (1.0 - a) * (cov + a * e * e.transpose());
+			++count;
+
+			if (count >= MIN_SAMPLES) {
+				eig.computeDirect(cov);	// eigenvalues in increasing order
+				const Eigen::Vector3d& l = eig.eigenvalues();
+				normal = eig.eigenvectors().col(0);
+				if (contactThreshold > 0.0) {
+					sign = (normal.dot(f) > 0.0) ? -1.0 : 1.0;	// the tool pushes into the surface
+				} else {
+					sign = (normal.dot(mean) > 0.0) ? -1.0 : 1.0;	// the base is on the free side
+				}
+				normal *= sign;
+				offset = normal.dot(mean);
+				confidence = (l[1] > 0.0) ?
+						std::max(0.0, 1.0 - l[0] / l[1]) * std::min(1.0, std::sqrt(l[1]) / minSpread) : 0.0;
+			}
+		}
+
+		if (count >= MIN_SAMPLES) {
+			normalOutputValue->setData(&normal);
+			offsetOutputValue->setData(&offset);
+			confidenceOutputValue->setData(&confidence);
+		} else {
+			normalOutputValue->setUndefined();
+			offsetOutputValue->setUndefined();
+			confidenceOutputValue->setUndefined();
+		}
+	}
+
+private:
+	DISALLOW_COPY_AND_ASSIGN(PlaneEstimator);
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
@@ -0,0 +1,247 @@
+/*
+ * time_optimal_scaling.h
+ *
+ * Time-optimal timing of a Cartesian waypoint path (TOPP), for
+ * TrajectoryStreamer::enqueue(pts, orns, dt).
+ *
+ * The path is parameterized by arc length s through the knots and mapped to
+ * joint space by damped least-squares IK from the arm's current
+ * configuration. With q' = dq/ds and q'' = d2q/ds2 from finite differences,
+ * the joint velocity and torque along the path are
+ *
+ *     qd  = q' sd
+ *     tau = M q' sdd + (M q'' + C(q, q') q') sd^2 + g
+ *
+ * Gravity is compensated by the WAM outside of jtSat, so only the first two
+ * terms count against the torque limit. In (s, u = sd^2) the constraints
+ * are linear in sdd for a given u. The usual two passes give the fastest
+ * profile: the backward pass from rest at the end limits each knot to the
+ * speed it can still stop from, and the forward pass from rest at the start
+ * accelerates as hard as allowed up to that curve.
+ *
+ * Limits: joint velocity, joint torque (both per joint) and tool speed (the
+ * safety module's velocity limit). The orientation is SLERPed over the same
+ * timing and isn't constrained. Run it in the service thread; compute()
+ * allocates and evaluates the kinematics and dynamics once per knot.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <eigen3/Eigen/Dense>
+#include <libconfig.h++>
+#include <barrett/units.h>
+#include <barrett/math/kinematics.h>
+
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/rnea_dynamics.h>
+
+using namespace barrett;
+
+template<size_t DOF>
+class TimeOptimalScaling
+{
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+public:
+	typedef typename RNEA<DOF>::joint_vector_type joint_vector_type;
+
+	static const int IK_ITERATIONS = 5;
+	static const double IK_TOLERANCE;	// [m] largest IK position error accepted
+	static const double IK_DAMPING;		// [m] damped least-squares lambda
+
+	// wamSetting is the WAM's group in the libbarrett config.
+	explicit TimeOptimalScaling(const libconfig::Setting& wamSetting) :
+		kin(wamSetting["kinematics"]), rnea(wamSetting), toolSpeedMax(0.5) {
+		jvMax.setConstant(1.0);
+		jtMax.setConstant(10.0);
+		view.bind(kin.impl);	// kin.eval() updates the same storage
+	}
+
+	void setLimits(const jv_type& jointVelocity, const jt_type& jointTorque, double toolSpeed) {
+		jvMax = jointVelocity;
+		jtMax = jointTorque;
+		toolSpeedMax = toolSpeed;
+	}
+
+	// dt[i] is the time from pts[i-1] (from start for i = 0) to pts[i], at
+	// rest at start and at the last point. jp is the configuration at start.
+	// Returns false if the IK doesn't follow the path (out of reach or
+	// through a singularity).
+	bool compute(const jp_type& jp, const cp_type& start, const std::vector<cp_type>& pts, std::vector<double>& dt) {
+		const size_t N = pts.size();
+		dt.assign(N, 0.0);
+		if (N == 0) {
+			return true;
+		}
+
+		// knots and arc length
+		p.resize(N + 1);
+		s.resize(N + 1);
+		p[0] = start;
+		s[0] = 0.0;
+		for (size_t i = 0; i < N; ++i) {
+			p[i + 1] = pts[i];
+			s[i + 1] = s[i] + std::max((pts[i] - p[i]).norm(), MIN_SEGMENT);
+		}
+
+		// joint path
+		q.resize(N + 1);
+		q[0] = jp;
+		for (size_t i = 1; i <= N; ++i) {
+			q[i] = q[i - 1];
+			if ( !solveIK(p[i], q[i])) {
+				return false;
+			}
+		}
+
+		// constraint coefficients at the knots
+		a.resize(N + 1);
+		b.resize(N + 1);
+		uMax.resize(N + 1);
+		for (size_t i = 0; i <= N; ++i) {
+			const size_t lo = i > 0 ? i - 1 : 0, hi = i < N ? i + 1 : N;
+			const joint_vector_type dq = (q[hi] - q[lo]) / (s[hi] - s[lo]);
+			const Eigen::Vector3d dp = (p[hi] - p[lo]) / (s[hi] - s[lo]);
+			joint_vector_type ddq = joint_vector_type::Zero();
+			if (i > 0 && i < N) {
+				const double h0 = s[i] - s[i - 1], h1 = s[i + 1] - s[i];
+				ddq = 2.0 * ((q[i + 1] - q[i]) / h1 - (q[i] - q[i - 1]) / h0) / (h0 + h1);
+			}
+
+			rnea.update(q[i]);
+			a[i] = rnea.inverseDynamics(joint_vector_type::Zero(), dq, false);	// M q'
+			b[i] = rnea.inverseDynamics(dq, ddq, false);						// M q'' + C(q, q') q'
+
+			double u = toolSpeedMax * toolSpeedMax / std::max(dp.squaredNorm(), 1e-12);
+			for (size_t j = 0; j < DOF; ++j) {
+				if (std::fabs(dq[j]) > 0.0) {
+					u = std::min(u, jvMax[j] * jvMax[j] / (dq[j] * dq[j]));
+				}
+			}
+			uMax[i] = maxFeasible(i, u);
+		}
+
+		// backward pass: the fastest each knot can go and still stop in time
+		uBack.resize(N + 1);
+		uBack[N] = 0.0;
+		for (size_t i = N; i-- > 0;) {
+			const double h = s[i + 1] - s[i];
+			double lo, hi;
+			if (acceleration(i, uMax[i], lo, hi) && uMax[i] + 2.0 * h * lo <= uBack[i + 1]) {
+				uBack[i] = uMax[i];
+				continue;
+			}
+			double below = 0.0, above = uMax[i];
+			for (int k = 0; k < BISECTIONS; ++k) {
+				const double mid = 0.5 * (below + above);
+				if (acceleration(i, mid, lo, hi) && mid + 2.0 * h * lo <= uBack[i + 1]) {
+					below = mid;
+				} else {
+					above = mid;
+				}
+			}
+			uBack[i] = below;
+		}
+
+		// forward pass from rest, then knot intervals
+		double u = 0.0;
+		for (size_t i = 0; i < N; ++i) {
+			const double h = s[i + 1] - s[i];
+			double lo, hi;
+			acceleration(i, u, lo, hi);
+			const double next = std::max(0.0, std::min(uBack[i + 1], u + 2.0 * h * hi));
+			const double v = std::sqrt(u) + std::sqrt(next);
+			if (v > 0.0) {
+				dt[i] = 2.0 * h / v;
+			} else {
+				// rest to rest within one segment: accelerate, then brake
+				const double sdd = std::min(hi, -lo);
+				dt[i] = std::isfinite(sdd) && sdd > 0.0 ? 2.0 * std::sqrt(h / sdd) : h / toolSpeedMax;
+			}
+			u = next;
+		}
+		return true;
+	}
+
+protected:
+	static const int BISECTIONS = 40;
+	static const double MIN_SEGMENT;	// [m] repeated knots still get a (short) interval
+
+	math::Kinematics<DOF> kin;
+	KinematicsView<DOF> view;
+	RNEA<DOF> rnea;
+
+	jv_type jvMax;
+	jt_type jtMax;
+	double toolSpeedMax;
+
+	std::vector<cp_type> p;
+	std::vector<double> s, uMax, uBack;
+	std::vector<joint_vector_type, Eigen::aligned_allocator<joint_vector_type> > q, a, b;
+
+	// Range [lo, hi] of sdd at knot i for u = sd^2 allowed by the torque
+	// limits; false if there is none.
+	bool acceleration(size_t i, double u, double& lo, double& hi) const {
+		lo = -INFINITY;
+		hi = INFINITY;
+		for (size_t j = 0; j < DOF; ++j) {
+			const double bu = b[i][j] * u;
+			if (std::fabs(a[i][j]) < 1e-9) {
+				if (std::fabs(bu) > jtMax[j]) {
+					return false;
+				}
+				continue;
+			}
+			double l = (-jtMax[j] - bu) / a[i][j], h = (jtMax[j] - bu) / a[i][j];
+			if (l > h) {
+				std::swap(l, h);
+			}
+			lo = std::max(lo, l);
+			hi = std::min(hi, h);
+		}
+		return lo <= hi;
+	}
+
+	// Largest u <= bound at knot i with some admissible sdd.
+	double maxFeasible(size_t i, double bound) const {
+		double lo, hi;
+		if (acceleration(i, bound, lo, hi)) {
+			return bound;
+		}
+		double below = 0.0, above = bound;
+		for (int k = 0; k < BISECTIONS; ++k) {
+			const double mid = 0.5 * (below + above);
+			if (acceleration(i, mid, lo, hi)) {
+				below = mid;
+			} else {
+				above = mid;
+			}
+		}
+		return below;
+	}
+
+	// Damped least-squares IK for the tool position, starting from qi.
+	bool solveIK(const cp_type& target, joint_vector_type& qi) {
+		for (int k = 0; k < IK_ITERATIONS; ++k) {
+			kin.eval(jp_type(qi), jv_type(0.0));
+			const Eigen::Vector3d e = target - view.position;
+			if (e.norm() < IK_TOLERANCE * 1e-2) {
+				return true;
+			}
+			const Eigen::Matrix<double, 3, DOF> Jv = view.Jv;
+			qi += Jv.transpose() * (Jv * Jv.transpose() + IK_DAMPING * IK_DAMPING * Eigen::Matrix3d::Identity()).ldlt().solve(e);
+		}
+		kin.eval(jp_type(qi), jv_type(0.0));
+		return (target - view.position).norm() < IK_TOLERANCE;
+	}
+
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+template<size_t DOF> const double TimeOptimalScaling<DOF>::IK_TOLERANCE = 1e-3;
+template<size_t DOF> const double TimeOptimalScaling<DOF>::IK_DAMPING = 1e-2;
+template<size_t DOF> const double TimeOptimalScaling<DOF>::MIN_SEGMENT = 1e-6;
@@ -0,0 +1,293 @@
+/*
+ * hybrid_contact_sim_benchmark.cpp
+ *
+ * Closed-loop benchmark of HybridForcePositionController on SimulatedWam
+ * against a compliant plane (contact_surface.h), without hardware or ROS:
+ *
+ *   hybrid_contact_sim_benchmark [config=/etc/barrett/default.conf] [group=wam7] [seconds=16] [tilt=0.17]
+ *
+ * The plane lies 1 cm under the tool's start position, tilted by tilt [rad]
+ * about the base x axis. The graph is the one planar_surface_hybrid_control
+ * builds: the normal force is regulated on the MomentumObserver estimate,
+ * TrajectoryStreamer slides the setpoint SLIDE_DISTANCE along the plane and
+ * back on Bezier curves, and a 7-DOF arm holds its posture in the null
+ * space. StaticForceEstimatorwithG runs alongside for comparison. The
+ * execution graph is stepped by a ManualExecutionManager as fast as it
+ * evaluates.
+ *
+ * Prints the normal force against the desired one, the error of both force
+ * estimates against ContactSurface::forceOutput, the tangential tracking
+ * error and the operate() timing of the controller's systems; exits non-zero
+ * if the tool never reached the plane or lost it once settled.
+ */
+
+
+#include <wam_control_common/rnea_dynamics.h>
+#include <wam_control_common/kinematics_bundle.h>
+#include <wam_control_common/simulated_wam.h>
+#include <wam_control_common/contact_surface.h>
+#include <wam_control_common/static_force_estimator_withg.h>
+#include <wam_control_common/momentum_observer.h>
+#include <wam_control_common/trajectory_streamer.h>
+#include <wam_control_common/operate_timing.h>
+#include "planar_surface_hybrid_control/hybrid_force_position_controller.h"
+#include "planar_surface_hybrid_control/operational_space_dynamics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <libconfig.h++>
+#include <boost/bind.hpp>
+#include <barrett/os.h>
+#include <barrett/units.h>
+#include <barrett/systems.h>
+#include <barrett/math/kinematics.h>
+
+using namespace barrett;
+
+static const double T_S = 0.002;				// [s] control period, as on the WAM
+static const double FORCE_DES = 3.0;			// [N] into the plane, as planar_surface_hybrid_control
+static const double SLIDE_START = 2.0;			// [s] time to make and settle the contact first
+static const double SLIDE_DISTANCE = 0.1;		// [m] along the plane and back
+static const double SLIDE_SPEED = 0.03;			// [m/s] peak, SPEED of planar_surface_hybrid_control
+static const double MOMENTUM_OBSERVER_GAIN = 150.0;	// [1/s]
+static const double NULL_SPACE_STIFFNESS = 10.0;	// [Nm/rad]
+static const double NULL_SPACE_DAMPING = 1.0;		// [Nm s/rad]
+
+// Scales x down uniformly until every joint is within limit
+template<size_t DOF>
+typename units::JointTorques<DOF>::type saturate(const typename units::JointTorques<DOF>::type& x,
+		const typename units::JointTorques<DOF>::type& limit) {
+	const double ratio = limit.cwiseQuotient(x.cwiseAbs()).minCoeff();
+	return ratio < 1.0 ? typename units::JointTorques<DOF>::type(ratio * x) : x;
+}
+
+template<size_t DOF>
+int run(const libconfig::Setting& wamSetting, double duration, double tilt) {
+	BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
+
+	systems::ManualExecutionManager mem(T_S);
+
+	//Elbow bent, tool in front of the arm
+	jp_type startPose(0.0);
+	startPose.template head<4>() << 0.0, 0.6, 0.0, 2.0;
+	SimulatedWam<DOF> wam(wamSetting, startPose, &mem);
+	wam.gravityCompensate();
+
+	math::Kinematics<DOF> kin(wamSetting["kinematics"]);
+	KinematicsView<DOF> view;
+	view.bind(kin.impl);
+	kin.eval(startPose, jv_type(0.0));
+	const cp_type startCp(view.position);
+	const Eigen::Quaterniond startOrn(Eigen::Matrix3d(view.R));
+
+	//The plane, tilted about x so that x stays in it
+	const cp_type normal(0.0, -std::sin(tilt), std::cos(tilt));
+	const cp_type along(1.0, 0.0, 0.0);
+	Timed<KinematicsBundle<DOF> > kinematics;
+	Timed<ContactSurface<DOF> > surface;
+	surface.addPatch(new PlanePatch(startCp - 0.01 * normal, normal, ContactMaterial()));
+	systems::connect(wam.kinematicsBase.kinOutput, kinematics.kinInput);
+	systems::connect(kinematics.output, surface.kinematicsInput);
+	systems::connect(surface.jtOutput, wam.sink.externalTorqueInput);
+
+	//Impedance gains of the surface replay; a 4-DOF arm can't hold the tool orientation
+	const cp_type KpApplied(1200.0), KdApplied(30.0);
+	const cp_type OrnKpApplied(DOF > 6 ? 5.5 : 0.0), OrnKdApplied(DOF > 6 ? 0.055 : 0.0);
+	systems::Constant<cp_type> KxSet(KpApplied), DxSet(KdApplied), OrnKxSet(OrnKpApplied), OrnDxSet(OrnKdApplied);
+	systems::Constant<cp_type> SurfaceNormalSet(normal);
+	systems::Constant<cf_type> ForceDesSet(cf_type(-FORCE_DES * normal));
+
+	GraphTimer graphTimer;
+	Timed<systems::HybridForcePositionController<DOF> > ImpControl;
+	Timed<TrajectoryStreamer<DOF> > refStreamer(2);
+	Timed<RNEADynamics<DOF> > dynamics(wamSetting);
+	Timed<MomentumObserver<DOF> > momentumObserver((v_type(MOMENTUM_OBSERVER_GAIN)));
+	Timed<StaticForceEstimatorwithG<DOF> > staticForceEstimator;
+	Timed<OperationalSpaceDynamics<DOF> > osDynamics;
+	Timed<NullSpacePosture<DOF> > nullSpacePosture((jv_type(NULL_SPACE_STIFFNESS)), jv_type(NULL_SPACE_DAMPING));
+	systems::ToolForceToJointTorques<DOF> toolforce2jt;
+	systems::ToolTorqueToJointTorques<DOF> tt2jt;
+	systems::Summer<jt_type, 3> torqueSum;	// force, orientation torque, null-space posture
+
+	jt_type jtLimits(20.0);
+	systems::Callback<jt_type> jtSat(boost::bind(saturate<DOF>, _1, jtLimits));
+
+	refStreamer.hold(startCp, startOrn);
+	systems::connect(KxSet.output, ImpControl.KxInput);
+	systems::connect(DxSet.output, ImpControl.DxInput);
+	systems::connect(refStreamer.positionOutput, ImpControl.XdInput);
+	systems::connect(refStreamer.velocityOutput, ImpControl.XdDotInput);
+	systems::connect(OrnKxSet.output, ImpControl.OrnKpGains);
+	systems::connect(OrnDxSet.output, ImpControl.OrnKdGains);
+	systems::connect(refStreamer.orientationOutput, ImpControl.OrnReferenceInput);
+	systems::connect(wam.toolPosition.output, ImpControl.CpInput);
+	systems::connect(wam.toolVelocity.output, ImpControl.CvInput);
+	systems::connect(wam.toolOrientation.output, ImpControl.OrnInput);
+	systems::connect(wam.kinematicsBase.kinOutput, ImpControl.kinInput);
+	systems::connect(SurfaceNormalSet.output, ImpControl.SurfaceNormalInput);
+	systems::connect(ForceDesSet.output, ImpControl.ForceDesInput);
+
+	systems::connect(wam.jpOutput, dynamics.jpInputDynamics);
+	systems::connect(wam.jvOutput, dynamics.jvInputDynamics);
+	systems::connect(wam.jvOutput, momentumObserver.jvInput);
+	systems::connect(wam.jtSum.output, momentumObserver.jtInput);
+	systems::connect(dynamics.MassMAtrixOutput, momentumObserver.M);
+	systems::connect(dynamics.CVectorOutput, momentumObserver.C);
+	systems::connect(kinematics.output, momentumObserver.kinematicsInput);
+	systems::connect(wam.gravity.output, momentumObserver.g);
+	systems::connect(momentumObserver.cartesianForceOutput, ImpControl.ForceInput);
+
+	systems::connect(wam.jtSum.output, staticForceEstimator.jtInput);
+	systems::connect(kinematics.output, staticForceEstimator.kinematicsInput);
+	systems::connect(wam.gravity.output, staticForceEstimator.g);
+
+	systems::connect(dynamics.MassMAtrixOutput, osDynamics.massMatrixInput);
+	systems::connect(kinematics.output, osDynamics.kinematicsInput);
+	systems::connect(wam.jpOutput, nullSpacePosture.jpInput);
+	systems::connect(wam.jvOutput, nullSpacePosture.jvInput);
+	systems::connect(osDynamics.nullSpaceProjectorOutput, nullSpacePosture.nullSpaceProjectorInput);
+
+	systems::connect(wam.kinematicsBase.kinOutput, toolforce2jt.kinInput);
+	systems::connect(wam.kinematicsBase.kinOutput, tt2jt.kinInput);
+	systems::connect(ImpControl.CFOutput, toolforce2jt.input);
+	systems::connect(ImpControl.CTOutput, tt2jt.input);
+	systems::connect(toolforce2jt.output, torqueSum.getInput(0));
+	systems::connect(tt2jt.output, torqueSum.getInput(1));
+	systems::connect(nullSpacePosture.jtOutput, torqueSum.getInput(2));
+	systems::connect(torqueSum.output, jtSat.input);
+	wam.trackReferenceSignal(jtSat.output);
+
+	mem.startManaging(momentumObserver);	// integrates, has to run every tick
+	mem.startManaging(staticForceEstimator);
+	mem.startManaging(graphTimer);
+	graphTimer.track(kinematics);
+	graphTimer.track(ImpControl);
+	graphTimer.track(refStreamer);
+	graphTimer.track(dynamics);
+	graphTimer.track(momentumObserver);
+	graphTimer.track(staticForceEstimator);
+	graphTimer.track(osDynamics);
+	graphTimer.track(nullSpacePosture);
+	graphTimer.track(surface);
+
+	if (DOF > 6) {
+		nullSpacePosture.enable(startPose);
+	}
+	ImpControl.setForceControl(true);
+
+	//Down onto the plane, then along it and back once the contact has settled
+	const size_t ticks = static_cast<size_t>(duration / T_S);
+	const size_t slideTick = static_cast<size_t>(SLIDE_START / T_S);
+	int leg = 0;
+	size_t firstContact = ticks, lostTicks = 0, measuredTicks = 0;
+	double sumNormalForce = 0.0, sumSquaredForceError = 0.0, peakForceError = 0.0;
+	double sumSquaredObserverError = 0.0, sumSquaredStaticError = 0.0;
+	double sumSquaredTrackingError = 0.0, peakTrackingError = 0.0;
+	const double start = highResolutionSystemTime();
+	for (size_t i = 0; i < ticks; ++i) {
+		if (i >= slideTick && leg < 2 && refStreamer.isDone()) {
+			const cp_type from = refStreamer.currentPosition();
+			const cp_type to = leg == 0 ? cp_type(startCp + SLIDE_DISTANCE * along) : startCp;
+			refStreamer.enqueue(CubicBezier::between(from, to, 0.0), startOrn, SLIDE_SPEED);
+			++leg;
+		}
+
+		mem.runExecutionCycle();
+
+		const bool contact = surface.inContact();
+		if (contact && firstContact == ticks) {
+			firstContact = i;
+		}
+		if (i < slideTick || firstContact == ticks) {
+			continue;
+		}
+		if ( !contact ) {
+			++lostTicks;
+			continue;
+		}
+
+		//Estimates are of the force the tool applies, forceOutput of the one it gets
+		const cf_type force = surface.getForce();
+		const double fn = normal.dot(force);
+		const double forceError = std::fabs(fn - FORCE_DES);
+		sumNormalForce += fn;
+		sumSquaredForceError += forceError * forceError;
+		peakForceError = std::max(peakForceError, forceError);
+		sumSquaredObserverError += (momentumObserver.computedF + force).squaredNorm();
+		sumSquaredStaticError += (staticForceEstimator.computedF + force).squaredNorm();
+
+		const cp_type e = ImpControl.XdInput.getValue() - ImpControl.cart_pos;
+		const double tangential = (e - normal.dot(e) * normal).norm();
+		sumSquaredTrackingError += tangential * tangential;
+		peakTrackingError = std::max(peakTrackingError, tangential);
+		++measuredTicks;
+	}
+	const double wall = highResolutionSystemTime() - start;
+
+	printf("%zu-DOF, %zu ticks of %.0f us, plane tilted %.3f rad\n", DOF, ticks, T_S * 1e6, tilt);
+	printf("simulated %.2f s in %.3f s wall (%.1fx real time)\n", ticks * T_S, wall, ticks * T_S / wall);
+	if (firstContact == ticks) {
+		printf("the tool never reached the plane\n");
+	} else {
+		printf("contact after %.3f s, lost for %zu tick(s) after %.1f s\n", firstContact * T_S, lostTicks, SLIDE_START);
+	}
+	if (measuredTicks > 0) {
+		printf("normal force mean %.2f N (desired %.2f N), error RMS %.3f N, peak %.3f N\n",
+				sumNormalForce / measuredTicks, FORCE_DES, std::sqrt(sumSquaredForceError / measuredTicks), peakForceError);
+		printf("force estimate error RMS: momentum observer %.3f N, static %.3f N\n",
+				std::sqrt(sumSquaredObserverError / measuredTicks), std::sqrt(sumSquaredStaticError / measuredTicks));
+		printf("tangential tracking error RMS %.5f m, peak %.5f m\n",
+				std::sqrt(sumSquaredTrackingError / measuredTicks), peakTrackingError);
+	}
+	printf("\n%s", graphTimer.report().c_str());
+
+	wam.idle();
+	return (firstContact < ticks && lostTicks == 0) ? 0 : 1;
+}
+
+static bool readConfig(libconfig::Config& config, const char* path) {
+	try {
+		const std::string p(path);
+		const size_t slash = p.find_last_of('/');
+		if (slash != std::string::npos) {
+			config.setIncludeDir(p.substr(0, slash).c_str());	// default.conf @includes the per-arm files
+		}
+		config.readFile(path);
+	} catch (const libconfig::FileIOException&) {
+		printf("Couldn't read %s\n", path);
+		return false;
+	} catch (const libconfig::ParseException& e) {
+		printf("%s:%d: %s\n", e.getFile(), e.getLine(), e.getError());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	const char* configPath = argc > 1 ? argv[1] : "/etc/barrett/default.conf";
+	const char* group = argc > 2 ? argv[2] : "wam7";
+	const double duration = argc > 3 ? atof(argv[3]) : 16.0;
+	const double tilt = argc > 4 ? atof(argv[4]) : 0.17;
+
+	libconfig::Config config;
+	if ( !readConfig(config, configPath)) {
+		return 2;
+	}
+	if ( !config.exists(group)) {
+		printf("%s has no group \"%s\"\n", configPath, group);
+		return 2;
+	}
+
+	const libconfig::Setting& wamSetting = config.lookup(group);
+	switch (wamSetting["kinematics"]["moving"].getLength()) {
+	case 4:
+		return run<4>(wamSetting, duration, tilt);
+	case 7:
+		return run<7>(wamSetting, duration, tilt);
+	default:
+		printf("Group \"%s\" is neither a 4-DOF nor a 7-DOF WAM\n", group);
+		return 2;
+	}
+}
@@ -17,12 +17,13 @@ void PlanarHybridControl<DOF>::init(ProductManager& pm){
     locked_joints = false;
     systems_connected = false;
     force_estimated = false;
+    surface_calibrated = false;
   
-    outputFile.open("home/output.txt");
     ROS_INFO("%zu-DOF WAM", DOF);
     jp_home = wam.getJointPositions();
     wam.gravityCompensate(true); // gravity compensation default set to true
-    pm.getSafetyModule()->setVelocityLimit(1.5);
+    pm.getSafetyModule()->setVelocityLimit(VELOCITY_LIMIT);
+    timeScaling.setLimits(jv_type(JOINT_VELOCITY_LIMIT), jtLimits * REPLAY_TORQUE_MARGIN, VELOCITY_LIMIT * REPLAY_VELOCITY_MARGIN);
 
     // setting up WAM joint state publisher
     const char* wam_jnts[] = {  
@@ -48,6 +49,10 @@ void PlanarHybridControl<DOF>::init(ProductManager& pm){
     collect_cp_trajectory_srv = n_.advertiseService("collect_cp_trajectory", &PlanarHybridControl<DOF>::collectCpTrajectory, this);
     planar_surface_hybrid_control_srv = n_.advertiseService("planar_surface_hybrid_control", &PlanarHybridControl<DOF>::SPFCartImpCOntroller, this);
     disconnect_systems_srv = n_.advertiseService("disconnect_systems", &PlanarHybridControl::disconnectSystems, this);
+    operate_timing_srv = n_.advertiseService("operate_timing", &PlanarHybridControl::operateTimingCallback, this);
+    reset_operate_timing_srv = n_.advertiseService("reset_operate_timing", &PlanarHybridControl::resetOperateTimingCallback, this);
+    guarded_move_srv = n_.advertiseService("guarded_move", &PlanarHybridControl::guardedMoveCallback, this);
+    probe_surface_srv = n_.advertiseService("probe_surface", &PlanarHybridControl<DOF>::probeSurface, this);
     //grid_test_calib_srv = n_.advertiseService("grid_test_calib", &PlanarHybridControl::grid_test_calibration, this);
     //grid_test_srv = n_.advertiseService("grid_test", &PlanarHybridControl::grid_test, this);
 
@@ -56,7 +61,12 @@ void PlanarHybridControl<DOF>::init(ProductManager& pm){
     wam_pose_pub = n_.advertise < geometry_msgs::PoseStamped > ("pose", 1);
     wam_jacobian_mn_pub = n_.advertise < wam_msgs::MatrixMN > ("jacobian",1);
     wam_tool_pub = n_.advertise < wam_msgs::RTToolInfo > ("tool_info",1);
-    wam_estimated_contact_force_pub = n_.advertise < wam_msgs::RTCartForce > ("static_estimated_force",1);
+    wam_estimated_contact_force_pub = n_.advertise < wam_msgs::RTCartForce > ("estimated_force",1);
+    contact_event_pub = n_.advertise < wam_spf_control::ContactEvent > ("contact_events", 10);
+    operate_timing_pub = n_.advertise < std_msgs::String > ("operate_timing", 1);
+    operate_timing_timer = n_.createTimer(ros::Duration(OPERATE_TIMING_PERIOD), &PlanarHybridControl::publishOperateTiming, this);
+    surface_plane_pub = n_.advertise < wam_spf_control::SurfacePlane > ("surface_plane", 1);
+    surface_plane_timer = n_.createTimer(ros::Duration(PLANE_PUBLISH_PERIOD), &PlanarHybridControl::publishSurfacePlane, this);
 
     
     // ROS subscribers
@@ -64,11 +74,12 @@ void PlanarHybridControl<DOF>::init(ProductManager& pm){
     // CONNECT SPRING SYSTEM //TODO: check if its okay to connect here.
     systems::forceConnect(KxSet.output, ImpControl.KxInput);
     systems::forceConnect(DxSet.output, ImpControl.DxInput);
-    systems::forceConnect(XdSet.output, ImpControl.XdInput);
+    systems::forceConnect(refStreamer.positionOutput, ImpControl.XdInput);
+    systems::forceConnect(refStreamer.velocityOutput, ImpControl.XdDotInput);
 
     systems::forceConnect(OrnKxSet.output, ImpControl.OrnKpGains);
     systems::forceConnect(OrnDxSet.output, ImpControl.OrnKdGains);
-    systems::forceConnect(OrnXdSet.output, ImpControl.OrnReferenceInput);
+    systems::forceConnect(refStreamer.orientationOutput, ImpControl.OrnReferenceInput);
     
     systems::forceConnect(wam.toolPosition.output, ImpControl.CpInput);
     systems::forceConnect(wam.toolVelocity.output, ImpControl.CvInput);
@@ -78,95 +89,116 @@ void PlanarHybridControl<DOF>::init(ProductManager& pm){
     systems::forceConnect(wam.kinematicsBase.kinOutput, toolforce2jt.kinInput);
     systems::forceConnect(wam.kinematicsBase.kinOutput, tt2jt_ortn_split.kinInput); 
 
+    SurfaceNormalSet.setValue(cp_type(0.0, 0.0, 1.0));
+    ForceDesSet.setValue(cf_type(0.0));
+    systems::forceConnect(SurfaceNormalSet.output, ImpControl.SurfaceNormalInput);
+    systems::forceConnect(ForceDesSet.output, ImpControl.ForceDesInput);
+
     systems::forceConnect(ImpControl.CFOutput, toolforce2jt.input);
     systems::forceConnect(ImpControl.CTOutput, tt2jt_ortn_split.input);
-    systems::forceConnect(FeedFwdForce.output, toolforcefeedfwd2jt.input);
 
     //Connect Force Estimation systems //TODO: Check the force topic.
-    systems::connect(wam.kinematicsBase.kinOutput, getWAMJacobian.kinInput);
-    systems::connect(getWAMJacobian.output, staticForceEstimator.Jacobian);
-
+    systems::connect(wam.kinematicsBase.kinOutput, kinematics.kinInput);
     systems::connect(wam.kinematicsBase.kinOutput, gravityTerm.kinInput);
-    systems::connect(gravityTerm.output, staticForceEstimator.g);
-
-    systems::connect(wam.jtSum.output, staticForceEstimator.jtInput);
-    systems::connect(staticForceEstimator.cartesianForceOutput, print.input);
 
+    // One coherent state sample per tick for publishWam
+    systems::connect(wam.jpOutput, stateSnapshot.jpInput);
+    systems::connect(wam.jvOutput, stateSnapshot.jvInput);
+    systems::connect(wam.jtSum.output, stateSnapshot.jtInput);
+    systems::connect(wam.toolOrientation.output, stateSnapshot.ornInput);
+    systems::connect(kinematics.output, stateSnapshot.kinematicsInput);
+
+    // Null-space posture torque, the third input of the impedance torque sum
+    systems::connect(wam.jpOutput, dynamics.jpInputDynamics);
+    systems::connect(wam.jvOutput, dynamics.jvInputDynamics);
+
+    // The one contact force estimate, for the hybrid controller and everything
+    // below: a static J^T+ (jtSum - g) estimate is the controller's own command
+    // read back, so it would see tracking effort as contact and vice versa
+    systems::connect(wam.jvOutput, momentumObserver.jvInput);
+    systems::connect(wam.jtSum.output, momentumObserver.jtInput);
+    systems::connect(dynamics.MassMAtrixOutput, momentumObserver.M);
+    systems::connect(dynamics.CVectorOutput, momentumObserver.C);
+    systems::connect(kinematics.output, momentumObserver.kinematicsInput);
+    systems::connect(gravityTerm.output, momentumObserver.g);
+    systems::connect(momentumObserver.cartesianForceOutput, ImpControl.ForceInput);
+    pm.getExecutionManager()->startManaging(momentumObserver);
+    systems::connect(momentumObserver.cartesianForceOutput, forceTrace.input);
+
+    // Background surface fit, fed whenever the observer's contact force is above its threshold
+    systems::connect(wam.toolPosition.output, planeEstimator.cpInput);
+    systems::connect(momentumObserver.cartesianForceOutput, planeEstimator.cfInput);
+    pm.getExecutionManager()->startManaging(planeEstimator);
+
+    // Contact make/break at the control rate, published by publishWam, on the
+    // force the controller acts on; the snapshot publishes that same force
+    systems::connect(momentumObserver.cartesianForceOutput, contactDetector.cfInput);
+    pm.getExecutionManager()->startManaging(contactDetector);
+    systems::connect(momentumObserver.cartesianForceOutput, stateSnapshot.cfInput);
+    pm.getExecutionManager()->startManaging(stateSnapshot);
+
+    // Guarded moves watch the observer's estimate on the tick they step the setpoint
+    systems::connect(wam.toolPosition.output, guardedMove.cpInput);
+    systems::connect(momentumObserver.cartesianForceOutput, guardedMove.cfInput);
+    pm.getExecutionManager()->startManaging(guardedMove);
+
+    systems::connect(dynamics.MassMAtrixOutput, osDynamics.massMatrixInput);
+    systems::connect(kinematics.output, osDynamics.kinematicsInput);
+    systems::connect(wam.jpOutput, nullSpacePosture.jpInput);
+    systems::connect(wam.jvOutput, nullSpacePosture.jvInput);
+    systems::connect(osDynamics.nullSpaceProjectorOutput, nullSpacePosture.nullSpaceProjectorInput);
+    systems::connect(nullSpacePosture.jtOutput, torqueSum.getInput(2));
+
+    // Per-tick operate() durations of our systems, see operate_timing.h
+    pm.getExecutionManager()->startManaging(graphTimer);
+    graphTimer.track(kinematics);
+    graphTimer.track(momentumObserver);
+    graphTimer.track(ImpControl);
+    graphTimer.track(refStreamer);
+    graphTimer.track(planeEstimator);
+    graphTimer.track(stateSnapshot);
+    graphTimer.track(dynamics);
+    graphTimer.track(osDynamics);
+    graphTimer.track(nullSpacePosture);
+    graphTimer.track(forceTrace);
+    graphTimer.track(contactDetector);
+    graphTimer.track(guardedMove);
 
     ROS_INFO("WAM services now advertised");
     ros::AsyncSpinner spinner(0);
     spinner.start();
 }
 
-// Templated Surface Calibration Function
+// Surface calibration from the background plane fit: planeEstimator runs all the
+// time on the observer's force, so force-controlled replays, guarded moves and
+// probe_surface all refine it and nobody has to guide the arm. This adopts the
+// current fit and, with a path, writes it to .data/<path>.
 template<size_t DOF>
 bool PlanarHybridControl<DOF>::calibration(wam_srvs::Teach::Request &req, wam_srvs::Teach::Response &res){   
-    systems::Ramp time(mypm->getExecutionManager());
-    systems::TupleGrouper<double, cp_type, jp_type> configLogTg;
-    const double T_s = mypm->getExecutionManager()->getPeriod();
-
-    char tmpFile[] = "/tmp/btXXXXXX";
-	if (mkstemp(tmpFile) == -1) {
-		printf("ERROR: Couldn't create temporary file!\n");
-		return false;
-	}
-
-    std::string path = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path;
-
-
-    // Record at 1/10th of the loop rate
-    systems::PeriodicDataLogger<config_sample_type> configLogger(
-        mypm->getExecutionManager(),
-        new barrett::log::RealTimeWriter<config_sample_type>(tmpFile, 10*T_s),
-        10);
-
-    std::cout<< "Move the robot to the first contact point and Press [Enter]."<<std::endl;
-    waitForEnter();
-    v1 = wam.getToolPosition();
-
-    {   
-        // Make sure the Systems are connected on the same execution cycle
-        // that the time is started. Otherwise we might record a bunch of
-        // samples all having t=0; this is bad because the Spline requires time
-        // to be monotonic.
-        BARRETT_SCOPED_LOCK(mypm->getExecutionManager()->getMutex());
-        connect(time.output, configLogTg.template getInput<0>());
-        connect(wam.toolPosition.output, configLogTg.template getInput<1>());
-        connect(wam.jpOutput, configLogTg.template getInput<2>());
-        connect(configLogTg.output, configLogger.input);
-        time.start();
-    }
-
-    std::cout<< "Move the robot on the surface in a line and Press [Enter]."<<std::endl;
-    waitForEnter();
-    v2 = wam.getToolPosition();
-
-    std::cout<< "Move the robot on the surface in a line perpendicular to the previous line and Press [Enter]."<<std::endl;
-    waitForEnter();
-    v3 = wam.getToolPosition();
-
-    configLogger.closeLog();
-    disconnect(configLogger.input);
-
-    std::ofstream outputFile(path);
-
-    if (!outputFile.is_open()) {
-        printf("ERROR: Couldn't create the file!\n");
+    cp_type normal;
+    double offset, confidence;
+    if (!planeEstimator.getPlane(normal, offset, confidence) || confidence < PLANE_MIN_CONFIDENCE) {
+        ROS_ERROR("Calibration failed: the running surface fit is not confident yet (%.2f). "
+                  "Probe the surface or slide on it under force control first.", planeEstimator.getConfidence());
         return false;
     }
-    log::Reader<config_sample_type> lr(tmpFile);
-	lr.exportCSV(outputFile);
-    std::remove(tmpFile);
-    outputFile.close();
-
-    surface_normal = ((v2-v1).cross(v3-v2));
-    surface_normal.normalize();
-    std::cout<<"Surface normal: "<< surface_normal << std::endl;   
-    
-    ROS_INFO_STREAM("Calibration finished. Press [Enter] to go home.");
-    waitForEnter();
-    goHome();
-
+    surface_normal = normal;
+    surface_calibrated = true;
+    std::cout<<"Surface normal: "<< surface_normal << ", offset: " << offset << ", confidence: " << confidence << std::endl;
+
+    if (!req.path.empty()) {
+        std::string path = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path;
+        FILE* f = fopen(path.c_str(), "w");
+        if (f == NULL) {
+            ROS_ERROR_STREAM("Couldn't create " << path);
+        } else {
+            fprintf(f, "# normal_x, normal_y, normal_z, offset, confidence\n");
+            fprintf(f, "%.9g,%.9g,%.9g,%.9g,%.6g\n", normal[0], normal[1], normal[2], offset, confidence);
+            if (fclose(f) != 0) {
+                ROS_ERROR_STREAM("Couldn't write " << path);
+            }
+        }
+    }
     return true;
 }
 
@@ -179,24 +211,21 @@ bool PlanarHybridControl<DOF>::collectCpTrajectory(wam_srvs::Teach::Request &req
     // Setup
     systems::Ramp time(mypm->getExecutionManager());
     systems::TupleGrouper<double, cp_type> cpLogTg;
-    const double T_s = mypm->getExecutionManager()->getPeriod();
-
-    // Create a temporary file for data storage
-    char tmpFile[] = "/tmp/btXXXXXX";
-    if (mkstemp(tmpFile) == -1) {
-        perror("ERROR: Couldn't create temporary file!");
-        return false;
-    }
 
     // Set the file path for saving the trajectory data
     std::string path = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path;
-    ROS_INFO_STREAM("Collecting cartesian trajectory. Saving to: " << path);
-
-    // Record at 1/10th of the loop rate
-    systems::PeriodicDataLogger<cp_sample_type> cpLogger(
-        mypm->getExecutionManager(),
-        new barrett::log::RealTimeWriter<cp_sample_type>(tmpFile, 10 * T_s),
-        10);
+    ROS_INFO_STREAM("Collecting cartesian trajectory. Saving to: " << path << ".trj");
+
+    // Record every tick straight into the binary file SPFCartImpCOntroller replays
+    const char* cp_columns[] = {"t", "cp"};
+    Timed<ColumnarLogger<cp_sample_type> > cpLogger(
+        mypm->getExecutionManager(), path + ".trj",
+        std::vector<std::string>(cp_columns, cp_columns + 2), 1, "CpLogger");
+    if (!cpLogger.isLogging()) {
+        ROS_ERROR_STREAM("Couldn't create " << path << ".trj");
+        return false;
+    }
+    graphTimer.track(cpLogger);
 
     // Prompt to start collecting
     printf("Press [Enter] to start collecting.\n");
@@ -216,18 +245,12 @@ bool PlanarHybridControl<DOF>::collectCpTrajectory(wam_srvs::Teach::Request &req
     printf("Press [Enter] to stop collecting.\n");
     waitForEnter();
 
-    // Finish data logging
-    cpLogger.closeLog();
+    // Finish data logging; this only waits for the writer to catch up
     disconnect(cpLogger.input);
-
-    // Create and write trajectory data to the output file
-    std::ofstream outputFile(path);
-    log::Reader<cp_sample_type> lr(tmpFile);
-    lr.exportCSV(outputFile);
-
-    // Cleanup: Remove temporary file and close the output file
-    std::remove(tmpFile);
-    outputFile.close();
+    cpLogger.closeLog();
+    if (cpLogger.droppedRecords() > 0) {
+        ROS_WARN_STREAM("Dropped " << cpLogger.droppedRecords() << " trajectory samples");
+    }
 
     // Finish the process
     ROS_INFO_STREAM("Collecting done. Press [Enter] to go home.");
@@ -239,6 +262,129 @@ bool PlanarHybridControl<DOF>::collectCpTrajectory(wam_srvs::Teach::Request &req
 
 
 
+// Surface calibration without an operator: guarded approaches on a rows x cols grid
+// over a rectangle, visited back to back (serpentine, backing off by the clearance
+// between points), and a plane fitted to the contact positions. The transits to the
+// grid points are guarded moves too; contact on the way ends the probe. The guard
+// runs on the momentum observer, and a contact only counts if the force rise points
+// along the approach, i.e. the tool is pushing into something ahead of it.
+template<size_t DOF>
+bool PlanarHybridControl<DOF>::probeSurface(wam_spf_control::ProbeSurface::Request &req, wam_spf_control::ProbeSurface::Response &res)
+{
+    res.success = false;
+    res.contacts = 0;
+    cp_type center(req.center[0], req.center[1], req.center[2]);
+    cp_type approach(req.approach[0], req.approach[1], req.approach[2]);
+    cp_type row_axis(req.row_axis[0], req.row_axis[1], req.row_axis[2]);
+    if (approach.norm() == 0.0) {
+        res.message = "approach must be nonzero";
+        return true;
+    }
+    approach.normalize();
+    row_axis -= row_axis.dot(approach) * approach;
+    if (row_axis.norm() < 1e-6 || req.rows < 2 || req.cols < 2 || req.clearance <= 0.0) {
+        // a single row or column of points is collinear and never defines a plane
+        res.message = "need a row_axis not along approach, rows >= 2, cols >= 2 and a positive clearance";
+        return true;
+    }
+    row_axis.normalize();
+    cp_type col_axis = approach.cross(row_axis);
+
+    std::vector<cp_type> starts;
+    for (size_t r = 0; r < req.rows; ++r) {
+        for (size_t k = 0; k < req.cols; ++k) {
+            const size_t c = (r % 2 == 0) ? k : req.cols - 1 - k;
+            const double a = (req.cols > 1) ? double(c) / (req.cols - 1) - 0.5 : 0.0;
+            const double b = (req.rows > 1) ? double(r) / (req.rows - 1) - 0.5 : 0.0;
+            starts.push_back(center + a * req.length * row_axis + b * req.width * col_axis);
+        }
+    }
+    ROS_INFO("Probing the surface at %zu points.", starts.size());
+
+    const ros::WallTime begin = ros::WallTime::now();
+    std::vector<cp_type> contacts;
+    std::vector<cf_type> forces;
+    typename GuardedMove<DOF>::Result result;
+    for (size_t i = 0; i < starts.size(); ++i) {
+        const cp_type transit = starts[i] - wam.getToolPosition();
+        if (transit.norm() > PROBE_TRANSIT_MIN_DISTANCE) {
+            if (!runGuardedMove(transit, PROBE_TRANSIT_SPEED, transit.norm(), req.force_threshold, true, req.clearance, result)) {
+                res.message = "guarded transit failed";
+                return true;
+            }
+            if (result.contact) {
+                ROS_WARN("Probe: contact on the way to point %zu, (%.3f, %.3f, %.3f).", i, result.position[0], result.position[1], result.position[2]);
+                res.message = "unexpected contact on the way to a grid point";
+                return true;
+            }
+        }
+
+        if (!runGuardedMove(approach, req.speed, req.max_distance, req.force_threshold, true, req.clearance, result)) {
+            res.message = "guarded move failed";
+            return true;
+        }
+        if (result.contact && result.forceRise.dot(approach) < PROBE_MIN_ALIGNMENT * result.forceRise.norm()) {
+            ROS_WARN("Probe point %zu: force rise (%.1f, %.1f, %.1f) N is not against the approach, skipped.", i,
+                     result.forceRise[0], result.forceRise[1], result.forceRise[2]);
+        } else if (result.contact) {
+            contacts.push_back(result.position);
+            forces.push_back(result.forceRise);
+        } else {
+            ROS_WARN("Probe point %zu: no contact within %.3f m.", i, req.max_distance);
+        }
+    }
+    res.contacts = contacts.size();
+
+    PlaneFit fit;
+    if (!fitPlane(contacts, -approach, PROBE_MIN_SPREAD, fit)) {
+        res.message = "fewer than 3 contacts";
+        return true;
+    }
+    for (size_t j = 0; j < 3; j++) {
+        res.normal[j] = fit.normal[j];
+    }
+    res.offset = fit.offset;
+    res.confidence = fit.confidence;
+    res.rms_residual = fit.rmsResidual;
+    res.max_residual = fit.maxResidual;
+    ROS_INFO("Probed %zu contacts in %.1f s: normal (%.3f, %.3f, %.3f), offset %.4f m, residual rms %.2f mm, max %.2f mm, confidence %.2f.",
+             contacts.size(), (ros::WallTime::now() - begin).toSec(), fit.normal[0], fit.normal[1], fit.normal[2], fit.offset,
+             fit.rmsResidual * 1000.0, fit.maxResidual * 1000.0, fit.confidence);
+
+    if (!req.path.empty()) {
+        // The fit, then one line per contact
+        std::string path = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path;
+        FILE* f = fopen(path.c_str(), "w");
+        if (f == NULL) {
+            ROS_ERROR_STREAM("Couldn't create " << path);
+        } else {
+            fprintf(f, "# normal_x, normal_y, normal_z, offset, confidence, rms_residual, max_residual\n");
+            fprintf(f, "%.9g,%.9g,%.9g,%.9g,%.6g,%.6g,%.6g\n", fit.normal[0], fit.normal[1], fit.normal[2], fit.offset,
+                    fit.confidence, fit.rmsResidual, fit.maxResidual);
+            // forces: the observer's estimate on the contact tick less its value at the start of the approach
+            fprintf(f, "# x, y, z, fx, fy, fz, residual\n");
+            for (size_t i = 0; i < contacts.size(); ++i) {
+                fprintf(f, "%.9g,%.9g,%.9g,%.6g,%.6g,%.6g,%.6g\n", contacts[i][0], contacts[i][1], contacts[i][2],
+                        forces[i][0], forces[i][1], forces[i][2], fit.residuals[i]);
+            }
+            if (fclose(f) != 0) {
+                ROS_ERROR_STREAM("Couldn't write " << path);
+            }
+        }
+    }
+
+    if (fit.confidence < PROBE_MIN_CONFIDENCE) {
+        res.message = "the contacts do not define a plane";
+        return true;
+    }
+    surface_normal = fit.normal;
+    surface_calibrated = true;
+    res.success = true;
+    res.message = "surface calibrated";
+    return true;
+}
+
+
 // Impedance cp_position controller for surface path following
 //Lets play the collected trajectory as the trajectory! We can also try collecting when not in contaact
 //and then it projects. Also, we can reshape the trajectory based on the initial point and the projection
@@ -247,35 +393,32 @@ template<size_t DOF>
 bool PlanarHybridControl<DOF>::SPFCartImpCOntroller(wam_srvs::Play::Request &req, wam_srvs::Play::Response &res){
     wam.idle(); //to disconnect hold joint torques!
     
-    surface_normal[0] = 0.0;
-    surface_normal[1] = 0.0;
-    surface_normal[2] = 1.0;
+    if (!surface_calibrated) {
+        // No calibration: the background fit once it is confident, else the table
+        cp_type normal;
+        double offset, confidence;
+        if (planeEstimator.getPlane(normal, offset, confidence) && confidence >= PLANE_MIN_CONFIDENCE) {
+            surface_normal = normal;
+            ROS_INFO("Using the running surface fit (confidence %.2f).", confidence);
+        } else {
+            surface_normal[0] = 0.0;
+            surface_normal[1] = 0.0;
+            surface_normal[2] = 1.0;
+        }
+    }
 
     //Extracting cartesian trajectory from collected trajectory.
     std::string path = "/home/wam/catkin_ws/src/wam_hybrid_control/.data/" + req.path;
-    std::ifstream inputFile(path);
-    if (!inputFile.is_open()) {
-        perror("ERROR: Couldn't open temporary file for reading!");
+    // Map the binary copy; recordings that only have the CSV are converted once.
+    TrajectoryFile trj(path + ".trj");
+    if ((!trj.isOpen() && !(convertCSVToTrajectoryFile(path, path + ".trj") && trj.open(path + ".trj"))) || trj.rows() == 0) {
+        ROS_ERROR_STREAM("Couldn't load trajectory " << path);
         return false;
     }
- 
-    std::vector<cp_sample_type> vec;
-    std::string line;
-    while (std::getline(inputFile, line)) {
-       std::istringstream iss(line);
-       cp_sample_type sample;
-       char comma;
-       iss >> sample.get<0>() >> comma >> sample.get<1>().x() >> comma >> sample.get<1>().y() >> comma >> sample.get<1>().z();
-       vec.push_back(sample);
-    }
-
-    // Extract cp_type values from vec
-    std::vector<cp_type> cp_trj;
-    for (const auto& record : vec) {
-        cp_trj.push_back(boost::get<1>(record));
-    }
+    TrajectoryFile::time_map t_trj = trj.time();
+    TrajectoryFile::position_map cp_trj = trj.positions();
 
-    initial_point = cp_trj[0]; //Initial contact point
+    initial_point = cp_trj.col(0); //Initial contact point
 
     //Impedance Control params
     cp_type KpApplied, KdApplied;
@@ -285,7 +428,6 @@ bool PlanarHybridControl<DOF>::SPFCartImpCOntroller(wam_srvs::Play::Request &req
     //Moving to initial point
     std::cout<< "Press [Enter] to move the robot to initial point."<<std::endl;
     waitForEnter();
-    std::vector<units::CartesianPosition::type> waypoints = generateCubicSplineWaypoints(wam.getToolPosition(), initial_point, 0.5);
     //std::cout<<"initial_point:"<<initial_point<<std::endl;
 
     //Impedance Control params
@@ -293,14 +435,24 @@ bool PlanarHybridControl<DOF>::SPFCartImpCOntroller(wam_srvs::Play::Request &req
     OrnKpApplied << 5.50, 5.5, 5.5;
     OrnKdApplied << 0.055, 0.055, 0.055;
 
-    CartImpController(waypoints, 1, KpApplied, KdApplied, true, OrnKpApplied, OrnKdApplied);
+    Eigen::Matrix3d Rotation;
+    Rotation << -1, 0, 0,
+                0, 1, 0,
+                0, 0, -1;
+    CartImpApproach(initial_point, 0.5, KpApplied, KdApplied, Eigen::Quaterniond(Rotation), OrnKpApplied, OrnKdApplied);
     
     cp_type projected_waypoint;
     cp_type waypoint;
     std::vector<cp_type> projected_waypoints;
-    size_t iteration_count = 0;
-    for (int i = 40; i<cp_trj.size(); i+=5) {
-        waypoint = cp_trj[i];
+    // Skip the first 0.8 s of the recording, then a waypoint every 0.1 s
+    // (by time, so decimated CSV-era recordings and full-rate logs replay alike)
+    double t_next = t_trj[0] + PLAYBACK_SKIP;
+    for (int i = 0; i<cp_trj.cols(); ++i) {
+        if (t_trj[i] < t_next) {
+            continue;
+        }
+        t_next += PLAYBACK_WAYPOINT_PERIOD;
+        waypoint = cp_trj.col(i);
 
         // Calculate the vector from the point on the plane to the given point
         cp_type PQ;
@@ -312,52 +464,56 @@ bool PlanarHybridControl<DOF>::SPFCartImpCOntroller(wam_srvs::Play::Request &req
         cp_type projection;
         projection = projectionScalar * surface_normal;      
         projected_waypoint = waypoint - projection;
-        projected_waypoints[iteration_count] = projected_waypoint;
-        iteration_count += 1;
+        projected_waypoints.push_back(projected_waypoint);
 
         /*projected_waypoint = b_rot_t * t_rot_s * S * s_rot_t * t_rot_b * waypoint*/ //Todo: check this, also check hybrid mode!
     }
 
-    CartImpController(projected_waypoints, 5, KpApplied, KdApplied, true, OrnKpApplied, OrnKdApplied); // TODO: check the orientation control in the lopp.
-
+    // Desired contact force in the surface frame (z along the normal), mapped to the base frame.
     cf_type force_des_surface; 
     force_des_surface << 0.0, 0.0, -3.0;
-    //Todo: Find rotation from surface to base, and check this.
-    //force_des_body = b_rot_t * t_rot_s * S * force_des_surface;
-    //CartImpController(projected_waypoints, 5, KpApplied, KdApplied, true, OrnKpApplied, OrnKdApplied, true, des_froce);
+    cf_type force_des = force_des_surface[2] * surface_normal.normalized();
+
+    // Follow the projected path in the tangent plane while regulating the contact force along the normal,
+    // as fast as the joint velocity/torque limits allow. A 7-DOF arm holds its posture in the null space.
+    CartImpController(projected_waypoints, 5, KpApplied, KdApplied, true, OrnKpApplied, OrnKdApplied, true, force_des, DOF > 6, true); // TODO: check the orientation control in the lopp.
 
-    
     return true;
 }
 
 template<size_t DOF>
 void PlanarHybridControl<DOF>::CartImpController(std::vector<cp_type> &Trajectory, int step, const cp_type &KpApplied, const cp_type &KdApplied,
                                                  bool orientation_control, const cp_type &OrnKpApplied, const cp_type &OrnKdApplied,
-                                                 bool ext_force, const cf_type &des_force, bool null_space){
+                                                 bool ext_force, const cf_type &des_force, bool null_space, bool time_optimal){
     //Impedance Control params
     KxSet.setValue(KpApplied);
     DxSet.setValue(KdApplied);
     OrnKxSet.setValue(OrnKpApplied);
     OrnDxSet.setValue(OrnKdApplied);
-    FeedFwdForce.setValue(des_force);
+
+    // Hybrid mode: force regulation along the surface normal instead of pressing with a position offset
+    SurfaceNormalSet.setValue(surface_normal);
+    ForceDesSet.setValue(des_force);
+    ImpControl.setForceControl(ext_force);
 
     // CONNECT TO SUMMER
     systems::forceConnect(toolforce2jt.output, torqueSum.getInput(0));
     systems::forceConnect(tt2jt_ortn_split.output, torqueSum.getInput(1));
-    if(ext_force){systems::forceConnect(toolforcefeedfwd2jt.output, torqueSum.getInput(2));}
 
-    /* tau_nullspace << (Eigen::MatrixXd::Identity(7, 7) - this->jacobian_.transpose() * jacobian_transpose_pinv) *
-                         (this->nullspace_stiffness_ * (this->q_d_nullspace_ - this->q_) - this->nullspace_damping_ * this->dq_);*/
+    // Hold the current joint configuration with whatever the tool task leaves free
+    if (null_space) {
+        nullSpacePosture.enable(wam.getJointPositions());
+    }
 
-    // SATURATE AND CONNECT TO WAM INPUT
-    systems::forceConnect(torqueSum.output, jtSat.input);        
-    systems::forceConnect(jtSat.output, wam.input); 
+    // Hold the current pose, queue the whole trajectory and let the streamer
+    // interpolate it every control tick.
+    refStreamer.hold(wam.getToolPosition(), wam.getToolOrientation());
 
-    cp_type waypoint;
-    Eigen::Quaterniond rotation_waypoint;
+    std::vector<cp_type> waypoints;
+    typename TrajectoryStreamer<DOF>::quaternion_vector rotation_waypoints;
+    Eigen::Matrix3d Rotation;
     if(orientation_control){
         // Find the desired rotation
-        Eigen::Matrix3d Rotation;
         //Rotation = computeDesiredRotationMatrix(surface_normal);
         Rotation << -1, 0, 0,
                     0, 1, 0,
@@ -366,44 +522,94 @@ void PlanarHybridControl<DOF>::CartImpController(std::vector<cp_type> &Trajector
         std::cout << "Rotation_des:" << Rotation << std::endl;
         Eigen::Quaterniond des_orn(Rotation);
         Eigen::Quaterniond cur_orn = wam.getToolOrientation();
-        std::vector<Eigen::Quaterniond> rotation_waypoints;
-        rotation_waypoints = generateQuaternionWaypoints(cur_orn, des_orn, Trajectory.size());
-        //XdSet.setValue(wam.getToolPosition());
+        std::vector<Eigen::Quaterniond> orn_waypoints = generateQuaternionWaypoints(cur_orn, des_orn, Trajectory.size());
 
         for (int i = 0; i<Trajectory.size(); i+=step) {
-            // Move to the waypoint
-            waypoint = Trajectory[i];
-            rotation_waypoint = rotation_waypoints[i];
-            //rotation_waypoint =des_orn;
-            waypoint[2] = waypoint[2] - 0.01;
-            std::cout<<i<<std::endl;
-            //std::cout<<"rotation waypoint:"<<rotation_waypoint.x()<<","<<rotation_waypoint.y()<<","<<rotation_waypoint.z()<<","<<rotation_waypoint.w()<<std::endl;
-            OrnXdSet.setValue(rotation_waypoint);
-            XdSet.setValue(waypoint);
-            btsleep(0.25);
-
-            cp_type e = (waypoint - wam.getToolPosition())/(waypoint.norm());
-
-            cp_type euler_angles = wam.getToolOrientation().toRotationMatrix().eulerAngles(2, 1, 0);
-            cp_type euler_angles_d = Rotation.eulerAngles(2, 1, 0);
-            cp_type Orne = (euler_angles_d - euler_angles);
-
-            if(e.norm() > 0.01) {std::cout<<"position error: %"<<e*100<<std::endl;}
-            if(Orne.norm() > 0.5) {std::cout << "orientation error(zyx):"<<Orne* 180.0 / M_PI<< std::endl;}
+            cp_type waypoint = Trajectory[i];
+            if(!ext_force){waypoint[2] = waypoint[2] - 0.01;}
+            waypoints.push_back(waypoint);
+            rotation_waypoints.push_back(orn_waypoints[i]);
         }
     }
     else{
-        OrnXdSet.setValue(wam.getToolOrientation());
         for (int i = 0; i<Trajectory.size(); i+=step) {
-            // Move to the waypoint
-            waypoint = Trajectory[i];
-            waypoint[2] = waypoint[2] - 0.02;
-            XdSet.setValue(waypoint);
-            btsleep(0.3);
-            cp_type e = (waypoint - wam.getToolPosition())/(waypoint.norm());
-            if(abs(e.norm()) > 0.01) {std::cout<<"position error: %"<<e*100<<std::endl;}
+            cp_type waypoint = Trajectory[i];
+            if(!ext_force){waypoint[2] = waypoint[2] - 0.02;}
+            waypoints.push_back(waypoint);
+        }
+    }
+    // Time-optimal knot timing from the current configuration, or a constant speed.
+    std::vector<double> knot_dt;
+    bool queued;
+    if (time_optimal && timeScaling.compute(wam.getJointPositions(), wam.getToolPosition(), waypoints, knot_dt)) {
+        double duration = 0.0;
+        for (size_t i = 0; i < knot_dt.size(); ++i) {
+            duration += knot_dt[i];
+        }
+        ROS_INFO("CartImpController: time-optimal replay of %zu waypoints in %.2f s.", waypoints.size(), duration);
+        queued = !waypoints.empty() && refStreamer.enqueue(waypoints, rotation_waypoints, knot_dt);
+    } else {
+        if (time_optimal) {
+            ROS_WARN("CartImpController: path not followable in joint space, replaying at %.3f m/s.", SPEED);
         }
+        queued = !waypoints.empty() && refStreamer.enqueue(waypoints, rotation_waypoints, SPEED);
+    }
+    if (!queued) {
+        ROS_WARN("CartImpController: could not queue %zu waypoints.", waypoints.size());
+        nullSpacePosture.disable();
+        return;
     }
+
+    // SATURATE AND CONNECT TO WAM INPUT
+    systems::forceConnect(torqueSum.output, jtSat.input);        
+    systems::forceConnect(jtSat.output, wam.input); 
+
+    refStreamer.waitForCompletion();
+
+    cp_type e = (waypoints.back() - wam.getToolPosition())/(waypoints.back().norm());
+    if(e.norm() > 0.01) {std::cout<<"position error: %"<<e*100<<std::endl;}
+    if(orientation_control){
+        cp_type euler_angles = wam.getToolOrientation().toRotationMatrix().eulerAngles(2, 1, 0);
+        cp_type euler_angles_d = Rotation.eulerAngles(2, 1, 0);
+        cp_type Orne = (euler_angles_d - euler_angles);
+        if(Orne.norm() > 0.5) {std::cout << "orientation error(zyx):"<<Orne* 180.0 / M_PI<< std::endl;}
+    }
+    systems::disconnect(torqueSum.output);
+    ImpControl.setForceControl(false);
+    nullSpacePosture.disable();
+}
+
+// Impedance-controlled move along CubicBezier::between(tool, target, offset),
+// sampled by refStreamer every tick while the orientation turns to orn.
+template<size_t DOF>
+void PlanarHybridControl<DOF>::CartImpApproach(const cp_type &target, double offset, const cp_type &KpApplied, const cp_type &KdApplied,
+                                               const Eigen::Quaterniond &orn, const cp_type &OrnKpApplied, const cp_type &OrnKdApplied){
+    //Impedance Control params
+    KxSet.setValue(KpApplied);
+    DxSet.setValue(KdApplied);
+    OrnKxSet.setValue(OrnKpApplied);
+    OrnDxSet.setValue(OrnKdApplied);
+    ImpControl.setForceControl(false);
+
+    // CONNECT TO SUMMER
+    systems::forceConnect(toolforce2jt.output, torqueSum.getInput(0));
+    systems::forceConnect(tt2jt_ortn_split.output, torqueSum.getInput(1));
+
+    const cp_type start = wam.getToolPosition();
+    refStreamer.hold(start, wam.getToolOrientation());
+    if (!refStreamer.enqueue(CubicBezier::between(start, target, offset), orn, SPEED)) {
+        ROS_WARN("CartImpApproach: could not start the approach.");
+        return;
+    }
+
+    // SATURATE AND CONNECT TO WAM INPUT
+    systems::forceConnect(torqueSum.output, jtSat.input);
+    systems::forceConnect(jtSat.output, wam.input);
+
+    refStreamer.waitForCompletion();
+
+    cp_type e = (target - wam.getToolPosition())/(target.norm());
+    if(e.norm() > 0.01) {std::cout<<"position error: %"<<e*100<<std::endl;}
     systems::disconnect(torqueSum.output);
 }
 
@@ -466,69 +672,6 @@ std::vector<Eigen::Quaterniond> PlanarHybridControl<DOF>::generateQuaternionWayp
         return waypoints;
 }
 
-// Function to generate waypoints along a Cubic Bezier curve and move to them
-template <size_t DOF>
-std::vector<units::CartesianPosition::type> PlanarHybridControl<DOF>::generateCubicSplineWaypoints(
-    const units::CartesianPosition::type& initialPos,
-    const units::CartesianPosition::type& finalPos,
-    double offset
-) {
-    BARRETT_UNITS_TEMPLATE_TYPEDEFS(DOF);
-    std::vector<units::CartesianPosition::type> waypoints;
-
-    Eigen::Vector3d deltaPos = finalPos - initialPos;
-    double totalDistance = deltaPos.norm();
-
-    // Calculate intermediate positions by offsetting x, y, and z
-    Eigen::Vector3d yeeb = initialPos + deltaPos * offset;
-    Eigen::Vector3d goalb = finalPos - deltaPos * offset;
-
-    // Bezier interpolation
-    int numPop = 100;
-    std::vector<Eigen::Vector3d> plPop;
-    for (int i = 0; i < numPop; ++i) {
-        double t = static_cast<double>(i) / (numPop - 1);
-        Eigen::Vector3d pl = (1 - t) * (1 - t) * (1 - t) * initialPos +
-                             3 * (1 - t) * (1 - t) * t * yeeb +
-                             3 * (1 - t) * t * t * goalb +
-                             t * t * t * finalPos;
-        plPop.push_back(pl);
-    }
-
-    // Calculate the subset of points to sample
-    int steps = 20;
-    double squish = 2.0;
-    std::vector<double> midArr;
-    for (double t = -squish; t <= squish; t += squish / (steps - 1)) {
-        midArr.push_back(static_cast<double>(numPop) / (1 + std::exp(-t)));
-    }
-
-    double minMidArr = *std::min_element(midArr.begin(), midArr.end());
-    double maxMidArr = *std::max_element(midArr.begin(), midArr.end());
-    double m = (numPop - 1) / (maxMidArr - minMidArr);
-
-    std::vector<int> iArr;
-    for (double t : midArr) {
-        int index = static_cast<int>(m * (t - minMidArr));
-        iArr.push_back(index);
-    }
-
-    iArr[0] = 0;
-    iArr.back() = numPop - 1;
-
-    // List of points as a sample of bezier
-    std::vector<units::CartesianPosition::type> pl;
-    for (int index : iArr) {
-        pl.push_back(cp_type(plPop[index]));
-    }
-
-    for (const auto& waypoint : pl) {
-        waypoints.push_back(waypoint);
-    }
-
-    return waypoints;
-}
-
 
 
 template<size_t DOF>
@@ -600,38 +743,188 @@ bool PlanarHybridControl<DOF>::jointMoveBlockCallback(wam_srvs::JointMoveBlock::
     return true;
 }
 
+// Impedance control holding the current tool pose through refStreamer, with the
+// gains of the guarded moves. refStreamer.enqueue() then moves the tool.
+template<size_t DOF>
+void PlanarHybridControl<DOF>::holdToolPose()
+{
+    //Impedance Control params
+    cp_type KpApplied, KdApplied, OrnKpApplied, OrnKdApplied;
+    KpApplied << 1200, 1200, 1200;
+    KdApplied << 30, 30, 30;
+    OrnKpApplied << 5.50, 5.5, 5.5;
+    OrnKdApplied << 0.055, 0.055, 0.055;
+    KxSet.setValue(KpApplied);
+    DxSet.setValue(KdApplied);
+    OrnKxSet.setValue(OrnKpApplied);
+    OrnDxSet.setValue(OrnKdApplied);
+    ImpControl.setForceControl(false);
+
+    refStreamer.hold(wam.getToolPosition(), wam.getToolOrientation());
+    systems::forceConnect(refStreamer.positionOutput, ImpControl.XdInput);
+
+    if (DOF > 6) {
+        nullSpacePosture.enable(wam.getJointPositions());
+    }
+    systems::forceConnect(toolforce2jt.output, torqueSum.getInput(0));
+    systems::forceConnect(tt2jt_ortn_split.output, torqueSum.getInput(1));
+    systems::forceConnect(torqueSum.output, jtSat.input);
+    systems::forceConnect(jtSat.output, wam.input);
+    systems_connected = true;
+}
+
+// Guarded Cartesian move under impedance control, see guarded_move.h. Blocks until
+// the tool is holding (or has backed off from) the contact, or the approach is over;
+// the arm then keeps holding the final setpoint through refStreamer.
+template<size_t DOF>
+bool PlanarHybridControl<DOF>::runGuardedMove(const cp_type& direction, double speed, double max_distance, double force_threshold,
+                                              bool retract, double retract_distance, typename GuardedMove<DOF>::Result& result)
+{
+    if (speed > GUARDED_MOVE_MAX_SPEED) {
+        ROS_WARN("Guarded move: %.3f m/s is faster than %.3f m/s.", speed, GUARDED_MOVE_MAX_SPEED);
+        return false;
+    }
+
+    // The streamer keeps the orientation reference; guardedMove takes over Xd
+    holdToolPose();
+    const Eigen::Quaterniond orn = wam.getToolOrientation();
+    {
+        // Start the approach and hand Xd to it on the same tick
+        BARRETT_SCOPED_LOCK(mypm->getExecutionManager()->getMutex());
+        if (!guardedMove.start(wam.getToolPosition(), direction, speed, max_distance, force_threshold, retract, retract_distance)) {
+            ROS_WARN("Guarded move: invalid direction, speed, distance or force threshold.");
+            return false;
+        }
+        systems::forceConnect(guardedMove.positionOutput, ImpControl.XdInput);
+    }
+
+    const double timeout = (max_distance + (retract ? retract_distance : 0.0)) / speed + GUARDED_MOVE_TIMEOUT_MARGIN;
+    const bool done = guardedMove.waitForCompletion(timeout);
+    if (!done) {
+        guardedMove.cancel();
+        ROS_WARN("Guarded move: timed out after %.1f s.", timeout);
+    }
+
+    {
+        // Hand the final setpoint back to the streamer on the same tick
+        BARRETT_SCOPED_LOCK(mypm->getExecutionManager()->getMutex());
+        refStreamer.hold(guardedMove.currentSetpoint(), orn);
+        systems::forceConnect(refStreamer.positionOutput, ImpControl.XdInput);
+    }
+    result = guardedMove.getResult();
+    return done;
+}
+
+template<size_t DOF>
+bool PlanarHybridControl<DOF>::guardedMoveCallback(wam_spf_control::GuardedMove::Request &req, wam_spf_control::GuardedMove::Response &res)
+{
+    cp_type direction(req.direction[0], req.direction[1], req.direction[2]);
+    typename GuardedMove<DOF>::Result result;
+    ROS_INFO("Guarded move along (%.2f, %.2f, %.2f) at %.3f m/s.", direction[0], direction[1], direction[2], req.speed);
+    if (!runGuardedMove(direction, req.speed, req.max_distance, req.force_threshold, req.retract, req.retract_distance, result)) {
+        res.contact = false;
+        res.message = "guarded move failed";
+        return true;
+    }
+
+    res.contact = result.contact;
+    for (size_t j = 0; j < 3; j++) {
+        res.contact_position[j] = result.contact ? result.position[j] : 0.0;
+        res.contact_force[j] = result.contact ? result.force[j] : 0.0;
+    }
+    res.distance = result.distance;
+    res.time = result.ticks * guardedMove.period();
+    if (result.contact) {
+        res.message = req.retract ? "contact, retracted" : "contact, holding";
+        ROS_INFO("Guarded move: contact after %.4f m (%.1f N).", result.distance, result.force.norm());
+    } else {
+        res.message = "no contact within max_distance";
+        ROS_INFO("Guarded move: no contact within %.3f m.", req.max_distance);
+    }
+    return true;
+}
+
+//operate() timing summary, see operate_timing.h
+template<size_t DOF>
+bool PlanarHybridControl<DOF>::operateTimingCallback(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
+{
+    res.message = operateTimingReport();
+    res.success = true;
+    return true;
+}
+
+template<size_t DOF>
+bool PlanarHybridControl<DOF>::resetOperateTimingCallback(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res)
+{
+    graphTimer.reset();
+    return true;
+}
+
+template<size_t DOF>
+void PlanarHybridControl<DOF>::publishOperateTiming(const ros::TimerEvent& event)
+{
+    operate_timing_msg.data = operateTimingReport();
+    operate_timing_pub.publish(operate_timing_msg);
+}
+
+//Running surface fit to /wam/surface_plane
+template<size_t DOF>
+void PlanarHybridControl<DOF>::publishSurfacePlane(const ros::TimerEvent& event)
+{
+    cp_type normal;
+    double offset, confidence;
+    surface_plane_msg.header.stamp = ros::Time::now();
+    surface_plane_msg.valid = planeEstimator.getPlane(normal, offset, confidence);
+    if (surface_plane_msg.valid) {
+        for (size_t j = 0; j < 3; j++) {
+            surface_plane_msg.normal[j] = normal[j];
+        }
+        surface_plane_msg.offset = offset;
+        surface_plane_msg.confidence = confidence;
+    } else {
+        surface_plane_msg.confidence = 0.0;
+    }
+    surface_plane_pub.publish(surface_plane_msg);
+}
+
+//graphTimer's table and the force trace's record counts
+template<size_t DOF>
+std::string PlanarHybridControl<DOF>::operateTimingReport()
+{
+    char line[128];
+    snprintf(line, sizeof(line), "force trace: %llu written, %llu dropped\n",
+             static_cast<unsigned long long>(forceTrace.writtenRecords()), static_cast<unsigned long long>(forceTrace.droppedRecords()));
+    return graphTimer.report() + line;
+}
+
 //Function to update the WAM publisher
 template<size_t DOF>
 void PlanarHybridControl<DOF>::publishWam(ProductManager& pm)
-{   //Current values to be published
-    jp_type jp = wam.getJointPositions();
-    jt_type jt = wam.getJointTorques();
-    jv_type jv = wam.getJointVelocities();
-    cp_type cp_pub = wam.getToolPosition();
-    Eigen::Quaterniond to_pub = wam.getToolOrientation();
-    math::Matrix<6,DOF> robot_tool_jacobian=wam.getToolJacobian();
-
-    cv_type cv_pub = wam.getToolVelocity();
-    cv_type cv_ang = wam.getToolAngularVelocity();
+{   //Current values to be published, all from the same control tick
+    const typename StateSnapshot<DOF>::state_type& state = stateSnapshot.latest();
+    if (state.tick == 0) {
+        return; // nothing sampled yet
+    }
+    const ros::Time stamp = ros::Time::now();
 
     //publishing sensor_msgs/JointState to wam/joint_states
     for (size_t i = 0; i < DOF; i++) {
-        wam_joint_state.position[i] = jp[i];
-        wam_joint_state.velocity[i] = jv[i];
-        wam_joint_state.effort[i] = jt[i];
+        wam_joint_state.position[i] = state.jp[i];
+        wam_joint_state.velocity[i] = state.jv[i];
+        wam_joint_state.effort[i] = state.jt[i];
     }
-    wam_joint_state.header.stamp = ros::Time::now();
+    wam_joint_state.header.stamp = stamp;
     wam_joint_state_pub.publish(wam_joint_state);
 
     //publishing geometry_msgs/PoseStamed to wam/pose
-    wam_pose.header.stamp = ros::Time::now();
-    wam_pose.pose.position.x = cp_pub[0];
-    wam_pose.pose.position.y = cp_pub[1];
-    wam_pose.pose.position.z = cp_pub[2];
-    wam_pose.pose.orientation.w = to_pub.w();
-    wam_pose.pose.orientation.x = to_pub.x();
-    wam_pose.pose.orientation.y = to_pub.y();
-    wam_pose.pose.orientation.z = to_pub.z();
+    wam_pose.header.stamp = stamp;
+    wam_pose.pose.position.x = state.cp[0];
+    wam_pose.pose.position.y = state.cp[1];
+    wam_pose.pose.position.z = state.cp[2];
+    wam_pose.pose.orientation.w = state.orn.w();
+    wam_pose.pose.orientation.x = state.orn.x();
+    wam_pose.pose.orientation.y = state.orn.y();
+    wam_pose.pose.orientation.z = state.orn.z();
     wam_pose_pub.publish(wam_pose);
 
     //publishing wam_msgs/MatrixMN to wam/jacobian
@@ -639,26 +932,25 @@ void PlanarHybridControl<DOF>::publishWam(ProductManager& pm)
     wam_jacobian_mn.n = DOF;
     for (size_t h = 0; h < wam_jacobian_mn.n; ++h) {
         for (size_t k = 0; k < wam_jacobian_mn.m; ++k) {
-            wam_jacobian_mn.data[h*6+k]=robot_tool_jacobian(k,h);
+            wam_jacobian_mn.data[h*6+k]=state.J(k,h);
         }
     }
     wam_jacobian_mn_pub.publish(wam_jacobian_mn);
 
     //publish tool info to /wam/tool_info
     for (size_t j = 0; j < 3; j++) {
-        wam_tool_info.position[j] = cp_pub[j];
-        wam_tool_info.velocity[j] = cv_pub[j];
+        wam_tool_info.position[j] = state.cp[j];
+        wam_tool_info.velocity[j] = state.cv[j];
     }
     wam_tool_pub.publish(wam_tool_info);
 
-    //publish static force estimation to /wam/static_estimated_force
-    force_msg.force[0] = staticForceEstimator.computedF[0];
-    force_msg.force[1] = staticForceEstimator.computedF[1];
-    force_msg.force[2] = staticForceEstimator.computedF[2];
-    force_msg.force_norm = staticForceEstimator.computedF.norm(); //N in base frame
-    if(staticForceEstimator.computedF.norm() > 14.0){ROS_INFO("Contact detected.");} 
-    if(staticForceEstimator.computedF.norm() > 0.0){
-        force_norm = staticForceEstimator.computedF;
+    //publish the momentum observer's force estimate to /wam/estimated_force
+    force_msg.force[0] = state.cf[0];
+    force_msg.force[1] = state.cf[1];
+    force_msg.force[2] = state.cf[2];
+    force_msg.force_norm = state.cf.norm(); //N in base frame
+    if(state.cf.norm() > 0.0){
+        force_norm = state.cf;
         force_norm.normalize();
         force_msg.force_dir[0] = force_norm[0];
         force_msg.force_dir[1] = force_norm[1];
@@ -666,6 +958,21 @@ void PlanarHybridControl<DOF>::publishWam(ProductManager& pm)
     }
     wam_estimated_contact_force_pub.publish(force_msg);
 
+    //publish contact make/break events to /wam/contact_events, stamped with the tick they started on
+    ContactEvent event;
+    while (contactDetector.popEvent(event)) {
+        const double age = (contactDetector.currentTick() - event.onsetTick) * contactDetector.period();
+        contact_event_msg.header.stamp = ros::Time::now() - ros::Duration(age);
+        contact_event_msg.contact = event.contact;
+        contact_event_msg.onset_tick = event.onsetTick;
+        contact_event_msg.confirm_tick = event.confirmTick;
+        for (size_t j = 0; j < 3; j++) {
+            contact_event_msg.force[j] = event.force[j];
+        }
+        contact_event_msg.force_rate = event.forceRate;
+        contact_event_pub.publish(contact_event_msg);
+        ROS_INFO("Contact %s (%.1f N).", event.contact ? "detected" : "lost", event.force.norm());
+    }
 }
 
 /*template<size_t DOF>
@@ -796,15 +1103,10 @@ bool PlanarHybridControl<DOF>::grid_test(wam_srvs::GridTest::Request &req, wam_s
     cp_cmd[2] = -0.274203; //-0.2751059795701481;// 0.3%
 
 
-    std::vector<units::CartesianPosition::type> waypoints = generateCubicSplineWaypoints(wam.getToolPosition(), cp_cmd, 0.0);
-
-    for (const auto& waypoint : waypoints) {
-        // Move to the waypoint
-        wam.moveTo(waypoint);
-        btsleep(0.5);
-        cp_type e = (waypoint - wam.getToolPosition())/(waypoint.norm());
-        if(e.norm() > 0.02) {std::cout<<e<<std::endl;}   
-    }
+    cp_type KpApplied, KdApplied;
+    KpApplied << 1200, 1200, 1200;
+    KdApplied << 30, 30, 30;
+    CartImpApproach(cp_cmd, 0.0, KpApplied, KdApplied, wam.getToolOrientation(), cp_type(0.0), cp_type(0.0));
 
     return true;
 
@@ -0,0 +1,93 @@
+/*
+ * trajectory_converter.cpp
+ *
+ * Converts recorded CSV trajectories/calibration logs (e.g. .data/trj1.txt,
+ * .data/calib1.txt) to the binary format in trajectory_file.h, and binary
+ * logs back to CSV for reading.
+ *
+ * Usage: trajectory_converter <input.csv> [output]
+ *        trajectory_converter <input.trj> [output.csv]
+ * A CSV input is converted to <input.csv>.trj by default, which is where the
+ * services look for it. A .trj input (e.g. a log written by ColumnarLogger)
+ * is exported to <input> without the .trj by default, with the schema
+ * column names as the first line.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <wam_control_common/trajectory_file.h>
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static int exportCSV(const std::string& in, const std::string& out) {
+	TrajectoryFile trj(in);
+	if ( !trj.isOpen()) {
+		printf("ERROR: Couldn't read %s\n", in.c_str());
+		return 1;
+	}
+	FILE* f = fopen(out.c_str(), "w");
+	if (f == NULL) {
+		printf("ERROR: Couldn't create %s\n", out.c_str());
+		return 1;
+	}
+
+	if (trj.columnCount() > 0) {
+		fprintf(f, "#");
+		for (size_t c = 0; c < trj.columnCount(); ++c) {
+			for (size_t k = 0; k < trj.columnWidth(c); ++k) {
+				if (trj.columnWidth(c) == 1) {
+					fprintf(f, "%s%s", c == 0 ? " " : ", ", trj.columnName(c));
+				} else {
+					fprintf(f, "%s%s[%zu]", (c == 0 && k == 0) ? " " : ", ", trj.columnName(c), k);
+				}
+			}
+		}
+		fprintf(f, "\n");
+	}
+
+	// All columns as one cols x rows map
+	TrajectoryFile::joint_map records(trj.time().data(), trj.cols(), trj.rows(), Eigen::OuterStride<>(trj.cols()));
+	for (size_t r = 0; r < trj.rows(); ++r) {
+		for (size_t c = 0; c < trj.cols(); ++c) {
+			fprintf(f, c == 0 ? "%.17g" : ",%.17g", records(c, r));
+		}
+		fprintf(f, "\n");
+	}
+	const bool ok = (fclose(f) == 0);
+	if ( !ok) {
+		printf("ERROR: Couldn't write %s\n", out.c_str());
+		return 1;
+	}
+	printf("%s: %zu records, %zu fields each\n", out.c_str(), trj.rows(), trj.cols());
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2 || argc > 3) {
+		printf("Usage: %s <input.csv> [output]\n", argv[0]);
+		printf("       %s <input.trj> [output.csv]\n", argv[0]);
+		return 1;
+	}
+
+	std::string in = argv[1];
+	if (endsWith(in, ".trj")) {
+		return exportCSV(in, (argc == 3) ? argv[2] : in.substr(0, in.size() - 4));
+	}
+
+	std::string out = (argc == 3) ? argv[2] : in + ".trj";
+	if ( !convertCSVToTrajectoryFile(in, out)) {
+		printf("ERROR: Couldn't convert %s\n", in.c_str());
+		return 1;
+	}
+
+	TrajectoryFile trj(out);
+	if ( !trj.isOpen()) {
+		printf("ERROR: Couldn't read back %s\n", out.c_str());
+		return 1;
+	}
+	printf("%s: %zu records, %zu fields each\n", out.c_str(), trj.rows(), trj.cols());
+	return 0;
+}
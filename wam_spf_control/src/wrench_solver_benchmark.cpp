@@ -0,0 +1,90 @@
+/*
+ * wrench_solver_benchmark.cpp
+ *
+ * Per-tick cost of WrenchSolver (static_force_estimator_withg.h), the J^T w = jt
+ * solve StaticForceEstimatorwithG runs every control tick, without hardware:
+ *
+ *   wrench_solver_benchmark [ticks=100000]
+ *
+ * For DOF = 4 and DOF = 7 it solves a fixed set of random, full-rank
+ * Jacobians in a loop, counting global operator new calls over the timed
+ * ticks. Prints ns/tick and allocations/tick for each; exits non-zero if a
+ * tick allocated or a solve missed its joint torques.
+ */
+
+
+#include <wam_control_common/static_force_estimator_withg.h>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <vector>
+#include <barrett/os.h>
+
+using namespace barrett;
+
+static size_t allocations = 0;	// global operator new calls so far
+
+void* operator new(std::size_t size) {
+	++allocations;
+	void* p = std::malloc(size == 0 ? 1 : size);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+
+static const size_t JACOBIANS = 64;	// distinct random poses, cycled through
+static const double RESIDUAL_LIMIT = 1e-9;	// [Nm] of J^T w - jt for a consistent jt
+
+template<size_t DOF>
+bool run(size_t ticks) {
+	typedef WrenchSolver<DOF> solver_type;
+	typedef Eigen::Matrix<double, 6, DOF> jacobian_type;
+
+	// jt = J^T w, so every solve has a zero residual (4-DOF: J^T has full row rank anyway)
+	std::vector<jacobian_type, Eigen::aligned_allocator<jacobian_type> > J(JACOBIANS);
+	std::vector<typename solver_type::joint_vector_type, Eigen::aligned_allocator<typename solver_type::joint_vector_type> > jt(JACOBIANS);
+	srand(1);
+	for (size_t i = 0; i < JACOBIANS; ++i) {
+		J[i].setRandom();
+		typename solver_type::wrench_type w;
+		w.setRandom();
+		jt[i] = J[i].transpose() * w;
+	}
+
+	solver_type solver;
+	solver.solve(J[0], jt[0]);	// warm up
+
+	double worstResidual = 0.0;
+	const size_t allocationsBefore = allocations;
+	const double start = highResolutionSystemTime();
+	for (size_t i = 0; i < ticks; ++i) {
+		const size_t k = i % JACOBIANS;
+		const typename solver_type::wrench_type& w = solver.solve(J[k], jt[k]);
+		if (k == 0) {
+			worstResidual = std::max(worstResidual, (J[k].transpose() * w - jt[k]).cwiseAbs().maxCoeff());
+		}
+	}
+	const double wall = highResolutionSystemTime() - start;
+	const size_t allocated = allocations - allocationsBefore;
+
+	printf("%zu-DOF: %zu ticks, %.1f ns/tick, %.3f allocations/tick, worst residual %.2e Nm\n", DOF, ticks,
+			1e9 * wall / ticks, static_cast<double>(allocated) / ticks, worstResidual);
+	return allocated == 0 && worstResidual <= RESIDUAL_LIMIT;
+}
+
+int main(int argc, char** argv) {
+	const long ticks = argc > 1 ? atol(argv[1]) : 100000;
+	if (ticks <= 0) {
+		printf("ticks must be positive\n");
+		return 2;
+	}
+
+	const bool ok4 = run<4>(ticks);
+	const bool ok7 = run<7>(ticks);
+	return (ok4 && ok7) ? 0 : 1;
+}